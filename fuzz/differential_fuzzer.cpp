@@ -0,0 +1,149 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <fuzzer/FuzzedDataProvider.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include "throughput.h"
+#include "../src/analyzer/analyzer.h"
+#include "../src/lexer/lexer.h"
+#include "../src/parser/source.h"
+#include "../src/runtime/lynxrt.h"
+#include "../src/vm/compiler.h"
+#include "../src/vm/jit.h"
+#include "../src/vm/vm.h"
+
+// the front end is checked against a straightforward reference, currently the incremental
+// SourceFile against lexing and parsing the edited text from scratch, a rewritten lexer
+// or parser plugs in the same way by comparing its tokens and Root::str() output;
+// programs that analyze are run by the interpreter alone and with the JIT tier, both have to agree.
+// programs that never terminate are reported as timeouts, run with -timeout=N
+
+extern "C" int LLVMFuzzerInitialize(int *, char ***) {
+    wyvern::DO_NOT_LOAD = true;
+    wyvern::Wrapper::initialize();
+
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+    return 0;
+}
+
+static void compare(const char *what, const std::string &reference, const std::string &candidate, const std::string &input) {
+    if (reference == candidate)
+        return;
+
+    std::cerr << what << " differs for input:\n" << input
+              << "\n--- reference\n" << reference << "\n--- candidate\n" << candidate << '\n';
+    std::abort();
+}
+
+static std::string dump(const Token::Vec &tokens) {
+    std::string result;
+
+    for (const Token &token : tokens)
+        result += token.str() + '\n';
+
+    return result;
+}
+
+static Location locationOf(const std::string &text, size_t offset) {
+    Location location = {1, 1};
+
+    for (size_t i = 0; i < offset; ++i)
+        if (text[i] == '\n') {
+            ++location.line;
+            location.column = 1;
+        } else
+            ++location.column;
+
+    return location;
+}
+
+struct Run {
+    bool trapped;
+    int64_t result;
+    std::string output;
+};
+
+// lynxrt writes to the file descriptor directly, the output is collected in a temporary file
+static Run run(const Root::Ptr &root, bool jit) {
+    const Program::Ptr program = compileBytecode(*root);
+    VM vm(program);
+    JIT compiler(root, program, "fuzz", 2);
+    if (jit) // every jittable function is compiled on its first call
+        vm.setTier([&compiler](const BytecodeFunction &function) { return compiler.compile(function); }, 1);
+
+    std::FILE *file = std::tmpfile();
+    const int out = dup(STDOUT_FILENO);
+    dup2(fileno(file), STDOUT_FILENO);
+
+    Run result = {false, 0, ""};
+    try {
+        result.result = vm.run();
+    } catch (const Trap &) {
+        result.trapped = true;
+    }
+    lynx_flush();
+
+    dup2(out, STDOUT_FILENO);
+    close(out);
+
+    std::rewind(file);
+    for (int c; (c = std::fgetc(file)) != EOF;)
+        result.output += static_cast<char>(c);
+    std::fclose(file);
+
+    return result;
+}
+
+static void compareTiers(const SourceFile &file) {
+    if (file.getDiagnostics()->hasErrors())
+        return;
+
+    const Root::Ptr &root = file.getRoot();
+    try {
+        std::make_shared<Analyzer>(root, 1)->analyze();
+        compileBytecode(*root); // the interpreter doesn't support everything the compiler does
+    } catch (const std::invalid_argument &) {
+        return;
+    }
+
+    // compiled code traps with an illegal instruction where the interpreter throws, only programs that run to the end compare
+    const Run interpreted = run(root, false);
+    if (interpreted.trapped)
+        return;
+
+    const Run compiled = run(root, true);
+    compare("output", interpreted.output, compiled.output, file.getText());
+    compare("result", std::to_string(interpreted.result), std::to_string(compiled.result), file.getText());
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    Throughput::get().record();
+
+    FuzzedDataProvider provider(data, size);
+    std::string text = provider.ConsumeRandomLengthString();
+    const std::string replacement = provider.ConsumeRandomLengthString();
+    const size_t from = provider.ConsumeIntegralInRange<size_t>(0, text.size());
+    const size_t to = provider.ConsumeIntegralInRange<size_t>(from, text.size());
+
+    SourceFile candidate(text);
+    candidate.apply({locationOf(text, from), locationOf(text, to), replacement});
+
+    text.replace(from, to - from, replacement);
+    const SourceFile reference(text);
+
+    compare("text", reference.getText(), candidate.getText(), text);
+    compare("tokens", dump(reference.getTokens()), dump(candidate.getTokens()), text);
+    compare("errors", std::to_string(reference.getDiagnostics()->getErrorCount()),
+        std::to_string(candidate.getDiagnostics()->getErrorCount()), text);
+    compare("tree", reference.getRoot()->str(), candidate.getRoot()->str(), text);
+
+    compareTiers(reference);
+
+    return 0;
+}
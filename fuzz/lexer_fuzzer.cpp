@@ -0,0 +1,19 @@
+#include <cstdint>
+#include <string>
+
+#include "throughput.h"
+#include "../src/lexer/lexer.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    Throughput::get().record();
+
+    const std::string source(reinterpret_cast<const char *>(data), size);
+    const Token::Vec tokens = Lexer(source).lex();
+
+    // positions have to stay within their line
+    for (const Token &token : tokens)
+        if (token.getStart() == 0 || token.getEnd() < token.getStart())
+            __builtin_trap();
+
+    return 0;
+}
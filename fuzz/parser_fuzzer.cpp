@@ -0,0 +1,23 @@
+#include <cstdint>
+#include <string>
+
+#include "throughput.h"
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    Throughput::get().record();
+
+    const std::string source(reinterpret_cast<const char *>(data), size);
+    Parser parser(Lexer(source).lex());
+    const Root::Ptr root = parser.parse();
+
+    // every statement, including the ones that failed to parse, has to print
+    (void) root->str();
+
+    // failed statements always come with an error
+    if (!parser.getDiagnostics()->hasErrors() && root->str().find("<error>") != std::string::npos)
+        __builtin_trap();
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// counts the executions of a fuzz target and reports executions per second every few seconds and at exit,
+// to stderr or appended to the file named by LYNX_FUZZ_STATS as "<seconds> <executions> <exec/s>"
+class Throughput {
+public:
+    static Throughput &get() {
+        static Throughput throughput;
+        return throughput;
+    }
+
+    void record() {
+        ++executions;
+
+        // checking the clock on every execution would cost more than small inputs take
+        if ((executions & 0xff) == 0 && Clock::now() - last >= INTERVAL)
+            report();
+    }
+
+    ~Throughput() { report(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr auto INTERVAL = std::chrono::seconds(10);
+
+    Throughput() : start(Clock::now()), last(start), executions(0), reported(0) {}
+
+    void report() {
+        const Clock::time_point now = Clock::now();
+        const double total = std::chrono::duration<double>(now - start).count();
+        const double window = std::chrono::duration<double>(now - last).count();
+        const double rate = window > 0 ? static_cast<double>(executions - reported) / window : 0;
+
+        if (const char *path = std::getenv("LYNX_FUZZ_STATS")) {
+            if (FILE *file = std::fopen(path, "a")) {
+                std::fprintf(file, "%.1f %llu %.0f\n", total, executions, rate);
+                std::fclose(file);
+            }
+        } else
+            std::fprintf(stderr, "lynx: %llu executions in %.1fs, %.0f exec/s\n", executions, total, rate);
+
+        last = now;
+        reported = executions;
+    }
+
+    Clock::time_point start, last;
+    unsigned long long executions, reported;
+};
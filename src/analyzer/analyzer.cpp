@@ -1,37 +1,192 @@
 #include "analyzer.h"
 
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
 #include <ranges>
+#include <thread>
 
-Analyzer::Analyzer(Root::Ptr root) : root(std::move(root)) {}
+#include "function.h"
+#include "prelude.h"
+#include "visitor.h"
+
+Analyzer::Analyzer(Root::Ptr root, unsigned jobs)
+: root(std::move(root)), jobs(jobs ? jobs : std::max(1u, std::thread::hardware_concurrency())),
+  globals(std::make_shared<Symbol::Map>()), specializations(std::make_shared<Specializations>()) {}
+
+Analyzer::Analyzer(const Analyzer &parent, WorkerTag)
+: root(nullptr), jobs(1), globals(std::make_shared<Symbol::Map>()), shared(parent.shared ? parent.shared : parent.globals),
+  importPaths(parent.importPaths), specializations(parent.specializations) {}
 
 Analyzer::~Analyzer() {
-    globals.clear();
+    globals->clear();
     scopes.clear();
+
+    // instances reference their workers, which share the cache
+    if (!shared)
+        clearSpecializations();
+}
+
+void Analyzer::clearSpecializations() {
+    std::vector<Analyzer::Ptr> workers;
+    {
+        const std::lock_guard lock(specializations->mutex);
+        specializations->symbols.clear();
+        workers.swap(specializations->workers);
+    }
+
+    for (const Analyzer::Ptr &worker : workers)
+        worker->clear();
+}
+
+// the language server analyzes trees kept from earlier analyses again, types cached then may be stale
+static void clearTypes(Stmt &node) {
+    if (auto *expr = dynamic_cast<Expr *>(&node))
+        expr->clearType();
+
+    forEachChild(node, clearTypes);
 }
 
 void Analyzer::analyze() {
-    root->analyze(shared_from_this());
+    const Analyzer::Ptr self = shared_from_this();
+    std::vector<Function *> functions = {};
+
+    clearTypes(*root);
+
+    declarePrelude(self);
 
-    for (const auto &[name, symbol] : globals)
-        std::cout << name << ": " << symbol->str() << '\n';
+    // functions are declared up front so bodies can call the ones defined after them
+    for (const Stmt::Ptr &stmt : root->getProgram())
+        if (stmt && stmt->kind() == AST::Function) {
+            auto &function = static_cast<Function &>(*stmt);
+            function.declare(self);
+            functions.push_back(&function);
+        } else if (stmt && stmt->kind() == AST::Generic)
+            stmt->analyze(self);
+
+    // prototypes, imports and global variables, the globals are complete afterwards
+    for (const Stmt::Ptr &stmt : root->getProgram())
+        if (stmt && stmt->kind() != AST::Function && stmt->kind() != AST::Generic)
+            stmt->analyze(self);
+
+    analyzeBodies(functions);
+
+    // after every body, a @comptime function may be defined after its callers
+    foldComptimeCalls(*root, comptimeLimits);
 }
 
-Symbol::Ptr &Analyzer::lookup(const std::string &name) {
+void Analyzer::analyzeBodies(const std::vector<Function *> &functions) {
+    const size_t threads = std::min<size_t>(jobs, functions.size());
+
+    if (threads <= 1) {
+        for (Function *function : functions)
+            function->analyzeBody(shared_from_this());
+        return;
+    }
+
+    // workers take the next function until none are left, bodies only insert into their worker's scopes
+    std::atomic<size_t> next = 0;
+    std::vector<std::exception_ptr> errors(functions.size());
+    std::vector<std::thread> workers = {};
+
+    for (size_t i = 0; i < threads; ++i)
+        workers.emplace_back([&] {
+            auto worker = std::make_shared<Analyzer>(*this, WorkerTag());
+
+            for (size_t index; (index = next++) < functions.size();)
+                try {
+                    functions[index]->analyzeBody(worker);
+                } catch (...) {
+                    errors[index] = std::current_exception();
+                    worker->scopes.clear();
+                    worker->arenas.clear();
+                    worker->currentFunction = nullptr;
+                }
+        });
+
+    for (std::thread &worker : workers)
+        worker.join();
+
+    // report the same error a sequential analysis would
+    for (const std::exception_ptr &error : errors)
+        if (error)
+            std::rethrow_exception(error);
+}
+
+void Analyzer::clear() {
+    globals->clear();
+    if (!shared)
+        clearSpecializations();
+    scopes.clear();
+    modules.clear();
+    arenas.clear();
+    currentFunction = nullptr;
+}
+
+const Symbol::Ptr &Analyzer::lookup(const std::string &name) {
     for (Symbol::Map &scope : scopes | std::views::reverse)
         if (scope.contains(name))
             return scope[name];
 
-    if (globals.contains(name))
-        return globals[name];
+    if (globals->contains(name))
+        return (*globals)[name];
+
+    if (shared)
+        if (auto it = shared->find(name); it != shared->end())
+            return it->second;
 
     throw std::invalid_argument("Symbol not found: $" + name);
 }
 
 void Analyzer::insert(const std::string &name, Symbol::Ptr symbol) {
-    std::cout << "Inserting symbol: " << symbol->str() << '\n';
-
     if (scopes.empty())
-        globals[name] = std::move(symbol);
+        (*globals)[name] = std::move(symbol);
     else
         scopes.back()[name] = std::move(symbol);
-}
\ No newline at end of file
+}
+
+FunctionSymbol::Ptr Analyzer::specialize(GenericFunction &generic, const Type::Vec &arguments) {
+    const std::lock_guard lock(specializations->mutex);
+    const auto key = std::make_pair(&generic, GenericFunction::mangle(generic.getSymbol(), arguments));
+
+    if (auto it = specializations->symbols.find(key); it != specializations->symbols.end())
+        return it->second;
+
+    // analyzed like a top-level function, on a worker so it doesn't see the scopes of the call
+    auto worker = std::make_shared<Analyzer>(*this, WorkerTag());
+    specializations->workers.push_back(worker);
+    const std::shared_ptr<Function> function = generic.instantiate(arguments);
+    function->declare(worker);
+
+    // cached before the body is analyzed, recursive calls use the same instance
+    specializations->symbols[key] = function->getDeclaration();
+
+    try {
+        function->analyzeBody(worker);
+    } catch (...) {
+        specializations->symbols.erase(key);
+        throw;
+    }
+
+    generic.addInstance(function);
+    return function->getDeclaration();
+}
+
+const Interface::Ptr &Analyzer::import(const std::string &module) {
+    if (modules.contains(module))
+        return modules[module];
+
+    // dir.module is found at dir/module.lymi
+    std::string file = module;
+    std::replace(file.begin(), file.end(), '.', '/');
+
+    const std::vector<std::string> paths = importPaths.empty() ? std::vector<std::string>{"."} : importPaths;
+
+    for (const std::string &path : paths) {
+        const std::filesystem::path candidate = std::filesystem::path(path) / (file + ".lymi");
+        if (std::filesystem::exists(candidate))
+            return modules[module] = Interface::read(candidate.string());
+    }
+
+    throw std::invalid_argument("Module interface not found: " + module + ".lymi");
+}
@@ -1,25 +1,84 @@
 #pragma once
 
+#include <mutex>
+
+#include "comptime.h"
+#include "interface.h"
 #include "symbol.h"
 #include "../ast/stmt.h"
 
+class Function;
+class GenericFunction;
+
 class Analyzer : public std::enable_shared_from_this<Analyzer> {
+    struct WorkerTag {};
+
 public:
     using Ptr = std::shared_ptr<Analyzer>;
 
-    explicit Analyzer(Root::Ptr root);
+    // jobs is the number of threads analyzing function bodies, 0 uses all cores
+    explicit Analyzer(Root::Ptr root, unsigned jobs = 1);
+    // worker for function bodies with its own scopes, reading the globals of parent
+    Analyzer(const Analyzer &parent, WorkerTag);
     ~Analyzer();
 
+    // declare every top-level symbol first, then analyze the function bodies on the workers
     void analyze();
+    // drop all symbols, they reference the analyzer and would keep it alive
+    void clear();
 
-    Symbol::Ptr &lookup(const std::string &name);
+    const Symbol::Ptr &lookup(const std::string &name);
     void insert(const std::string &name, Symbol::Ptr symbol);
 
+    // instance of a generic function for the type arguments, parsed and analyzed once per (function, type arguments)
+    // and shared by the workers, its body only sees the globals
+    FunctionSymbol::Ptr specialize(GenericFunction &generic, const Type::Vec &arguments);
+
+    // directories searched for <module>.lymi, only the working directory if empty
+    void setImportPaths(std::vector<std::string> paths) { importPaths = std::move(paths); }
+    // interface of a module, read once per analyzer
+    const Interface::Ptr &import(const std::string &module);
+
+    // bounds of the @comptime calls evaluated after the bodies are analyzed
+    void setComptimeLimits(const ComptimeLimits &limits) { comptimeLimits = limits; }
+
     constexpr void enterScope() { scopes.emplace_back(); }
     constexpr void leaveScope() { scopes.pop_back(); }
 
+    // function whose body is being analyzed
+    [[nodiscard]] const FunctionSymbol::Ptr &getCurrentFunction() const { return currentFunction; }
+    void setCurrentFunction(FunctionSymbol::Ptr function) { currentFunction = std::move(function); }
+
+    // handles of the @arena blocks around the code being analyzed, innermost last, each function body starts without any
+    [[nodiscard]] const Symbol::Vec &getArenas() const { return arenas; }
+    void setArenas(Symbol::Vec arenas) { this->arenas = std::move(arenas); }
+    void enterArena(Symbol::Ptr arena) { arenas.push_back(std::move(arena)); }
+    void leaveArena() { arenas.pop_back(); }
+
 private:
+    // recursive, instances are specialized while analyzing other instances
+    struct Specializations {
+        std::recursive_mutex mutex;
+        std::map<std::pair<const GenericFunction *, std::string>, FunctionSymbol::Ptr> symbols;
+        // the instances' symbols reference the workers that declared them, cleared to break the cycle
+        std::vector<std::shared_ptr<Analyzer>> workers;
+    };
+
+    // function bodies, in source order
+    void analyzeBodies(const std::vector<Function *> &functions);
+    // drops the instances and the workers they were analyzed on
+    void clearSpecializations();
+
     Root::Ptr root;
-    Symbol::Map globals;
+    unsigned jobs;
+    FunctionSymbol::Ptr currentFunction;
+    Symbol::Vec arenas;
+    std::shared_ptr<Symbol::Map> globals;
+    // globals of the analyzer a worker belongs to, unchanged while workers run so they are read without locks
+    std::shared_ptr<const Symbol::Map> shared;
     std::vector<Symbol::Map> scopes;
+    std::vector<std::string> importPaths;
+    ComptimeLimits comptimeLimits;
+    std::map<std::string, Interface::Ptr> modules;
+    std::shared_ptr<Specializations> specializations; // shared with the workers
 };
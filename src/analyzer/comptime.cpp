@@ -0,0 +1,535 @@
+#include "comptime.h"
+
+#include <cmath>
+#include <unordered_map>
+#include <variant>
+
+#include "visitor.h"
+
+namespace {
+
+// anything that can't be evaluated at compile time, e.g. a local of the caller, a pointer or a limit being hit
+class NotConstant : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// value during evaluation, integers of every width are kept in an int64_t and arrays are copied by value
+struct Constant {
+    std::variant<std::monostate, int64_t, double, std::string, std::vector<Constant>> value;
+};
+
+// nesting of calls, deeper recursion would exhaust the compiler's own stack first
+constexpr size_t MAX_CALL_DEPTH = 256;
+
+Type::Ptr stripReference(const Type::Ptr &type) {
+    if (type && type->isReference())
+        return std::static_pointer_cast<ReferenceType>(type)->getReferee();
+
+    return type;
+}
+
+int64_t integer(const Constant &constant) {
+    if (const auto *value = std::get_if<int64_t>(&constant.value))
+        return *value;
+
+    if (const auto *value = std::get_if<double>(&constant.value)) {
+        // out of range conversions are undefined, at runtime as well
+        if (!std::isfinite(*value) || *value < -0x1p63 || *value >= 0x1p63)
+            throw NotConstant("float " + std::to_string(*value) + " doesn't fit an integer");
+
+        return static_cast<int64_t>(*value);
+    }
+
+    throw NotConstant("expected a number");
+}
+
+double real(const Constant &constant) {
+    if (const auto *value = std::get_if<double>(&constant.value))
+        return *value;
+
+    return static_cast<double>(integer(constant));
+}
+
+bool truthy(const Constant &constant) {
+    if (const auto *value = std::get_if<double>(&constant.value))
+        return *value != 0.0;
+
+    return integer(constant) != 0;
+}
+
+// convert to the representation of type, integers wrap around to its width like they do at runtime
+Constant convert(Constant constant, const Type::Ptr &declared) {
+    const Type::Ptr type = stripReference(declared);
+    if (!type)
+        return constant;
+
+    switch (type->getKind()) {
+        case Type::BOOL:    return {int64_t(truthy(constant))};
+        case Type::U8:      return {int64_t(static_cast<uint8_t>(integer(constant)))};
+        case Type::I32:     return {int64_t(static_cast<int32_t>(integer(constant)))};
+        case Type::I64:     return {integer(constant)};
+        case Type::F64:     return {real(constant)};
+        default:            return constant;
+    }
+}
+
+// number of values in a constant, arrays count their elements
+size_t count(const Constant &constant) {
+    const auto *elements = std::get_if<std::vector<Constant>>(&constant.value);
+    if (!elements)
+        return 1;
+
+    size_t total = 0;
+    for (const Constant &element : *elements)
+        total += count(element);
+
+    return total;
+}
+
+// bytes of array storage held by a constant, scalars don't count against the budget
+uint64_t bytes(const Constant &constant) {
+    return std::holds_alternative<std::vector<Constant>>(constant.value) ? count(constant) * sizeof(Constant) : 0;
+}
+
+Value::Ptr toValue(const Constant &constant, const Type::Ptr &type) {
+    switch (type->getKind()) {
+        case Type::BOOL:
+        case Type::U8:
+        case Type::I32:
+        case Type::I64:     return std::make_shared<Value>(type, integer(constant));
+        case Type::F64:     return std::make_shared<Value>(real(constant));
+        case Type::LITERAL:
+            if (const auto *literal = std::get_if<std::string>(&constant.value))
+                return std::make_shared<Value>(*literal);
+            return nullptr;
+        case Type::ARRAY: {
+            const auto array = std::static_pointer_cast<ArrayType>(type);
+            const auto *elements = std::get_if<std::vector<Constant>>(&constant.value);
+            if (!elements || elements->size() != array->getSize())
+                return nullptr;
+
+            std::vector<Value::Ptr> values = {};
+            for (const Constant &element : *elements) {
+                values.push_back(toValue(element, array->getElement()));
+                if (!values.back())
+                    return nullptr;
+            }
+
+            return std::make_shared<Value>(array, std::move(values));
+        }
+        default:            return nullptr;
+    }
+}
+
+Constant fromValue(const Value &value) {
+    if (const std::optional<int64_t> integer = value.getInteger())
+        return {*integer};
+
+    if (const std::optional<double> real = value.getFloat())
+        return {*real};
+
+    if (std::optional<std::string> literal = value.getLiteral())
+        return {std::move(*literal)};
+
+    if (value.getType()->isArray()) {
+        std::vector<Constant> elements = {};
+        for (const Value::Ptr &element : value.getElements())
+            elements.push_back(fromValue(*element));
+        return {std::move(elements)};
+    }
+
+    throw NotConstant("unsupported constant " + value.str());
+}
+
+// tree-walking interpreter over analyzed function bodies, variables are found by their Symbol
+class Interpreter : public Visitor<Interpreter, Constant> {
+public:
+    explicit Interpreter(const ComptimeLimits &limits) : limits(limits), steps(0), memory(0) {}
+
+    // value of an expression without variables
+    Constant evaluate(const Expr::Ptr &expr) {
+        frames.emplace_back();
+        Constant result = visit(expr);
+        popFrame();
+        return result;
+    }
+
+    Constant call(const Function &function, std::vector<Constant> args) {
+        if (!function.getBody())
+            throw NotConstant(function.getSymbol() + " has no body");
+
+        if (frames.size() >= MAX_CALL_DEPTH)
+            throw NotConstant("calls nested deeper than " + std::to_string(MAX_CALL_DEPTH));
+
+        step();
+
+        // arguments are copies, writes to reference parameters stay inside the call
+        const auto &types = function.getFunctionType()->getParameterTypes();
+        const auto &parameters = function.getParameterSymbols();
+        frames.emplace_back();
+        for (size_t i = 0; i < parameters.size() && i < args.size(); ++i)
+            store(frames.back()[parameters[i].get()], convert(std::move(args[i]), types[i]));
+
+        returnTypes.push_back(function.getFunctionType()->getReturnType());
+        visit(function.getBody());
+
+        // a block's trailing expression was turned into a return by the parser
+        Constant result = returned ? std::move(*returned) : Constant{};
+        returned.reset();
+        returnTypes.pop_back();
+        popFrame();
+        return convert(std::move(result), function.getFunctionType()->getReturnType());
+    }
+
+    // declarations don't run anything
+    Constant visitFunctionPrototype(FunctionPrototype &) { return {}; }
+    Constant visitFunction(Function &) { return {}; }
+    Constant visitGeneric(GenericFunction &) { return {}; }
+    Constant visitStruct(StructStmt &) { return {}; }
+
+    Constant visitVariable(VariableStmt &node) {
+        const Type::Ptr type = node.getType(nullptr);
+        Constant value = node.getValue() ? visit(node.getValue()) : zero(type);
+        store(frames.back()[node.getDeclaration().get()], convert(std::move(value), type));
+        return {};
+    }
+
+    Constant visitReturn(ReturnStmt &node) {
+        returned = node.getValue() ? convert(visit(node.getValue()), returnTypes.back()) : Constant{};
+        return {};
+    }
+
+    Constant visitBlock(BlockExpr &node) {
+        for (const Stmt::Ptr &stmt : node.getStmts()) {
+            step();
+            visit(stmt);
+            if (returned)
+                break;
+        }
+
+        return {};
+    }
+
+    Constant visitWhile(WhileStmt &node) {
+        while (!returned) {
+            step();
+            if (!truthy(visit(node.getCondition())))
+                break;
+            visit(node.getBody());
+        }
+
+        return {};
+    }
+
+    Constant visitFor(ForStmt &node) {
+        visit(node.getInit());
+
+        while (!returned) {
+            step();
+            if (node.getCondition() && !truthy(visit(node.getCondition())))
+                break;
+
+            visit(node.getBody());
+            if (!returned)
+                visit(node.getStep());
+        }
+
+        return {};
+    }
+
+    Constant visitRangeFor(RangeForStmt &node) {
+        const int64_t start = integer(visit(node.getStart()));
+        const int64_t end = integer(visit(node.getEnd()));
+
+        for (int64_t i = start; i < end && !returned; ++i) {
+            step();
+            store(frames.back()[node.getCounter().get()], {i});
+            visit(node.getBody());
+        }
+
+        return {};
+    }
+
+    Constant visitAssignment(AssignmentExpr &node) {
+        Constant value = convert(visit(node.getValue()), node.getAssignee()->getType(nullptr));
+        store(place(node.getAssignee()), value);
+        return value;
+    }
+
+    Constant visitCall(CallExpr &node) {
+        if (node.getFolded())
+            return visit(node.getFolded());
+
+        if (node.getCallee()->kind() != AST::Symbol)
+            throw NotConstant("indirect call " + node.str());
+
+        const Symbol::Ptr &symbol = std::static_pointer_cast<SymbolExpr>(node.getCallee())->getSymbol();
+        const Function *function = symbol && symbol->isFunction() ? std::static_pointer_cast<FunctionSymbol>(symbol)->getDefinition() : nullptr;
+        if (!function)
+            throw NotConstant("call to " + node.getCallee()->str() + ", which isn't defined in the source");
+
+        std::vector<Constant> args = {};
+        for (const Expr::Ptr &arg : node.getArgs())
+            args.push_back(visit(arg));
+
+        return call(*function, std::move(args));
+    }
+
+    Constant visitBinary(BinaryExpr &node) {
+        const Type::Ptr type = node.getType(nullptr);
+        if (type && type->isVector())
+            throw NotConstant("vector operation " + node.str());
+
+        const Constant L = visit(node.getLHS());
+        const Constant R = visit(node.getRHS());
+        const bool isFloat = std::holds_alternative<double>(L.value) || std::holds_alternative<double>(R.value);
+
+        if (isComparison(node.getOp())) {
+            const int order = isFloat ? (real(L) < real(R) ? -1 : real(L) > real(R) ? 1 : 0)
+                : (integer(L) < integer(R) ? -1 : integer(L) > integer(R) ? 1 : 0);
+
+            switch (node.getOp()) {
+                case LT:    return {int64_t(order < 0)};
+                case GT:    return {int64_t(order > 0)};
+                case LTE:   return {int64_t(order <= 0)};
+                case GTE:   return {int64_t(order >= 0)};
+                case EQ:    return {int64_t(order == 0)};
+                default:    return {int64_t(order != 0)};
+            }
+        }
+
+        if (node.getOp() == POW)
+            return convert({std::pow(real(L), real(R))}, type);
+
+        if (isFloat) {
+            switch (node.getOp()) {
+                case ADD:   return convert({real(L) + real(R)}, type);
+                case SUB:   return convert({real(L) - real(R)}, type);
+                case MUL:   return convert({real(L) * real(R)}, type);
+                default:    return convert({real(L) / real(R)}, type);
+            }
+        }
+
+        // wrap around instead of overflowing, convert() then truncates to the result's width
+        const auto a = static_cast<uint64_t>(integer(L));
+        const auto b = static_cast<uint64_t>(integer(R));
+
+        switch (node.getOp()) {
+            case ADD:   return convert({static_cast<int64_t>(a + b)}, type);
+            case SUB:   return convert({static_cast<int64_t>(a - b)}, type);
+            case MUL:   return convert({static_cast<int64_t>(a * b)}, type);
+            default: {
+                if (integer(R) == 0 || (integer(L) == INT64_MIN && integer(R) == -1))
+                    throw NotConstant("division overflow in " + node.str());
+                return convert({integer(L) / integer(R)}, type);
+            }
+        }
+    }
+
+    Constant visitUnary(UnaryExpr &node) {
+        const UnaryOp op = node.getOp();
+        if (op == ADDR || op == DEREF)
+            throw NotConstant("pointer operation " + node.str());
+
+        Constant &target = place(node.getExpr());
+        const Constant old = target;
+        const int64_t delta = op == PRE_INC || op == POST_INC ? 1 : -1;
+
+        if (std::holds_alternative<double>(target.value))
+            target = convert({real(target) + static_cast<double>(delta)}, node.getType(nullptr));
+        else
+            target = convert({static_cast<int64_t>(static_cast<uint64_t>(integer(target)) + delta)}, node.getType(nullptr));
+
+        return op == PRE_INC || op == PRE_DEC ? target : old;
+    }
+
+    Constant visitIndex(IndexExpr &node) {
+        const Constant position = visit(node.getIndex());
+
+        // variables are indexed in place, copying the whole array for every read would make tables quadratic
+        if (isPlace(node.getArray()))
+            return copy(element(place(node.getArray()), position, node));
+
+        Constant array = visit(node.getArray());
+        return std::move(element(array, position, node));
+    }
+
+    Constant visitSymbol(SymbolExpr &node) { return copy(variable(node)); }
+
+    Constant visitValue(ValueExpr &node) {
+        Constant value = fromValue(*node.getValue());
+        reserve(bytes(value));
+        return value;
+    }
+
+    Constant visitMember(MemberExpr &node) { throw NotConstant("struct field " + node.str()); }
+    Constant visitSlice(SliceExpr &node) { throw NotConstant("slice of " + node.getArray()->str()); }
+    Constant visitBuiltin(BuiltinExpr &node) { throw NotConstant("builtin " + node.str()); }
+    Constant visitImport(ImportStmt &node) { throw NotConstant(node.str()); }
+
+private:
+    void step() {
+        if (++steps > limits.steps)
+            throw NotConstant("more than " + std::to_string(limits.steps) + " steps");
+    }
+
+    // only arrays held by variables count as live, a temporary has to fit next to them
+    void reserve(uint64_t size) const {
+        if (memory + size > limits.memory)
+            throw NotConstant("more than " + std::to_string(limits.memory) + " bytes of arrays");
+    }
+
+    Constant copy(const Constant &constant) {
+        reserve(bytes(constant));
+        return constant;
+    }
+
+    // replaces the value of a variable or element, the old one is released
+    void store(Constant &target, Constant value) {
+        const uint64_t released = bytes(target);
+        const uint64_t stored = bytes(value);
+
+        if (stored > released) {
+            reserve(stored - released);
+            memory += stored - released;
+        } else
+            memory -= released - stored;
+
+        target = std::move(value);
+    }
+
+    void popFrame() {
+        for (const auto &[symbol, value] : frames.back())
+            memory -= bytes(value);
+
+        frames.pop_back();
+    }
+
+    Constant zero(const Type::Ptr &type) {
+        if (!type || type->isPointer() || type->isSlice() || type->isStruct() || type->isVector())
+            throw NotConstant("uninitialized " + (type ? type->str() : "variable"));
+
+        if (type->isArray()) {
+            const auto array = std::static_pointer_cast<ArrayType>(type);
+            Constant element = zero(array->getElement());
+
+            // checked before it's created
+            reserve(count(element) * array->getSize() * sizeof(Constant));
+
+            return {std::vector<Constant>(array->getSize(), element)};
+        }
+
+        return convert({int64_t(0)}, type);
+    }
+
+    Constant &variable(SymbolExpr &node) {
+        auto &frame = frames.back();
+        const auto found = frame.find(node.getSymbol().get());
+        if (found == frame.end())
+            throw NotConstant("$" + node.getName() + " isn't known at compile time");
+
+        return found->second;
+    }
+
+    Constant &element(Constant &array, const Constant &index, const IndexExpr &node) {
+        auto *elements = std::get_if<std::vector<Constant>>(&array.value);
+        if (!elements)
+            throw NotConstant("indexing into " + node.getArray()->str());
+
+        const int64_t position = integer(index);
+        if (position < 0 || static_cast<uint64_t>(position) >= elements->size())
+            throw NotConstant("index " + std::to_string(position) + " out of bounds in " + node.str());
+
+        return (*elements)[position];
+    }
+
+    // variables and elements of them, they can be referenced instead of evaluated to a copy
+    static bool isPlace(const Expr::Ptr &expr) {
+        return expr->kind() == AST::Symbol || (expr->kind() == AST::Index && isPlace(static_cast<IndexExpr &>(*expr).getArray()));
+    }
+
+    // storage an assignment writes to
+    Constant &place(const Expr::Ptr &target) {
+        if (target->kind() == AST::Symbol)
+            return variable(static_cast<SymbolExpr &>(*target));
+
+        if (target->kind() == AST::Index) {
+            auto &index = static_cast<IndexExpr &>(*target);
+            const Constant position = visit(index.getIndex());
+            return element(place(index.getArray()), position, index);
+        }
+
+        throw NotConstant("assignment to " + target->str());
+    }
+
+    const ComptimeLimits &limits;
+    uint64_t steps;
+    uint64_t memory;
+    std::vector<std::unordered_map<const Symbol *, Constant>> frames; // locals of every active call
+    std::vector<Type::Ptr> returnTypes;
+    std::optional<Constant> returned; // set by a return until the call it leaves completes
+};
+
+// replaces @comptime calls innermost first, their results can be the arguments of the enclosing call
+class ComptimeFolder : public Visitor<ComptimeFolder> {
+public:
+    explicit ComptimeFolder(const ComptimeLimits &limits) : limits(limits) {}
+
+    void visitGeneric(GenericFunction &node) {
+        for (const auto &[name, instance] : node.getInstances())
+            visit(*instance);
+    }
+
+    void visitCall(CallExpr &node) {
+        visitChildren(node);
+
+        if (node.getFolded() || node.getCallee()->kind() != AST::Symbol)
+            return;
+
+        const Symbol::Ptr &symbol = std::static_pointer_cast<SymbolExpr>(node.getCallee())->getSymbol();
+        if (!symbol || !symbol->isFunction())
+            return;
+
+        const Function *function = std::static_pointer_cast<FunctionSymbol>(symbol)->getDefinition();
+        if (!function || !function->isComptime())
+            return;
+
+        const Type::Ptr &returnType = function->getFunctionType()->getReturnType();
+        if (returnType->getKind() == Type::VOID)
+            return;
+
+        Interpreter interpreter(limits);
+        std::vector<Constant> args = {};
+
+        // calls with arguments only known at runtime stay calls
+        try {
+            for (const Expr::Ptr &arg : node.getArgs())
+                args.push_back(interpreter.evaluate(arg));
+        } catch (const NotConstant &) {
+            return;
+        }
+
+        Value::Ptr value;
+        try {
+            value = toValue(interpreter.call(*function, std::move(args)), returnType);
+        } catch (const NotConstant &error) {
+            throw std::invalid_argument("Cannot evaluate " + node.str() + " at compile time: " + error.what());
+        }
+
+        if (!value)
+            throw std::invalid_argument("Cannot evaluate " + node.str() + " at compile time: "
+                + returnType->str() + " can't be a constant");
+
+        node.fold(makeNode<ValueExpr>(value));
+    }
+
+private:
+    const ComptimeLimits &limits;
+};
+
+}
+
+void foldComptimeCalls(Stmt &root, const ComptimeLimits &limits) {
+    ComptimeFolder(limits).visit(root);
+}
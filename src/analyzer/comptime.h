@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../ast/stmt.h"
+
+// bounds of every evaluated call, builds stay bounded whatever a @comptime function does
+struct ComptimeLimits {
+    uint64_t steps = 10'000'000;        // statements, loop iterations and calls
+    uint64_t memory = 64 * 1024 * 1024; // bytes of the arrays live at once
+};
+
+// evaluate the calls to @comptime functions whose arguments are constant with an interpreter over the analyzed
+// tree and generate their results instead, throws std::invalid_argument if a body can't be evaluated
+void foldComptimeCalls(Stmt &root, const ComptimeLimits &limits);
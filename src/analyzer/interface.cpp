@@ -0,0 +1,243 @@
+#include "interface.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+
+#include "function.h"
+
+// bumped whenever the layout below changes, older interfaces have to be regenerated
+constexpr char MAGIC[4] = {'L', 'Y', 'M', 'I'};
+constexpr uint32_t VERSION = 3;
+
+// nesting limit for types, guards against corrupted files
+constexpr size_t MAX_TYPE_DEPTH = 64;
+
+// integers are stored little-endian independent of the host
+static void writeInt(std::ostream &os, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i)
+        os.put(static_cast<char>(value >> (8 * i) & 0xff));
+}
+
+static uint64_t readInt(std::istream &is, size_t bytes) {
+    uint64_t value = 0;
+
+    for (size_t i = 0; i < bytes; ++i) {
+        const int byte = is.get();
+        if (byte == std::char_traits<char>::eof())
+            throw std::invalid_argument("Unexpected end of module interface");
+
+        value |= static_cast<uint64_t>(byte) << (8 * i);
+    }
+
+    return value;
+}
+
+static void writeString(std::ostream &os, const std::string &value) {
+    writeInt(os, value.size(), 4);
+    os.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+static std::string readString(std::istream &is) {
+    const uint64_t size = readInt(is, 4);
+    std::string value;
+
+    // read in chunks so a corrupted size fails at the end of the file instead of allocating it all
+    while (value.size() < size) {
+        char buffer[4096];
+        const auto count = static_cast<std::streamsize>(std::min<uint64_t>(sizeof(buffer), size - value.size()));
+        if (!is.read(buffer, count))
+            throw std::invalid_argument("Unexpected end of module interface");
+
+        value.append(buffer, count);
+    }
+
+    return value;
+}
+
+Interface::Ptr Interface::collect(const Root::Ptr &root) {
+    auto interface = std::make_shared<Interface>();
+
+    for (const Stmt::Ptr &stmt : root->getProgram()) {
+        if (!stmt || (stmt->kind() != AST::FunctionPrototype && stmt->kind() != AST::Function))
+            continue;
+
+        const auto &prototype = static_cast<const FunctionPrototype &>(*stmt);
+        if (prototype.getSymbol() != "main")
+            interface->exports.push_back({prototype.getSymbol(), prototype.getFunctionType(), prototype.getParameters()});
+    }
+
+    return interface;
+}
+
+Interface::Ptr Interface::read(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        throw std::invalid_argument("Could not open module interface '" + path + "'");
+
+    char magic[sizeof(MAGIC)];
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC))
+        throw std::invalid_argument("'" + path + "' is not a module interface");
+
+    if (readInt(file, 4) != VERSION)
+        throw std::invalid_argument("Module interface '" + path + "' was written by another compiler version");
+
+    auto interface = std::make_shared<Interface>();
+    std::map<std::string, StructType::Ptr> structs = {};
+
+    for (uint64_t count = readInt(file, 4); count > 0; --count) {
+        Export entry;
+        entry.name = readString(file);
+
+        Type::Ptr type = readType(file, structs);
+        if (!type->isFunction())
+            throw std::invalid_argument("Export '" + entry.name + "' of '" + path + "' is not a function");
+        entry.type = std::static_pointer_cast<FunctionType>(type);
+
+        for (size_t i = 0; i < entry.type->getParameterTypes().size(); ++i)
+            entry.parameters.push_back(readString(file));
+
+        interface->exports.push_back(std::move(entry));
+    }
+
+    return interface;
+}
+
+void Interface::write(const std::string &path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+        throw std::invalid_argument("Could not write module interface '" + path + "'");
+
+    file.write(MAGIC, sizeof(MAGIC));
+    writeInt(file, VERSION, 4);
+    writeInt(file, exports.size(), 4);
+
+    std::set<std::string> structs = {};
+    for (const Export &entry : exports) {
+        writeString(file, entry.name);
+        writeType(file, entry.type, structs);
+
+        for (const std::string &parameter : entry.parameters)
+            writeString(file, parameter);
+    }
+}
+
+// kind followed by the element types and sizes of compound types
+void Interface::writeType(std::ostream &os, const Type::Ptr &type, std::set<std::string> &structs) {
+    writeInt(os, type->getKind(), 1);
+
+    switch (type->getKind()) {
+        case Type::PTR:     writeType(os, std::static_pointer_cast<PointerType>(type)->getPointee(), structs); break;
+        case Type::REF:     writeType(os, std::static_pointer_cast<ReferenceType>(type)->getReferee(), structs); break;
+        case Type::SLICE:   writeType(os, std::static_pointer_cast<SliceType>(type)->getElement(), structs); break;
+        case Type::ARRAY: {
+            auto array = std::static_pointer_cast<ArrayType>(type);
+            writeType(os, array->getElement(), structs);
+            writeInt(os, array->getSize(), 8);
+            break;
+        }
+        case Type::VECTOR: {
+            auto vector = std::static_pointer_cast<VectorType>(type);
+            writeType(os, vector->getElement(), structs);
+            writeInt(os, vector->getLanes(), 8);
+            break;
+        }
+        case Type::FUNC: {
+            auto function = std::static_pointer_cast<FunctionType>(type);
+            writeType(os, function->getReturnType(), structs);
+            writeInt(os, function->getParameterTypes().size(), 4);
+            for (const Type::Ptr &parameter : function->getParameterTypes())
+                writeType(os, parameter, structs);
+            break;
+        }
+        case Type::STRUCT: {
+            auto record = std::static_pointer_cast<StructType>(type);
+            writeString(os, record->getName());
+
+            const bool define = structs.insert(record->getName()).second;
+            writeInt(os, define, 1);
+            if (!define)
+                break;
+
+            const StructType::Layout &layout = record->getLayout();
+            writeInt(os, layout.packed | layout.soa << 1, 1);
+            writeInt(os, layout.align, 8);
+            writeInt(os, record->getFields().size(), 4);
+            for (const StructType::Field &field : record->getFields()) {
+                writeString(os, field.name);
+                writeType(os, field.type, structs);
+            }
+            break;
+        }
+        default:            break;
+    }
+}
+
+Type::Ptr Interface::readType(std::istream &is, std::map<std::string, StructType::Ptr> &structs, size_t depth) {
+    if (depth > MAX_TYPE_DEPTH)
+        throw std::invalid_argument("Type nested too deeply in module interface");
+
+    const uint64_t kind = readInt(is, 1);
+
+    switch (kind) {
+        case Type::PTR:     return std::make_shared<PointerType>(readType(is, structs, depth + 1));
+        case Type::REF:     return std::make_shared<ReferenceType>(readType(is, structs, depth + 1));
+        case Type::SLICE:   return std::make_shared<SliceType>(readType(is, structs, depth + 1));
+        // sizes are checked like the parser does, LLVM asserts on some of them
+        case Type::ARRAY: {
+            Type::Ptr element = readType(is, structs, depth + 1);
+            const uint64_t size = readInt(is, 8);
+            if (size > ArrayType::MAX_SIZE)
+                throw std::invalid_argument("Invalid array size " + std::to_string(size) + " in module interface");
+            return std::make_shared<ArrayType>(element, size);
+        }
+        case Type::VECTOR: {
+            Type::Ptr element = readType(is, structs, depth + 1);
+            const uint64_t lanes = readInt(is, 8);
+            if (!VectorType::isValidLanes(lanes))
+                throw std::invalid_argument("Invalid vector lane count " + std::to_string(lanes) + " in module interface");
+            return std::make_shared<VectorType>(element, lanes);
+        }
+        case Type::FUNC: {
+            Type::Ptr returnType = readType(is, structs, depth + 1);
+            Type::Vec parameters = {};
+            for (uint64_t count = readInt(is, 4); count > 0; --count)
+                parameters.push_back(readType(is, structs, depth + 1));
+            return std::make_shared<FunctionType>(returnType, parameters);
+        }
+        case Type::STRUCT: {
+            // registered before the fields are read, they may point back to the struct
+            const std::string name = readString(is);
+            StructType::Ptr &record = structs[name];
+            if (!record)
+                record = std::make_shared<StructType>(name);
+
+            if (!readInt(is, 1))
+                return record;
+
+            StructType::Layout layout;
+            const uint64_t flags = readInt(is, 1);
+            layout.packed = flags & 1;
+            layout.soa = flags & 2;
+            layout.align = readInt(is, 8);
+            if (layout.align > StructType::MAX_ALIGN || (layout.align & (layout.align - 1)))
+                throw std::invalid_argument("Invalid alignment of struct " + name + " in module interface");
+
+            std::vector<StructType::Field> fields = {};
+            for (uint64_t count = readInt(is, 4); count > 0; --count) {
+                std::string field = readString(is);
+                fields.push_back({std::move(field), readType(is, structs, depth + 1)});
+            }
+
+            record->define(std::move(fields), layout);
+            if (record->contains(*record))
+                throw std::invalid_argument("Struct " + name + " contains itself in module interface");
+            return record;
+        }
+        default:
+            if (kind > Type::AUTO)
+                throw std::invalid_argument("Unknown type kind in module interface");
+
+            return std::make_shared<Type>(static_cast<Type::Kind>(kind));
+    }
+}
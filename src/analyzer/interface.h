@@ -0,0 +1,39 @@
+#pragma once
+
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../ast/stmt.h"
+
+// binary module interface (.lymi) holding the exported function prototypes of a module,
+// importers load it instead of lexing, parsing and analyzing the module's source
+class Interface {
+public:
+    using Ptr = std::shared_ptr<Interface>;
+
+    struct Export {
+        std::string name;
+        FunctionType::Ptr type;
+        std::vector<std::string> parameters;
+    };
+
+    // every top-level function and prototype of a parsed tree except main
+    static Ptr collect(const Root::Ptr &root);
+
+    // both throw std::invalid_argument if the file can't be opened or is malformed
+    static Ptr read(const std::string &path);
+    void write(const std::string &path) const;
+
+    [[nodiscard]] const std::vector<Export> &getExports() const { return exports; }
+
+private:
+    // structs are defined at their first use in the file and referenced by name afterwards
+    static void writeType(std::ostream &os, const Type::Ptr &type, std::set<std::string> &structs);
+    static Type::Ptr readType(std::istream &is, std::map<std::string, StructType::Ptr> &structs, size_t depth = 0);
+
+    std::vector<Export> exports;
+};
@@ -0,0 +1,37 @@
+#include "prelude.h"
+
+#include "analyzer.h"
+
+struct PreludeFunction {
+    const char *name;
+    const char *linkName;
+    Type::Kind returnType;
+    std::vector<std::pair<const char *, Type::Kind>> parameters;
+};
+
+// strings are taken as literals, the type string literals have
+static const PreludeFunction PRELUDE[] = {
+    {"core::print",         "lynx_print",       Type::VOID, {{"text", Type::LITERAL}}},
+    {"core::println",       "lynx_println",     Type::VOID, {{"text", Type::LITERAL}}},
+    {"core::print_int",     "lynx_print_int",   Type::VOID, {{"value", Type::I64}}},
+    {"core::print_float",   "lynx_print_float", Type::VOID, {{"value", Type::F64}}},
+    {"core::flush",         "lynx_flush",       Type::VOID, {}},
+};
+
+void declarePrelude(const Analyzer::Ptr &analyzer) {
+    for (const PreludeFunction &function : PRELUDE) {
+        Type::Vec types = {};
+        std::vector<std::string> names = {};
+
+        for (const auto &[name, kind] : function.parameters) {
+            names.emplace_back(name);
+            types.push_back(std::make_shared<Type>(kind));
+        }
+
+        auto type = std::make_shared<FunctionType>(std::make_shared<Type>(function.returnType), types);
+        auto symbol = std::make_shared<FunctionSymbol>(analyzer, function.name, type, names);
+        symbol->setLinkName(function.linkName);
+        symbol->setExternal(true);
+        analyzer->insert(function.name, symbol);
+    }
+}
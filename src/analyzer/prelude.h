@@ -0,0 +1,9 @@
+#pragma once
+
+#include <memory>
+
+class Analyzer;
+
+// declare the core:: functions every module can call without an import,
+// they are implemented by the runtime library (src/runtime) that programs are linked with
+void declarePrelude(const std::shared_ptr<Analyzer> &analyzer);
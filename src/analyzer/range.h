@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+// inclusive interval of values an integer expression can take at runtime
+struct Range {
+    int64_t min, max;
+
+    [[nodiscard]] constexpr bool within(int64_t lower, int64_t upper) const { return min >= lower && max <= upper; }
+};
+
+// interval arithmetic, yields nullopt if any bound could overflow
+
+inline std::optional<Range> operator+(const Range &L, const Range &R) {
+    Range ret{};
+    if (__builtin_add_overflow(L.min, R.min, &ret.min) || __builtin_add_overflow(L.max, R.max, &ret.max))
+        return std::nullopt;
+    return ret;
+}
+
+inline std::optional<Range> operator-(const Range &L, const Range &R) {
+    Range ret{};
+    if (__builtin_sub_overflow(L.min, R.max, &ret.min) || __builtin_sub_overflow(L.max, R.min, &ret.max))
+        return std::nullopt;
+    return ret;
+}
+
+inline std::optional<Range> operator*(const Range &L, const Range &R) {
+    int64_t products[4];
+    if (__builtin_mul_overflow(L.min, R.min, &products[0]) || __builtin_mul_overflow(L.min, R.max, &products[1])
+        || __builtin_mul_overflow(L.max, R.min, &products[2]) || __builtin_mul_overflow(L.max, R.max, &products[3]))
+        return std::nullopt;
+
+    Range ret{products[0], products[0]};
+    for (int64_t product : products) {
+        ret.min = product < ret.min ? product : ret.min;
+        ret.max = product > ret.max ? product : ret.max;
+    }
+    return ret;
+}
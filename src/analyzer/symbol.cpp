@@ -4,6 +4,7 @@
 #include <utility>
 
 #include "analyzer.h"
+#include "function.h"
 
 // SYMBOL
 
@@ -12,6 +13,21 @@ Symbol::Symbol(Analyzer::Ptr analyzer, std::string name, Type::Ptr type)
 
 Symbol::~Symbol() { name.clear(); }
 
+const wyvern::Entity::Ptr &Symbol::getStorage(const wyvern::Wrapper::Ptr &context) const {
+    static const wyvern::Entity::Ptr unbound = nullptr;
+
+    // a server's earlier emitIR or the JIT's generation bound it in another module
+    if (storageContext.owner_before(context) || context.owner_before(storageContext))
+        return unbound;
+
+    return storage;
+}
+
+void Symbol::setStorage(const wyvern::Wrapper::Ptr &context, wyvern::Entity::Ptr storage) {
+    this->storage = std::move(storage);
+    storageContext = context;
+}
+
 std::string Symbol::str() const { return "$"+name + " " + type->str(); }
 
 // FUNCTION SYMBOL
@@ -28,3 +44,17 @@ FunctionSymbol::~FunctionSymbol() {
 const Type::Vec &FunctionSymbol::getParameterTypes() const {
     return std::static_pointer_cast<FunctionType>(type)->getParameterTypes();
 }
+
+wyvern::Entity::Ptr FunctionSymbol::declare(const wyvern::Wrapper::Ptr &context) {
+    if (const wyvern::Entity::Ptr &declared = getStorage(context))
+        return declared;
+
+    const auto function = std::static_pointer_cast<FunctionType>(type);
+    setStorage(context, context->declareFunction(function->getReturnType()->generate(context), getLinkName(), function->generateArgs(context, parameterNames)));
+    return storage;
+}
+
+// GENERIC SYMBOL
+
+GenericSymbol::GenericSymbol(const Analyzer::Ptr &analyzer, GenericFunction &function)
+: Symbol(analyzer, function.getSymbol(), function.getFunctionType()), function(function) {}
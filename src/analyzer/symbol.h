@@ -2,41 +2,104 @@
 
 #include <map>
 #include <memory>
+#include <optional>
 
+#include "range.h"
 #include "../parser/type.h"
+#include "../wyvern/src/wyvern.hpp"
 
 class Analyzer;
+class Function;
+class GenericFunction;
 
 class Symbol {
 public:
     using Ptr = std::shared_ptr<Symbol>;
+    using Vec = std::vector<Ptr>;
     using Map = std::map<std::string, Ptr>;
 
     Symbol(std::shared_ptr<Analyzer> analyzer, std::string name, Type::Ptr type);
     virtual ~Symbol();
 
+    [[nodiscard]] const std::string &getName() const { return name; }
     [[nodiscard]] const Type::Ptr &getType() const { return type; }
 
+    // where the symbol is declared
+    [[nodiscard]] const Location &getLocation() const { return location; }
+    void setLocation(const Location &location) { this->location = location; }
+
+    // known bounds of an integer symbol, used to drop bounds checks
+    [[nodiscard]] const std::optional<Range> &getRange() const { return range; }
+    void setRange(std::optional<Range> range) { this->range = range; }
+
+    // loop counters, neither assigned nor addressed, reference parameters get a copy
+    [[nodiscard]] bool isReadOnly() const { return readOnly; }
+    void setReadOnly(bool readOnly) { this->readOnly = readOnly; }
+
+    // local, argument or function the symbol was generated as, bound when its declaration is generated,
+    // null in any other context than the one it was bound in
+    [[nodiscard]] const wyvern::Entity::Ptr &getStorage(const wyvern::Wrapper::Ptr &context) const;
+    void setStorage(const wyvern::Wrapper::Ptr &context, wyvern::Entity::Ptr storage);
+
     [[nodiscard]] virtual std::string str() const;
 
     [[nodiscard]] virtual constexpr bool isFunction() const { return false; }
+    [[nodiscard]] virtual constexpr bool isGeneric() const { return false; }
 
 protected:
     std::shared_ptr<Analyzer> analyzer;
     std::string name;
     Type::Ptr type;
+    std::optional<Range> range;
+    bool readOnly = false;
+    wyvern::Entity::Ptr storage;
+    std::weak_ptr<wyvern::Wrapper> storageContext; // held weakly, compared by owner like the types' cache
+    Location location;
 };
 
 class FunctionSymbol : public Symbol {
 public:
+    using Ptr = std::shared_ptr<FunctionSymbol>;
+
     FunctionSymbol(const std::shared_ptr<Analyzer> &analyzer, const std::string &name,
         const FunctionType::Ptr &type, const std::vector<std::string> &parameterNames);
     ~FunctionSymbol() override;
 
     [[nodiscard]] const Type::Vec &getParameterTypes() const;
+    [[nodiscard]] const std::vector<std::string> &getParameterNames() const { return parameterNames; }
+
+    // symbol of the generated function, the source name unless it's implemented under another one
+    [[nodiscard]] const std::string &getLinkName() const { return linkName.empty() ? name : linkName; }
+    void setLinkName(std::string linkName) { this->linkName = std::move(linkName); }
+
+    // declare the function in the module being generated unless it already is, for functions defined elsewhere
+    wyvern::Entity::Ptr declare(const wyvern::Wrapper::Ptr &context);
 
     [[nodiscard]] constexpr bool isFunction() const override { return true; }
+    // provided by another module or the runtime instead of a declaration in the source
+    [[nodiscard]] bool isExternal() const { return external; }
+    void setExternal(bool external) { this->external = external; }
+
+    // function with a body in the source, null for prototypes and external functions
+    [[nodiscard]] Function *getDefinition() const { return definition; }
+    void setDefinition(Function *definition) { this->definition = definition; }
 
 private:
     std::vector<std::string> parameterNames;
-};
\ No newline at end of file
+    std::string linkName;
+    bool external = false;
+    Function *definition = nullptr;
+};
+
+// name of a generic function, calls are bound to the FunctionSymbol of an instance instead
+class GenericSymbol : public Symbol {
+public:
+    GenericSymbol(const std::shared_ptr<Analyzer> &analyzer, GenericFunction &function);
+
+    [[nodiscard]] GenericFunction &getFunction() const { return function; }
+
+    [[nodiscard]] constexpr bool isGeneric() const override { return true; }
+
+private:
+    GenericFunction &function;
+};
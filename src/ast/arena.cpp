@@ -0,0 +1,35 @@
+#include "arena.h"
+
+namespace arena {
+
+static llvm::PointerType *getPtrTy(const wyvern::Wrapper::Ptr &context) {
+    return llvm::PointerType::getUnqual(*context->getContext());
+}
+
+llvm::Value *create(const wyvern::Wrapper::Ptr &context) {
+    llvm::FunctionCallee function = context->getModule()->getOrInsertFunction("lynx_arena_create", getPtrTy(context));
+    return context->getBuilder()->CreateCall(function, {}, "arena");
+}
+
+llvm::Value *allocate(const wyvern::Wrapper::Ptr &context, llvm::Value *arena, llvm::Type *type, llvm::Value *count) {
+    auto builder = context->getBuilder();
+    llvm::Type *i64 = builder->getInt64Ty();
+    llvm::FunctionCallee function = context->getModule()->getOrInsertFunction("lynx_arena_alloc", getPtrTy(context), getPtrTy(context), i64, i64);
+
+    // folded to constants once the target's data layout is known
+    llvm::Value *size = builder->CreateMul(llvm::ConstantExpr::getSizeOf(type), builder->CreateZExtOrTrunc(count, i64));
+    llvm::CallInst *call = builder->CreateCall(function, {arena, size, llvm::ConstantExpr::getAlignOf(type)});
+
+    // never null, the runtime aborts when it runs out of memory
+    call->addRetAttr(llvm::Attribute::NonNull);
+    call->addRetAttr(llvm::Attribute::NoAlias);
+    return call;
+}
+
+void destroy(const wyvern::Wrapper::Ptr &context, llvm::Value *arena) {
+    llvm::FunctionCallee function = context->getModule()->getOrInsertFunction("lynx_arena_destroy",
+        context->getBuilder()->getVoidTy(), getPtrTy(context));
+    context->getBuilder()->CreateCall(function, {arena});
+}
+
+}
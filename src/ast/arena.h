@@ -0,0 +1,16 @@
+#pragma once
+
+#include "../wyvern/src/wyvern.hpp"
+
+// calls into the region allocator of the runtime library (lynx_arena_* in src/runtime/lynxrt.h),
+// an @arena block creates one on entry and destroys it on every way out
+namespace arena {
+
+// handle of a new, empty arena
+llvm::Value *create(const wyvern::Wrapper::Ptr &context);
+// zeroed memory for count values of type, valid until the arena is destroyed
+llvm::Value *allocate(const wyvern::Wrapper::Ptr &context, llvm::Value *arena, llvm::Type *type, llvm::Value *count);
+// release everything allocated in the arena at once
+void destroy(const wyvern::Wrapper::Ptr &context, llvm::Value *arena);
+
+}
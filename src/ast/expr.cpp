@@ -1,11 +1,155 @@
+#include <algorithm>
 #include <format>
 #include <utility>
 
 #include "expr.h"
+#include "arena.h"
 
 #include <sstream>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/Triple.h>
 
 #include "symbol.h"
+#include "function.h"
+
+// get the llvm value an entity holds, loading it if it's a local
+static llvm::Value *loadValue(const wyvern::Wrapper::Ptr &context, const wyvern::Entity::Ptr &entity, const wyvern::Ty::Ptr &type) {
+    return context->typeCast(entity, type)->getValuePtr();
+}
+
+static llvm::Value *loadValue(const wyvern::Wrapper::Ptr &context, const wyvern::Entity::Ptr &entity, const Type::Ptr &type) {
+    return loadValue(context, entity, type->generate(context));
+}
+
+// strip the reference or pointer an array or struct is accessed through
+static Type::Ptr unwrapIndirection(Type::Ptr type, bool &indirect) {
+    indirect = true;
+
+    if (type->isReference())
+        return std::static_pointer_cast<ReferenceType>(type)->getReferee();
+
+    if (type->isPointer())
+        return std::static_pointer_cast<PointerType>(type)->getPointee();
+
+    indirect = false;
+    return type;
+}
+
+// stack slot in the function's entry block, an alloca anywhere else grows the stack on every loop iteration
+static llvm::AllocaInst *entryAlloca(const wyvern::Wrapper::Ptr &context, llvm::Type *type, const std::string &name) {
+    llvm::BasicBlock &entry = context->getBuilder()->GetInsertBlock()->getParent()->getEntryBlock();
+    llvm::IRBuilder<> builder(&entry, entry.getFirstInsertionPt());
+    return builder.CreateAlloca(type, nullptr, name);
+}
+
+// get the address an array or struct lives at
+static llvm::Value *arrayAddress(const wyvern::Wrapper::Ptr &context, const wyvern::Entity::Ptr &entity, const Type::Ptr &type, bool indirect) {
+    if (indirect)
+        return loadValue(context, entity, type->generatePointerTo(context));
+
+    if (auto local = std::dynamic_pointer_cast<wyvern::Local>(entity))
+        return local->getPtr();
+
+    // temporary array (e.g. returned from a call), spill it so it can be indexed
+    auto builder = context->getBuilder();
+    llvm::Value *value = loadValue(context, entity, type);
+    llvm::Value *spill = entryAlloca(context, value->getType(), "spill");
+    builder->CreateStore(value, spill);
+    return spill;
+}
+
+// trap unless 0 <= index < length, the index is treated as unsigned to catch negative values
+static void generateBoundsCheck(const wyvern::Wrapper::Ptr &context, llvm::Value *index, llvm::Value *length) {
+    auto builder = context->getBuilder();
+    llvm::LLVMContext &ctx = context->getModule()->getContext();
+    llvm::Function *parent = builder->GetInsertBlock()->getParent();
+
+    llvm::BasicBlock *inBounds = llvm::BasicBlock::Create(ctx, "bounds.ok", parent);
+    llvm::BasicBlock *outOfBounds = llvm::BasicBlock::Create(ctx, "bounds.fail", parent);
+
+    llvm::Value *cond = builder->CreateICmpULT(index, length);
+    builder->CreateCondBr(cond, inBounds, outOfBounds, llvm::MDBuilder(ctx).createBranchWeights(1 << 20, 1));
+
+    builder->SetInsertPoint(outOfBounds);
+    builder->CreateCall(llvm::Intrinsic::getOrInsertDeclaration(context->getModule(), llvm::Intrinsic::trap));
+    builder->CreateUnreachable();
+
+    builder->SetInsertPoint(inBounds);
+}
+
+// width in bits of the widest vector register of the host
+static int64_t nativeVectorWidth(bool isFloat) {
+    const llvm::Triple triple(llvm::sys::getProcessTriple());
+
+    if (!triple.isX86())
+        return 128; // NEON and everything else we target
+
+    const llvm::StringMap<bool> features = llvm::sys::getHostCPUFeatures();
+
+    if (features.lookup("avx512f"))
+        return 512;
+
+    // AVX only widened floating point operations
+    if (features.lookup("avx2") || (isFloat && features.lookup("avx")))
+        return 256;
+
+    return 128;
+}
+
+static int64_t scalarBits(const Type::Ptr &type) {
+    switch (type->getKind()) {
+        case Type::U8:  return 8;
+        case Type::I32: return 32;
+        default:        return 64;
+    }
+}
+
+static llvm::CmpInst::Predicate comparePredicate(BinaryOp op, const Type::Ptr &type) {
+    if (type->isFloat())
+        switch (op) {
+            case LT:    return llvm::CmpInst::FCMP_OLT;
+            case GT:    return llvm::CmpInst::FCMP_OGT;
+            case LTE:   return llvm::CmpInst::FCMP_OLE;
+            case GTE:   return llvm::CmpInst::FCMP_OGE;
+            case EQ:    return llvm::CmpInst::FCMP_OEQ;
+            default:    return llvm::CmpInst::FCMP_UNE;
+        }
+
+    const bool isSigned = type->isSigned();
+    switch (op) {
+        case LT:    return isSigned ? llvm::CmpInst::ICMP_SLT : llvm::CmpInst::ICMP_ULT;
+        case GT:    return isSigned ? llvm::CmpInst::ICMP_SGT : llvm::CmpInst::ICMP_UGT;
+        case LTE:   return isSigned ? llvm::CmpInst::ICMP_SLE : llvm::CmpInst::ICMP_ULE;
+        case GTE:   return isSigned ? llvm::CmpInst::ICMP_SGE : llvm::CmpInst::ICMP_UGE;
+        case EQ:    return llvm::CmpInst::ICMP_EQ;
+        default:    return llvm::CmpInst::ICMP_NE;
+    }
+}
+
+// read-only symbol the expression names, if any
+static const Symbol *getReadOnly(const Expr::Ptr &expr) {
+    if (!expr || expr->kind() != AST::Symbol)
+        return nullptr;
+
+    const Symbol::Ptr &symbol = std::static_pointer_cast<SymbolExpr>(expr)->getSymbol();
+    return symbol && symbol->isReadOnly() ? symbol.get() : nullptr;
+}
+
+// loop counters are bounded by their range, they can't be written to
+static void checkMutable(const Analyzer::Ptr &analyzer, const Expr::Ptr &target) {
+    if (const Symbol *symbol = getReadOnly(target))
+        throw std::invalid_argument("Cannot modify loop counter $" + symbol->getName());
+}
+
+// EXPR
+
+Type::Ptr Expr::getType(Analyzer::Ptr analyzer) const {
+    if (!cachedType)
+        cachedType = inferType(analyzer);
+
+    return cachedType;
+}
 
 // ASSIGNMENT EXPR
 
@@ -14,11 +158,29 @@ AssignmentExpr::AssignmentExpr(Ptr assignee, Ptr value)
 
 AssignmentExpr::~AssignmentExpr() = default;
 
-void AssignmentExpr::analyze(Analyzer::Ptr analyzer) {}
+void AssignmentExpr::analyze(Analyzer::Ptr analyzer) {
+    assignee->analyze(analyzer);
+    value->analyze(analyzer);
+    checkMutable(analyzer, assignee);
+}
 
-Type::Ptr AssignmentExpr::getType(Analyzer::Ptr analyzer) const { return assignee->getType(analyzer); }
+Type::Ptr AssignmentExpr::inferType(const Analyzer::Ptr &analyzer) const { return assignee->getType(analyzer); }
 
 wyvern::Entity::Ptr AssignmentExpr::generate(wyvern::Wrapper::Ptr context) {
+    if (assignee->kind() == AST::Index) {
+        llvm::Value *address = std::static_pointer_cast<IndexExpr>(assignee)->generateAddress(context);
+        wyvern::Val::Ptr R = context->typeCast(value->generate(context), assignee->getType(nullptr)->generate(context));
+        context->getBuilder()->CreateStore(R->getValuePtr(), address);
+        return R;
+    }
+
+    if (assignee->kind() == AST::Member) {
+        llvm::Value *address = std::static_pointer_cast<MemberExpr>(assignee)->generateAddress(context);
+        wyvern::Val::Ptr R = context->typeCast(value->generate(context), assignee->getType(nullptr)->generate(context));
+        context->getBuilder()->CreateStore(R->getValuePtr(), address);
+        return R;
+    }
+
     wyvern::Entity::Ptr L = assignee->generate(context);
     wyvern::Entity::Ptr R = value->generate(context);
     context->storeValue(L, R);
@@ -31,21 +193,30 @@ std::string AssignmentExpr::str() const {
 
 // BLOCK EXPR
 
-BlockExpr::BlockExpr(Stmt::Vec stmts) : stmts(std::move(stmts)), yieldsValue(false) {}
+BlockExpr::BlockExpr(Stmt::Vec stmts, bool arena) : stmts(std::move(stmts)), yieldsValue(false), arena(arena) {}
 
 BlockExpr::~BlockExpr() { stmts.clear(); }
 
 void BlockExpr::analyze(Analyzer::Ptr analyzer) {
     analyzer->enterScope();
 
+    if (arena) {
+        handle = std::make_shared<Symbol>(analyzer, "@arena", std::make_shared<Type>(Type::U8)->getPointerTo());
+        handle->setLocation(location);
+        analyzer->enterArena(handle);
+    }
+
     for (auto &stmt : stmts)
         if (stmt)
             stmt->analyze(analyzer);
 
+    if (arena)
+        analyzer->leaveArena();
+
     analyzer->leaveScope();
 }
 
-Type::Ptr BlockExpr::getType(Analyzer::Ptr analyzer) const {
+Type::Ptr BlockExpr::inferType(const Analyzer::Ptr &analyzer) const {
     // temporary
     if (stmts.back()->kind() == AST::Return)
         return stmts.back()->getType(analyzer);
@@ -56,15 +227,22 @@ Type::Ptr BlockExpr::getType(Analyzer::Ptr analyzer) const {
 wyvern::Entity::Ptr BlockExpr::generate(wyvern::Wrapper::Ptr context) {
     wyvern::Entity::Ptr ret = context->getNull();
 
+    if (arena)
+        handle->setStorage(context, wyvern::Val::create(context, handle->getType()->generate(context), arena::create(context)));
+
     for (const auto &stmt : stmts)
         ret = stmt->generate(context);
 
+    // a return at the end already released it
+    if (arena && !context->getBuilder()->GetInsertBlock()->getTerminator())
+        arena::destroy(context, std::static_pointer_cast<wyvern::Val>(handle->getStorage(context))->getValuePtr());
+
     return ret;
 }
 
 std::string BlockExpr::str() const {
     std::stringstream ss;
-    ss << "{ ";
+    ss << (arena ? "@arena { " : "{ ");
 
     if (stmts.size() == 1)
         ss << stmts[0]->str() << "; }";
@@ -79,7 +257,7 @@ std::string BlockExpr::str() const {
 
 // CALL EXPR
 
-CallExpr::CallExpr(Ptr callee, Vec args) : callee(std::move(callee)), args(std::move(args)) {}
+CallExpr::CallExpr(Ptr callee, Vec args) : callee(std::move(callee)), args(std::move(args)), tail(TailCall::NONE) {}
 
 CallExpr::~CallExpr() = default;
 
@@ -88,29 +266,133 @@ void CallExpr::analyze(Analyzer::Ptr analyzer) {
         return;
 
     callee->analyze(analyzer);
+
+    // calls to generic functions are bound to the instance for the argument types
+    const bool generic = callee->kind() == AST::Symbol && std::static_pointer_cast<SymbolExpr>(callee)->getSymbol()->isGeneric();
+    if (generic) {
+        const auto symbol = std::static_pointer_cast<SymbolExpr>(callee);
+        GenericFunction &function = std::static_pointer_cast<GenericSymbol>(symbol->getSymbol())->getFunction();
+
+        Type::Vec types = {};
+        for (const Ptr &arg : args) {
+            arg->analyze(analyzer);
+            types.push_back(arg->getType(analyzer));
+        }
+
+        symbol->setSymbol(analyzer->specialize(function, function.deduce(types)));
+    }
+
     // TODO: standard values
     const auto &ftype = std::static_pointer_cast<FunctionType>(callee->getType(analyzer));
     const Type::Vec &params = ftype->getParameterTypes();
 
     for (size_t i = 0; i < args.size(); ++i) {
-        args[i]->analyze(analyzer);
+        if (!generic)
+            args[i]->analyze(analyzer);
 
         // if parameters isn't a reference and arg is a pointer, insert dereference op
         if (!params[i]->isReference() && args[i]->getType(analyzer)->isPointer())
-            args[i] = std::make_shared<UnaryExpr>(DEREF, args[i]);
+            args[i] = makeNode<UnaryExpr>(DEREF, args[i]);
+
+        // arrays passed as slices
+        if (params[i]->isSlice() && args[i]->getType(analyzer)->isArray()) {
+            args[i] = makeNode<SliceExpr>(args[i]);
+            args[i]->analyze(analyzer);
+        }
     }
+
+    // the callee gets a copy of a read-only symbol, writes through the reference can't reach it
+    copies.assign(args.size(), false);
+    for (size_t i = 0; i < args.size(); ++i)
+        copies[i] = params[i]->isReference() && getReadOnly(args[i]);
 }
 
-Type::Ptr CallExpr::getType(Analyzer::Ptr analyzer) const { return callee->getType(analyzer); }
+Type::Ptr CallExpr::inferType(const Analyzer::Ptr &analyzer) const {
+    const Type::Ptr type = callee->getType(analyzer);
+    return type && type->isFunction() ? std::static_pointer_cast<FunctionType>(type)->getReturnType() : type;
+}
 
 wyvern::Entity::Ptr CallExpr::generate(wyvern::Wrapper::Ptr context) {
+    if (folded)
+        return folded->generate(context);
+
     wyvern::Func::Ptr func = std::static_pointer_cast<wyvern::Func>(callee->generate(context));
 
     wyvern::Entity::Vec generated_args = {};
     for (const auto &arg : args)
         generated_args.push_back(arg->generate(context));
 
-    return func->call(generated_args);
+    // copied once every argument is evaluated, a self tail call's arguments may still read the parameters
+    const Type::Vec &params = std::static_pointer_cast<FunctionType>(callee->getType(nullptr))->getParameterTypes();
+    // in the entry block, a self tail call after a loop would otherwise allocate on every iteration once it's a loop itself
+    for (size_t i = 0; i < copies.size(); ++i)
+        if (copies[i]) {
+            const wyvern::Ty::Ptr &ty = std::static_pointer_cast<ReferenceType>(params[i])->getReferee()->generate(context);
+            llvm::Value *copy = entryAlloca(context, ty->getTy(), "arg.copy");
+            context->getBuilder()->CreateStore(context->typeCast(generated_args[i], ty)->getValuePtr(), copy);
+            generated_args[i] = wyvern::Val::create(context, params[i]->generate(context), copy);
+        }
+
+    auto ret = func->call(generated_args);
+
+    if (tail != TailCall::NONE)
+        if (auto val = std::dynamic_pointer_cast<wyvern::Val>(ret))
+            if (auto *call = llvm::dyn_cast<llvm::CallInst>(val->getValuePtr()))
+                call->setTailCallKind(tail == TailCall::SIBLING ? llvm::CallInst::TCK_MustTail : llvm::CallInst::TCK_Tail);
+
+    return ret;
+}
+
+void CallExpr::markTailCall(const Analyzer::Ptr &analyzer) {
+    const FunctionSymbol::Ptr &caller = analyzer->getCurrentFunction();
+
+    if (!caller || !callee || callee->kind() != AST::Symbol)
+        return;
+
+    const Symbol::Ptr &target = std::static_pointer_cast<SymbolExpr>(callee)->getSymbol();
+    if (!target || !target->isFunction())
+        return;
+
+    // the callee must not access the caller's stack, so anything carrying a pointer
+    // has to be one of the caller's own parameters passed on
+    const Type::Vec &params = std::static_pointer_cast<FunctionSymbol>(target)->getParameterTypes();
+    const std::vector<std::string> &forwardable = caller->getParameterNames();
+    const bool self = target == caller;
+
+    // self recursion becomes a loop in the same frame, references to anything else are copied into storage of
+    // the loop, unless a parameter is forwarded to another position and could then alias a copy
+    std::vector<bool> copied(args.size(), false);
+    bool moved = false;
+
+    for (size_t i = 0; i < args.size() && i < params.size(); ++i) {
+        if (!params[i]->isReference() && !params[i]->isPointer() && !params[i]->isSlice())
+            continue;
+
+        const auto found = args[i]->kind() == AST::Symbol
+            ? std::ranges::find(forwardable, std::static_pointer_cast<SymbolExpr>(args[i])->getName()) : forwardable.end();
+
+        if (self && params[i]->isReference()) {
+            copied[i] = found == forwardable.end();
+            moved |= !copied[i] && static_cast<size_t>(found - forwardable.begin()) != i;
+            continue;
+        }
+
+        if (found == forwardable.end())
+            return;
+    }
+
+    const bool copying = std::ranges::find(copied, true) != copied.end();
+    if (copying && moved)
+        return;
+
+    if (self) {
+        for (size_t i = 0; i < copied.size() && i < copies.size(); ++i)
+            copies[i] = copies[i] || copied[i];
+        tail = TailCall::SELF;
+    } else if (*target->getType() == *caller->getType())
+        tail = TailCall::SIBLING;
+    else
+        tail = TailCall::HINT;
 }
 
 std::string CallExpr::str() const {
@@ -130,18 +412,93 @@ std::string CallExpr::str() const {
 // BINARY EXPR
 
 BinaryExpr::BinaryExpr(const BinaryOp &op, Ptr LHS, Ptr RHS)
-: op(op), LHS(std::move(LHS)), RHS(std::move(RHS)) {}
+: op(op), LHS(std::move(LHS)), RHS(std::move(RHS)), operandType(nullptr), vectorType(nullptr), vectorLHS(false), vectorRHS(false) {}
 
 BinaryExpr::~BinaryExpr() = default;
 
-void BinaryExpr::analyze(Analyzer::Ptr analyzer) {}
+void BinaryExpr::analyze(Analyzer::Ptr analyzer) {
+    LHS->analyze(analyzer);
+    RHS->analyze(analyzer);
+
+    const Type::Ptr L = LHS->getType(analyzer);
+    const Type::Ptr R = RHS->getType(analyzer);
+    operandType = L;
+    vectorLHS = L && L->isVector();
+    vectorRHS = R && R->isVector();
+
+    if (!vectorLHS && !vectorRHS)
+        return;
+
+    if (isComparison(op))
+        throw std::invalid_argument("Cannot compare vectors " + (vectorLHS ? L : R)->str() + " with " + BinaryOpValue[op]);
+
+    if (vectorLHS && vectorRHS && *L != *R)
+        throw std::invalid_argument("Mismatched vector types " + L->str() + " and " + R->str());
+
+    vectorType = std::static_pointer_cast<VectorType>(vectorLHS ? L : R);
+
+    if (op == POW && !vectorType->isFloat())
+        throw std::invalid_argument("Cannot raise integer vector " + vectorType->str() + " to a power");
+}
+
+Type::Ptr BinaryExpr::inferType(const Analyzer::Ptr &analyzer) const {
+    if (isComparison(op))
+        return std::make_shared<Type>(Type::BOOL);
+
+    if (vectorType)
+        return vectorType;
+
+    // a scalar operand gets splatted to the vector
+    const Type::Ptr R = RHS->getType(analyzer);
+    if (R && R->isVector())
+        return R;
 
-Type::Ptr BinaryExpr::getType(Analyzer::Ptr analyzer) const { return LHS->getType(analyzer); }
+    return LHS->getType(analyzer);
+}
 
 wyvern::Entity::Ptr BinaryExpr::generate(wyvern::Wrapper::Ptr context) {
     wyvern::Entity::Ptr L = LHS->generate(context);
     wyvern::Entity::Ptr R = RHS->generate(context);
 
+    if (vectorType) {
+        auto builder = context->getBuilder();
+        const auto operand = [&](const wyvern::Entity::Ptr &entity, bool isVector) {
+            if (isVector)
+                return loadValue(context, entity, vectorType);
+
+            return builder->CreateVectorSplat(vectorType->getLanes(), loadValue(context, entity, vectorType->getElement()));
+        };
+
+        llvm::Value *VL = operand(L, vectorLHS);
+        llvm::Value *VR = operand(R, vectorRHS);
+        const bool isFloat = vectorType->isFloat();
+        llvm::Value *ret = nullptr;
+
+        switch (op) {
+            case ADD:   ret = isFloat ? builder->CreateFAdd(VL, VR) : builder->CreateAdd(VL, VR); break;
+            case SUB:   ret = isFloat ? builder->CreateFSub(VL, VR) : builder->CreateSub(VL, VR); break;
+            case MUL:   ret = isFloat ? builder->CreateFMul(VL, VR) : builder->CreateMul(VL, VR); break;
+            case DIV:
+                ret = isFloat ? builder->CreateFDiv(VL, VR)
+                    : vectorType->isSigned() ? builder->CreateSDiv(VL, VR) : builder->CreateUDiv(VL, VR);
+                break;
+            case POW: {
+                llvm::Function *powFunc = llvm::Intrinsic::getOrInsertDeclaration(context->getModule(), llvm::Intrinsic::pow, VL->getType());
+                ret = builder->CreateCall(powFunc, {VL, VR});
+                break;
+            }
+        }
+
+        return wyvern::Val::create(context, vectorType->generate(context), ret);
+    }
+
+    if (isComparison(op)) {
+        llvm::Value *VL = loadValue(context, L, operandType);
+        llvm::Value *VR = loadValue(context, R, operandType);
+        llvm::Value *ret = context->getBuilder()->CreateCmp(comparePredicate(op, operandType), VL, VR);
+        return wyvern::Val::create(context, context->getUnsignedTy(1), ret);
+    }
+
     switch (op) {
         case ADD: return context->binaryOp(wyvern::ADD, L, R);
         case SUB: return context->binaryOp(wyvern::SUB, L, R);
@@ -160,6 +517,21 @@ wyvern::Entity::Ptr BinaryExpr::generate(wyvern::Wrapper::Ptr context) {
     }
 }
 
+std::optional<Range> BinaryExpr::getRange(Analyzer::Ptr analyzer) const {
+    const std::optional<Range> L = LHS->getRange(analyzer);
+    const std::optional<Range> R = RHS->getRange(analyzer);
+
+    if (!L || !R)
+        return std::nullopt;
+
+    switch (op) {
+        case ADD:   return *L + *R;
+        case SUB:   return *L - *R;
+        case MUL:   return *L * *R;
+        default:    return std::nullopt;
+    }
+}
+
 std::string BinaryExpr::str() const {
     return "(" + LHS->str() + " " + BinaryOpValue[op]  + " " + RHS->str() + ")";
 }
@@ -170,9 +542,19 @@ UnaryExpr::UnaryExpr(const UnaryOp &op, Ptr expr) : op(op), expr(std::move(expr)
 
 UnaryExpr::~UnaryExpr() = default;
 
-void UnaryExpr::analyze(Analyzer::Ptr analyzer) {}
+void UnaryExpr::analyze(Analyzer::Ptr analyzer) {
+    expr->analyze(analyzer);
 
-Type::Ptr UnaryExpr::getType(Analyzer::Ptr analyzer) const { return expr->getType(analyzer); }
+    // a pointer to the counter could write to it
+    if (op == ADDR)
+        if (const Symbol *symbol = getReadOnly(expr))
+            throw std::invalid_argument("Cannot take the address of loop counter $" + symbol->getName());
+
+    if (op != ADDR && op != DEREF)
+        checkMutable(analyzer, expr);
+}
+
+Type::Ptr UnaryExpr::inferType(const Analyzer::Ptr &analyzer) const { return expr->getType(analyzer); }
 
 wyvern::Entity::Ptr UnaryExpr::generate(wyvern::Wrapper::Ptr context) {
     wyvern::Entity::Ptr gen = expr->generate(context);
@@ -198,10 +580,13 @@ wyvern::Entity::Ptr UnaryExpr::generate(wyvern::Wrapper::Ptr context) {
 
             return nullptr;
 
-        case POST_INC: {
+        case PRE_INC:
+        case PRE_DEC:
+        case POST_INC:
+        case POST_DEC: {
             // TODO: cater int type of 1 to the value that is added to
             auto value = context->typeCast(context->getInt(64, 1), context->getSignedTy(64));
-            auto increment = context->binaryOp(wyvern::ADD, gen, value);
+            auto increment = context->binaryOp(op == PRE_INC || op == POST_INC ? wyvern::ADD : wyvern::SUB, gen, value);
             if (gen->kind() == wyvern::Entity::LOCAL) {
                 context->storeValue(gen, increment);
                 return gen;
@@ -222,6 +607,446 @@ std::string UnaryExpr::str() const {
     return std::string(UnaryOpValue[op]) + "(" + expr->str() + ")";
 }
 
+// INDEX EXPR
+
+IndexExpr::IndexExpr(Ptr array, Ptr index)
+: array(std::move(array)), index(std::move(index)), arrayType(nullptr), indirect(false), checked(true) {}
+
+IndexExpr::~IndexExpr() = default;
+
+void IndexExpr::analyze(Analyzer::Ptr analyzer) {
+    array->analyze(analyzer);
+    index->analyze(analyzer);
+
+    arrayType = unwrapIndirection(array->getType(analyzer), indirect);
+
+    if (!arrayType->isArray() && !arrayType->isSlice())
+        throw std::invalid_argument("Cannot index into value of type " + arrayType->str());
+
+    // a slice would need a pointer and length per field
+    if (arrayType->isSlice() && isSoa())
+        throw std::invalid_argument("Cannot index into slice of @soa struct " + getType(analyzer)->str());
+
+    // the check can be dropped if the index is proven to be within the bounds,
+    // the length of a slice is only known at runtime
+    checked = true;
+    if (arrayType->isArray()) {
+        const auto size = static_cast<int64_t>(std::static_pointer_cast<ArrayType>(arrayType)->getSize());
+        const std::optional<Range> range = index->getRange(analyzer);
+        checked = !range || !range->within(0, size - 1);
+    }
+}
+
+Type::Ptr IndexExpr::inferType(const Analyzer::Ptr &analyzer) const {
+    bool discard;
+    const Type::Ptr type = arrayType ? arrayType : unwrapIndirection(array->getType(analyzer), discard);
+
+    if (type->isArray())
+        return std::static_pointer_cast<ArrayType>(type)->getElement();
+
+    if (type->isSlice())
+        return std::static_pointer_cast<SliceType>(type)->getElement();
+
+    return nullptr;
+}
+
+wyvern::Entity::Ptr IndexExpr::generate(wyvern::Wrapper::Ptr context) {
+    const Type::Ptr element = getType(nullptr);
+
+    if (isSoa())
+        throw std::invalid_argument("Elements of @soa arrays can only be accessed by field: " + str());
+
+    llvm::Value *address = generateAddress(context);
+    llvm::Value *loaded = context->getBuilder()->CreateLoad(element->generate(context)->getTy(), address);
+    return wyvern::Val::create(context, element->generate(context), loaded);
+}
+
+llvm::Value *IndexExpr::generateAddress(const wyvern::Wrapper::Ptr &context, std::optional<unsigned> field) {
+    auto builder = context->getBuilder();
+    wyvern::Entity::Ptr base = array->generate(context);
+    llvm::Value *position = context->typeCast(index->generate(context), context->getSignedTy(64))->getValuePtr();
+
+    if (arrayType->isArray()) {
+        const auto &cast = std::static_pointer_cast<ArrayType>(arrayType);
+        llvm::Value *address = arrayAddress(context, base, arrayType, indirect);
+
+        if (checked)
+            generateBoundsCheck(context, position, builder->getInt64(cast->getSize()));
+
+        // { [N x f0], [N x f1], ... }, the element's field is in the field's array
+        if (field)
+            return builder->CreateInBoundsGEP(arrayType->generate(context)->getTy(), address,
+                {builder->getInt64(0), builder->getInt32(*field), position});
+
+        return builder->CreateInBoundsGEP(arrayType->generate(context)->getTy(), address, {builder->getInt64(0), position});
+    }
+
+    const auto &cast = std::static_pointer_cast<SliceType>(arrayType);
+    llvm::Value *slice = indirect
+        ? builder->CreateLoad(arrayType->generate(context)->getTy(), loadValue(context, base, arrayType->generatePointerTo(context)))
+        : loadValue(context, base, arrayType);
+
+    if (checked)
+        generateBoundsCheck(context, position, builder->CreateExtractValue(slice, 1));
+
+    llvm::Value *data = builder->CreateExtractValue(slice, 0);
+    return builder->CreateInBoundsGEP(cast->getElement()->generate(context)->getTy(), data, position);
+}
+
+bool IndexExpr::isSoa() const {
+    if (!arrayType)
+        return false;
+
+    const Type::Ptr &element = arrayType->isArray()
+        ? std::static_pointer_cast<ArrayType>(arrayType)->getElement()
+        : std::static_pointer_cast<SliceType>(arrayType)->getElement();
+
+    return element->isStruct() && std::static_pointer_cast<StructType>(element)->getLayout().soa;
+}
+
+std::string IndexExpr::str() const { return array->str() + "[" + index->str() + "]"; }
+
+// MEMBER EXPR
+
+MemberExpr::MemberExpr(Ptr object, std::string field)
+: object(std::move(object)), field(std::move(field)), structType(nullptr), index(0), indirect(false), soa(false) {}
+
+MemberExpr::~MemberExpr() = default;
+
+void MemberExpr::analyze(Analyzer::Ptr analyzer) {
+    object->analyze(analyzer);
+
+    const Type::Ptr type = unwrapIndirection(object->getType(analyzer), indirect);
+
+    if (!type->isStruct())
+        throw std::invalid_argument("Cannot access field ." + field + " of value of type " + type->str());
+
+    structType = std::static_pointer_cast<StructType>(type);
+
+    const std::optional<size_t> found = structType->getFieldIndex(field);
+    if (!found)
+        throw std::invalid_argument("Struct " + structType->getName() + " has no field " + field);
+
+    index = *found;
+    soa = !indirect && object->kind() == AST::Index && std::static_pointer_cast<IndexExpr>(object)->isSoa();
+}
+
+Type::Ptr MemberExpr::inferType(const Analyzer::Ptr &analyzer) const {
+    bool discard;
+    const Type::Ptr type = structType ? structType : unwrapIndirection(object->getType(analyzer), discard);
+
+    if (!type->isStruct())
+        return nullptr;
+
+    const auto cast = std::static_pointer_cast<StructType>(type);
+    const std::optional<size_t> found = cast->getFieldIndex(field);
+    return found ? cast->getFields()[*found].type : nullptr;
+}
+
+wyvern::Entity::Ptr MemberExpr::generate(wyvern::Wrapper::Ptr context) {
+    const wyvern::Ty::Ptr type = getType(nullptr)->generate(context);
+    llvm::Value *loaded = context->getBuilder()->CreateLoad(type->getTy(), generateAddress(context));
+    return wyvern::Val::create(context, type, loaded);
+}
+
+llvm::Value *MemberExpr::generateAddress(const wyvern::Wrapper::Ptr &context) {
+    if (soa)
+        return std::static_pointer_cast<IndexExpr>(object)->generateAddress(context, static_cast<unsigned>(index));
+
+    // fields of elements and nested structs are addressed in place instead of copying the whole struct
+    llvm::Value *address;
+    if (indirect)
+        address = arrayAddress(context, object->generate(context), structType, true);
+    else if (object->kind() == AST::Index)
+        address = std::static_pointer_cast<IndexExpr>(object)->generateAddress(context);
+    else if (object->kind() == AST::Member)
+        address = std::static_pointer_cast<MemberExpr>(object)->generateAddress(context);
+    else
+        address = arrayAddress(context, object->generate(context), structType, false);
+
+    return context->getBuilder()->CreateStructGEP(structType->generate(context)->getTy(), address, structType->getElementIndex(index));
+}
+
+std::string MemberExpr::str() const { return object->str() + "." + field; }
+
+// SLICE EXPR
+
+SliceExpr::SliceExpr(Ptr array) : array(std::move(array)), arrayType(nullptr), indirect(false) {}
+
+SliceExpr::~SliceExpr() = default;
+
+void SliceExpr::analyze(Analyzer::Ptr analyzer) {
+    array->analyze(analyzer);
+
+    const Type::Ptr type = unwrapIndirection(array->getType(analyzer), indirect);
+
+    if (!type->isArray())
+        throw std::invalid_argument("Cannot create slice from value of type " + type->str());
+
+    if (const Type::Ptr &element = std::static_pointer_cast<ArrayType>(type)->getElement();
+        element->isStruct() && std::static_pointer_cast<StructType>(element)->getLayout().soa)
+        throw std::invalid_argument("Cannot create slice from array of @soa struct " + element->str());
+
+    arrayType = std::static_pointer_cast<ArrayType>(type);
+}
+
+Type::Ptr SliceExpr::inferType(const Analyzer::Ptr &analyzer) const {
+    bool discard;
+    const Type::Ptr type = arrayType ? arrayType : unwrapIndirection(array->getType(analyzer), discard);
+    return std::make_shared<SliceType>(std::static_pointer_cast<ArrayType>(type)->getElement());
+}
+
+wyvern::Entity::Ptr SliceExpr::generate(wyvern::Wrapper::Ptr context) {
+    auto builder = context->getBuilder();
+    const wyvern::Ty::Ptr sliceTy = getType(nullptr)->generate(context);
+
+    // the array's address is also the address of its first element
+    llvm::Value *slice = llvm::PoisonValue::get(sliceTy->getTy());
+    slice = builder->CreateInsertValue(slice, arrayAddress(context, array->generate(context), arrayType, indirect), 0);
+    slice = builder->CreateInsertValue(slice, builder->getInt64(arrayType->getSize()), 1);
+    return wyvern::Val::create(context, sliceTy, slice);
+}
+
+std::string SliceExpr::str() const { return "[](" + array->str() + ")"; }
+
+// BUILTIN EXPR
+
+BuiltinExpr::BuiltinExpr(const Builtin &builtin, Type::Ptr operandType, Vec args)
+: builtin(builtin), operandType(std::move(operandType)), args(std::move(args)), vectorType(nullptr), mask({}), checked(true) {}
+
+BuiltinExpr::~BuiltinExpr() = default;
+
+void BuiltinExpr::analyze(Analyzer::Ptr analyzer) {
+    for (auto &arg : args)
+        arg->analyze(analyzer);
+
+    const std::string name = std::string("@") + BuiltinName[builtin];
+
+    const auto expectOperands = [&](size_t count) {
+        if (args.size() != count)
+            throw std::invalid_argument(std::format("{} expects {} operands, got {}", name, count, args.size()));
+    };
+
+    const auto expectVector = [&](const Type::Ptr &type) {
+        if (!type || !type->isVector())
+            throw std::invalid_argument(name + " expects a vector, got " + (type ? type->str() : "nothing"));
+
+        return std::static_pointer_cast<VectorType>(type);
+    };
+
+    // lane indices known to be in range don't need a check
+    const auto checkLane = [&](const Ptr &lane) {
+        const std::optional<Range> range = lane->getRange(analyzer);
+        checked = !range || !range->within(0, static_cast<int64_t>(vectorType->getLanes()) - 1);
+    };
+
+    switch (builtin) {
+        case SPLAT:
+            expectOperands(1);
+            vectorType = expectVector(operandType);
+            break;
+
+        case LANES:
+            expectOperands(0);
+            vectorType = expectVector(operandType);
+            break;
+
+        case VECTOR_WIDTH:
+            expectOperands(0);
+            break;
+
+        case LANE:
+            expectOperands(2);
+            vectorType = expectVector(args[0]->getType(analyzer));
+            checkLane(args[1]);
+            break;
+
+        case WITH_LANE:
+            expectOperands(3);
+            vectorType = expectVector(args[0]->getType(analyzer));
+            checkLane(args[1]);
+            break;
+
+        case SHUFFLE: {
+            if (args.size() < 3)
+                throw std::invalid_argument(name + " expects two vectors and at least one lane index");
+            if (args.size() - 2 > VectorType::MAX_LANES)
+                throw std::invalid_argument(std::format("{} produces at most {} lanes", name, VectorType::MAX_LANES));
+
+            vectorType = expectVector(args[0]->getType(analyzer));
+            if (*args[1]->getType(analyzer) != *vectorType)
+                throw std::invalid_argument(name + " expects two vectors of type " + vectorType->str());
+
+            const auto limit = static_cast<int64_t>(vectorType->getLanes()) * 2 - 1;
+            mask.clear();
+
+            for (size_t i = 2; i < args.size(); ++i) {
+                const std::optional<Range> index = args[i]->getRange(analyzer);
+
+                if (!index || index->min != index->max || !index->within(0, limit))
+                    throw std::invalid_argument(std::format("{} lane indices must be constants between 0 and {}", name, limit));
+
+                mask.push_back(static_cast<int>(index->min));
+            }
+            break;
+        }
+
+        case REDUCE_ADD:
+        case REDUCE_MUL:
+        case REDUCE_MIN:
+        case REDUCE_MAX:
+            expectOperands(1);
+            vectorType = expectVector(args[0]->getType(analyzer));
+            break;
+
+        case NEW:
+            if (args.size() > 1)
+                throw std::invalid_argument(std::format("{} expects a type and an optional count, got {} operands", name, args.size() + 1));
+
+            if (analyzer->getArenas().empty())
+                throw std::invalid_argument(name + " is only allowed inside an @arena block");
+
+            if (!args.empty() && !args[0]->getType(analyzer)->isInteger())
+                throw std::invalid_argument(name + " expects an integer count");
+
+            arena = analyzer->getArenas().back();
+            break;
+    }
+}
+
+Type::Ptr BuiltinExpr::inferType(const Analyzer::Ptr &analyzer) const {
+    if (builtin == LANES || builtin == VECTOR_WIDTH)
+        return std::make_shared<Type>(Type::I64);
+
+    if (builtin == NEW)
+        return operandType->getPointerTo();
+
+    const VectorType::Ptr vector = vectorType ? vectorType
+        : std::dynamic_pointer_cast<VectorType>(builtin == SPLAT ? operandType : args.at(0)->getType(analyzer));
+
+    switch (builtin) {
+        case SPLAT:
+        case WITH_LANE: return vector;
+        case SHUFFLE:   return std::make_shared<VectorType>(vector->getElement(), mask.empty() ? args.size() - 2 : mask.size());
+        default:        return vector->getElement();
+    }
+}
+
+wyvern::Entity::Ptr BuiltinExpr::generate(wyvern::Wrapper::Ptr context) {
+    auto builder = context->getBuilder();
+    const auto lanes = static_cast<unsigned>(vectorType ? vectorType->getLanes() : 0);
+    llvm::Value *ret = nullptr;
+
+    const auto vector = [&](size_t arg) { return loadValue(context, args[arg]->generate(context), vectorType); };
+    const auto lane = [&](size_t arg) {
+        llvm::Value *index = context->typeCast(args[arg]->generate(context), context->getSignedTy(64))->getValuePtr();
+
+        if (checked)
+            generateBoundsCheck(context, index, builder->getInt64(lanes));
+
+        return index;
+    };
+
+    switch (builtin) {
+        case LANES:
+        case VECTOR_WIDTH:
+            return wyvern::Val::create(context, context->getSignedTy(64), builder->getInt64(evaluate()));
+
+        case NEW: {
+            llvm::Value *handle = std::static_pointer_cast<wyvern::Val>(arena->getStorage(context))->getValuePtr();
+            llvm::Value *count = args.empty() ? builder->getInt64(1)
+                : context->typeCast(args[0]->generate(context), context->getSignedTy(64))->getValuePtr();
+
+            ret = arena::allocate(context, handle, operandType->generate(context)->getTy(), count);
+            break;
+        }
+
+        case SPLAT:
+            ret = builder->CreateVectorSplat(lanes, loadValue(context, args[0]->generate(context), vectorType->getElement()));
+            break;
+
+        case LANE: {
+            llvm::Value *V = vector(0);
+            ret = builder->CreateExtractElement(V, lane(1));
+            break;
+        }
+
+        case WITH_LANE: {
+            llvm::Value *V = vector(0);
+            llvm::Value *index = lane(1);
+            ret = builder->CreateInsertElement(V, loadValue(context, args[2]->generate(context), vectorType->getElement()), index);
+            break;
+        }
+
+        case SHUFFLE: {
+            llvm::Value *A = vector(0);
+            llvm::Value *B = vector(1);
+            ret = builder->CreateShuffleVector(A, B, mask);
+            break;
+        }
+
+        case REDUCE_ADD:
+        case REDUCE_MUL:
+        case REDUCE_MIN:
+        case REDUCE_MAX: {
+            llvm::Value *V = vector(0);
+            llvm::Type *element = vectorType->getElement()->generate(context)->getTy();
+
+            if (!vectorType->isFloat()) {
+                switch (builtin) {
+                    case REDUCE_ADD:    ret = builder->CreateAddReduce(V); break;
+                    case REDUCE_MUL:    ret = builder->CreateMulReduce(V); break;
+                    case REDUCE_MIN:    ret = builder->CreateIntMinReduce(V, vectorType->isSigned()); break;
+                    default:            ret = builder->CreateIntMaxReduce(V, vectorType->isSigned()); break;
+                }
+                break;
+            }
+
+            switch (builtin) {
+                case REDUCE_ADD:    ret = builder->CreateFAddReduce(llvm::ConstantFP::getNegativeZero(element), V); break;
+                case REDUCE_MUL:    ret = builder->CreateFMulReduce(llvm::ConstantFP::get(element, 1.0), V); break;
+                case REDUCE_MIN:    ret = builder->CreateFPMinReduce(V); break;
+                default:            ret = builder->CreateFPMaxReduce(V); break;
+            }
+
+            // allow a tree reduction instead of a sequential one
+            llvm::cast<llvm::Instruction>(ret)->setHasAllowReassoc(true);
+            break;
+        }
+    }
+
+    return wyvern::Val::create(context, getType(nullptr)->generate(context), ret);
+}
+
+std::optional<Range> BuiltinExpr::getRange(Analyzer::Ptr analyzer) const {
+    if (builtin != LANES && builtin != VECTOR_WIDTH)
+        return std::nullopt;
+
+    const int64_t value = evaluate();
+    return Range{value, value};
+}
+
+int64_t BuiltinExpr::evaluate() const {
+    if (builtin == LANES)
+        return static_cast<int64_t>(std::static_pointer_cast<VectorType>(operandType)->getLanes());
+
+    const Type::Ptr scalar = operandType->isVector() ? std::static_pointer_cast<VectorType>(operandType)->getElement() : operandType;
+    return std::max<int64_t>(1, nativeVectorWidth(scalar->isFloat()) / scalarBits(scalar));
+}
+
+std::string BuiltinExpr::str() const {
+    std::stringstream ss;
+    ss << "@" << BuiltinName[builtin] << "(";
+
+    if (operandType)
+        ss << operandType->str() << (args.empty() ? "" : ", ");
+
+    for (size_t i = 0; i < args.size(); ++i)
+        ss << args[i]->str() << (i == args.size() - 1 ? "" : ", ");
+
+    ss << ")";
+    return ss.str();
+}
 
 // SYMBOL EXPR
 
@@ -229,13 +1054,30 @@ SymbolExpr::SymbolExpr(std::string name) : name(std::move(name)) {}
 
 SymbolExpr::~SymbolExpr() { name.clear(); }
 
-void SymbolExpr::analyze(Analyzer::Ptr analyzer) {}
+void SymbolExpr::analyze(Analyzer::Ptr analyzer) {
+    symbol = analyzer->lookup(name);
+}
 
-Type::Ptr SymbolExpr::getType(Analyzer::Ptr analyzer) const {
-    return analyzer->lookup(name)->getType();
+Type::Ptr SymbolExpr::inferType(const Analyzer::Ptr &analyzer) const {
+    return symbol ? symbol->getType() : nullptr;
+}
+
+std::optional<Range> SymbolExpr::getRange(Analyzer::Ptr analyzer) const {
+    return symbol ? symbol->getRange() : std::nullopt;
 }
 
 wyvern::Entity::Ptr SymbolExpr::generate(wyvern::Wrapper::Ptr context) {
+    // bound when the declaration was generated in this context
+    if (symbol)
+        if (const wyvern::Entity::Ptr &storage = symbol->getStorage(context))
+            return storage;
+
+    // prelude functions are only declared in modules that use them, instances of generic functions
+    // (bound under another name) are defined with their generic function and may be called before that
+    if (symbol && symbol->isFunction()
+        && (std::static_pointer_cast<FunctionSymbol>(symbol)->isExternal() || name != symbol->getName()))
+        return std::static_pointer_cast<FunctionSymbol>(symbol)->declare(context);
+
     if (auto func = context->getFunc(name, false))
         return func;
 
@@ -244,6 +1086,8 @@ wyvern::Entity::Ptr SymbolExpr::generate(wyvern::Wrapper::Ptr context) {
 
 std::string SymbolExpr::str() const { return name; }
 
+const std::string &SymbolExpr::getName() const { return name; }
+
 // VALUE EXPR
 
 ValueExpr::ValueExpr(const Token &token) {
@@ -265,10 +1109,33 @@ ValueExpr::ValueExpr(const Token &token) {
     }
 }
 
+ValueExpr::ValueExpr(Value::Ptr value) : value(std::move(value)) {}
+
 void ValueExpr::analyze(Analyzer::Ptr analyzer) {}
 
-Type::Ptr ValueExpr::getType(Analyzer::Ptr analyzer) const { return value->getType(); }
+Type::Ptr ValueExpr::inferType(const Analyzer::Ptr &analyzer) const { return value->getType(); }
+
+std::optional<Range> ValueExpr::getRange(Analyzer::Ptr analyzer) const {
+    if (const std::optional<int64_t> integer = value->getInteger())
+        return Range{*integer, *integer};
+
+    return std::nullopt;
+}
 
 wyvern::Entity::Ptr ValueExpr::generate(wyvern::Wrapper::Ptr context) { return value->generate(context); }
 
-std::string ValueExpr::str() const { return value->str(); }
\ No newline at end of file
+std::string ValueExpr::str() const { return value->str(); }
+
+// ERROR EXPR
+
+ErrorExpr::ErrorExpr() = default;
+
+ErrorExpr::~ErrorExpr() = default;
+
+void ErrorExpr::analyze(Analyzer::Ptr analyzer) {}
+
+Type::Ptr ErrorExpr::inferType(const Analyzer::Ptr &analyzer) const { return nullptr; }
+
+wyvern::Entity::Ptr ErrorExpr::generate(wyvern::Wrapper::Ptr context) { return context->getNull(); }
+
+std::string ErrorExpr::str() const { return "<error>"; }
\ No newline at end of file
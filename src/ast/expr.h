@@ -7,11 +7,28 @@
 #include "operation.h"
 #include "../parser/value.h"
 #include "../analyzer/analyzer.h"
+#include "../analyzer/range.h"
 
 class Expr : public Stmt {
 public:
     using Ptr = std::shared_ptr<Expr>;
     using Vec = std::vector<Ptr>;
+
+    // inferred once after the expression is analyzed, later calls return the cached type
+    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const final;
+
+    // forget the inferred type, the expression is about to be analyzed against other declarations
+    void clearType() { cachedType = nullptr; }
+
+    // bounds of the integer value this expression yields, if known at compile time
+    [[nodiscard]] virtual std::optional<Range> getRange(Analyzer::Ptr analyzer) const { return std::nullopt; }
+
+protected:
+    // compute the type from the analyzed operands, only called until it yields a type
+    [[nodiscard]] virtual Type::Ptr inferType(const Analyzer::Ptr &analyzer) const = 0;
+
+private:
+    mutable Type::Ptr cachedType;
 };
 
 class AssignmentExpr : public Expr {
@@ -20,31 +37,50 @@ public:
     ~AssignmentExpr() override;
 
     void analyze(Analyzer::Ptr analyzer) override;
-    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
     wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
 
     [[nodiscard]] constexpr AST kind() const override { return AST::Assignment; }
     [[nodiscard]] std::string str() const override;
 
+    [[nodiscard]] const Ptr &getAssignee() const { return assignee; }
+    [[nodiscard]] const Ptr &getValue() const { return value; }
+
 private:
+    [[nodiscard]] Type::Ptr inferType(const Analyzer::Ptr &analyzer) const override;
+
     Ptr assignee, value;
 };
 
 class BlockExpr : public Expr {
 public:
-    explicit BlockExpr(Stmt::Vec stmts);
+    // an arena block (@arena { ... }) owns a region that @new allocates from, released when the block is left
+    explicit BlockExpr(Stmt::Vec stmts, bool arena = false);
     ~BlockExpr() override;
 
     void analyze(Analyzer::Ptr analyzer) override;
-    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
     wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
 
     [[nodiscard]] constexpr AST kind() const override { return AST::Block; }
     [[nodiscard]] std::string str() const override;
 
+    [[nodiscard]] const Stmt::Vec &getStmts() const { return stmts; }
+    [[nodiscard]] bool isArena() const { return arena; }
+
 private:
+    [[nodiscard]] Type::Ptr inferType(const Analyzer::Ptr &analyzer) const override;
+
     Stmt::Vec stmts;
     bool yieldsValue; // is the block supposed to yield a value (expression)?
+    bool arena;
+    Symbol::Ptr handle; // the arena's runtime handle, bound to the generated value
+};
+
+// how a call in tail position is emitted
+enum class TailCall {
+    NONE,       // not in tail position
+    SELF,       // self recursion, rewritten into a loop, reference arguments that aren't forwarded are copied
+    SIBLING,    // matching prototype, emitted as musttail
+    HINT,       // emitted as tail, LLVM may still turn it into a jump
 };
 
 class CallExpr : public Expr {
@@ -53,15 +89,29 @@ public:
     ~CallExpr() override;
 
     void analyze(Analyzer::Ptr analyzer) override;
-    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
     wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
 
     [[nodiscard]] constexpr AST kind() const override { return AST::Call; }
     [[nodiscard]] std::string str() const override;
 
+    [[nodiscard]] const Ptr &getCallee() const { return callee; }
+    [[nodiscard]] const Vec &getArgs() const { return args; }
+
+    // the call is in tail position of the current function, decide how it can be emitted
+    void markTailCall(const Analyzer::Ptr &analyzer);
+
+    // result of a @comptime call evaluated by the compiler, generated instead of the call
+    [[nodiscard]] const Ptr &getFolded() const { return folded; }
+    void fold(Ptr value) { folded = std::move(value); }
+
 private:
+    [[nodiscard]] Type::Ptr inferType(const Analyzer::Ptr &analyzer) const override;
+
     Ptr callee;
     Vec args;
+    std::vector<bool> copies; // reference arguments passed as a copy, read-only symbols and self tail calls
+    TailCall tail;
+    Ptr folded;
 };
 
 class BinaryExpr : public Expr {
@@ -70,15 +120,25 @@ public:
     ~BinaryExpr() override;
 
     void analyze(Analyzer::Ptr analyzer) override;
-    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
     wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
 
+    [[nodiscard]] std::optional<Range> getRange(Analyzer::Ptr analyzer) const override;
+
     [[nodiscard]] constexpr AST kind() const override { return AST::Binary; }
     [[nodiscard]] std::string str() const override;
 
+    [[nodiscard]] BinaryOp getOp() const { return op; }
+    [[nodiscard]] const Ptr &getLHS() const { return LHS; }
+    [[nodiscard]] const Ptr &getRHS() const { return RHS; }
+
 private:
+    [[nodiscard]] Type::Ptr inferType(const Analyzer::Ptr &analyzer) const override;
+
     BinaryOp op;
     Ptr LHS, RHS;
+    Type::Ptr operandType;      // type operands of comparisons are converted to
+    VectorType::Ptr vectorType; // result type of SIMD operations
+    bool vectorLHS, vectorRHS;  // scalar operands of SIMD operations are splatted
 };
 
 class UnaryExpr : public Expr {
@@ -87,44 +147,191 @@ public:
     ~UnaryExpr() override;
 
     void analyze(Analyzer::Ptr analyzer) override;
-    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
     wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
 
     [[nodiscard]] constexpr AST kind() const override { return AST::Unary; }
     [[nodiscard]] std::string str() const override;
 
+    [[nodiscard]] UnaryOp getOp() const { return op; }
+    [[nodiscard]] const Ptr &getExpr() const { return expr; }
+
 private:
+    [[nodiscard]] Type::Ptr inferType(const Analyzer::Ptr &analyzer) const override;
+
     UnaryOp op;
     Ptr expr;
 };
 
+class IndexExpr : public Expr {
+public:
+    IndexExpr(Ptr array, Ptr index);
+    ~IndexExpr() override;
+
+    void analyze(Analyzer::Ptr analyzer) override;
+    wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
+
+    // get a pointer to the indexed element (bounds checked unless proven to be in range),
+    // elements of @soa arrays only have addresses per field
+    llvm::Value *generateAddress(const wyvern::Wrapper::Ptr &context, std::optional<unsigned> field = std::nullopt);
+
+    [[nodiscard]] constexpr AST kind() const override { return AST::Index; }
+    [[nodiscard]] std::string str() const override;
+
+    [[nodiscard]] const Ptr &getArray() const { return array; }
+    [[nodiscard]] const Ptr &getIndex() const { return index; }
+    // is the element a @soa struct stored as one array per field?
+    [[nodiscard]] bool isSoa() const;
+
+private:
+    [[nodiscard]] Type::Ptr inferType(const Analyzer::Ptr &analyzer) const override;
+
+    Ptr array, index;
+    Type::Ptr arrayType; // ArrayType or SliceType, resolved during analysis
+    bool indirect;       // is the array accessed through a reference or pointer?
+    bool checked;        // emit a bounds check?
+};
+
+// <object>.<field>, the object is a struct or a reference or pointer to one
+class MemberExpr : public Expr {
+public:
+    MemberExpr(Ptr object, std::string field);
+    ~MemberExpr() override;
+
+    void analyze(Analyzer::Ptr analyzer) override;
+    wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
+
+    // get a pointer to the field
+    llvm::Value *generateAddress(const wyvern::Wrapper::Ptr &context);
+
+    [[nodiscard]] constexpr AST kind() const override { return AST::Member; }
+    [[nodiscard]] std::string str() const override;
+
+    [[nodiscard]] const Ptr &getObject() const { return object; }
+    [[nodiscard]] const std::string &getField() const { return field; }
+
+private:
+    [[nodiscard]] Type::Ptr inferType(const Analyzer::Ptr &analyzer) const override;
+
+    Ptr object;
+    std::string field;
+    StructType::Ptr structType; // resolved during analysis
+    size_t index;               // of the field in structType
+    bool indirect;              // is the struct accessed through a reference or pointer?
+    bool soa;                   // is the object an element of a @soa array?
+};
+
+// implicit conversion of an array to a slice, inserted by the analyzer
+class SliceExpr : public Expr {
+public:
+    explicit SliceExpr(Ptr array);
+    ~SliceExpr() override;
+
+    void analyze(Analyzer::Ptr analyzer) override;
+    wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
+
+    [[nodiscard]] constexpr AST kind() const override { return AST::Slice; }
+    [[nodiscard]] std::string str() const override;
+
+    [[nodiscard]] const Ptr &getArray() const { return array; }
+
+private:
+    [[nodiscard]] Type::Ptr inferType(const Analyzer::Ptr &analyzer) const override;
+
+    Ptr array;
+    ArrayType::Ptr arrayType;
+    bool indirect;
+};
+
+class BuiltinExpr : public Expr {
+public:
+    BuiltinExpr(const Builtin &builtin, Type::Ptr operandType, Vec args);
+    ~BuiltinExpr() override;
+
+    void analyze(Analyzer::Ptr analyzer) override;
+    wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
+
+    [[nodiscard]] std::optional<Range> getRange(Analyzer::Ptr analyzer) const override;
+
+    [[nodiscard]] constexpr AST kind() const override { return AST::Builtin; }
+    [[nodiscard]] std::string str() const override;
+
+    [[nodiscard]] const Vec &getArgs() const { return args; }
+
+private:
+    [[nodiscard]] Type::Ptr inferType(const Analyzer::Ptr &analyzer) const override;
+
+    // value of @lanes and @vector_width, resolved at compile time
+    [[nodiscard]] int64_t evaluate() const;
+
+    Builtin builtin;
+    Type::Ptr operandType;      // type operand of @splat, @lanes and @vector_width
+    Vec args;
+    VectorType::Ptr vectorType; // vector operated on, resolved during analysis
+    std::vector<int> mask;      // lane indices of @shuffle
+    bool checked;               // bounds check runtime lane indices?
+    Symbol::Ptr arena;          // handle of the arena @new allocates from
+};
+
 class SymbolExpr : public Expr {
 public:
     explicit SymbolExpr(std::string name);
     ~SymbolExpr() override;
 
     void analyze(Analyzer::Ptr analyzer) override;
-    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
     wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
 
+    [[nodiscard]] std::optional<Range> getRange(Analyzer::Ptr analyzer) const override;
+
     [[nodiscard]] constexpr AST kind() const override { return AST::Symbol; }
     [[nodiscard]] std::string str() const override;
 
+    [[nodiscard]] const std::string &getName() const;
+    // symbol the name resolved to during analysis
+    [[nodiscard]] const Symbol::Ptr &getSymbol() const { return symbol; }
+    // bind the name to another symbol, e.g. a call to a generic function to its instance
+    void setSymbol(Symbol::Ptr symbol) { this->symbol = std::move(symbol); }
+
 private:
+    [[nodiscard]] Type::Ptr inferType(const Analyzer::Ptr &analyzer) const override;
+
     std::string name;
+    Symbol::Ptr symbol;
 };
 
 class ValueExpr : public Expr {
 public:
     explicit ValueExpr(const Token &token);
+    // constant computed by the compiler, e.g. the result of a @comptime call
+    explicit ValueExpr(Value::Ptr value);
 
     void analyze(Analyzer::Ptr analyzer) override;
-    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
     wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
 
+    [[nodiscard]] std::optional<Range> getRange(Analyzer::Ptr analyzer) const override;
+
     [[nodiscard]] constexpr AST kind() const override { return AST::Number; }
     [[nodiscard]] std::string str() const override;
 
+    [[nodiscard]] const Value::Ptr &getValue() const { return value; }
+
 private:
+    [[nodiscard]] Type::Ptr inferType(const Analyzer::Ptr &analyzer) const override;
+
     Value::Ptr value;
+};
+
+// placeholder for code that failed to parse, passes skip it
+class ErrorExpr : public Expr {
+public:
+    ErrorExpr();
+    ~ErrorExpr() override;
+
+    void analyze(Analyzer::Ptr analyzer) override;
+    wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
+
+    [[nodiscard]] constexpr AST kind() const override { return AST::Error; }
+    [[nodiscard]] std::string str() const override;
+
+private:
+    [[nodiscard]] Type::Ptr inferType(const Analyzer::Ptr &analyzer) const override;
 };
\ No newline at end of file
@@ -3,6 +3,101 @@
 #include <sstream>
 #include <utility>
 
+#include "visitor.h"
+#include "../parser/parser.h"
+
+// decide how calls returned directly are emitted, nested functions are left to their own analysis
+class TailCallMarker : public Visitor<TailCallMarker> {
+public:
+    explicit TailCallMarker(Analyzer::Ptr analyzer) : analyzer(std::move(analyzer)) {}
+
+    void visitFunction(Function &) {}
+
+    void visitReturn(ReturnStmt &node) {
+        // nothing happens between the call and the ret
+        if (node.getValue() && node.getValue()->kind() == AST::Call)
+            static_cast<CallExpr &>(*node.getValue()).markTailCall(analyzer);
+
+        visitChildren(node);
+    }
+
+private:
+    Analyzer::Ptr analyzer;
+};
+
+// turn self-recursive tail calls into a branch back to the start of the function,
+// the arguments become phis merging the initial values with the ones of each call,
+// copies made for reference parameters live in the entry block's allocas and are reused by every iteration
+static void eliminateTailRecursion(llvm::Function *function) {
+    llvm::SmallVector<llvm::CallInst *, 4> calls;
+
+    for (llvm::BasicBlock &block : *function)
+        for (llvm::Instruction &inst : block)
+            if (auto *call = llvm::dyn_cast<llvm::CallInst>(&inst))
+                if (call->getCalledFunction() == function && call->isTailCall()) {
+                    auto *ret = llvm::dyn_cast_or_null<llvm::ReturnInst>(call->getNextNode());
+                    if (ret && (!ret->getReturnValue() || ret->getReturnValue() == call))
+                        calls.push_back(call);
+                    else // may pass copies on the caller's stack, tail would claim it doesn't
+                        call->setTailCallKind(llvm::CallInst::TCK_None);
+                }
+
+    if (calls.empty())
+        return;
+
+    llvm::BasicBlock *loop = &function->getEntryBlock();
+    llvm::BasicBlock *entry = llvm::BasicBlock::Create(function->getContext(), "entry", function, loop);
+    loop->setName("tailrecurse");
+
+    // allocas have to stay in the entry block to remain static
+    for (auto it = loop->begin(); it != loop->end();) {
+        llvm::Instruction &inst = *it++;
+        if (llvm::isa<llvm::AllocaInst>(inst))
+            inst.moveBefore(*entry, entry->end());
+    }
+
+    llvm::BranchInst::Create(loop, entry);
+
+    llvm::IRBuilder<> builder(loop, loop->begin());
+    llvm::SmallVector<llvm::PHINode *, 4> phis;
+
+    for (llvm::Argument &arg : function->args()) {
+        llvm::PHINode *phi = builder.CreatePHI(arg.getType(), calls.size() + 1, arg.getName() + ".tr");
+        arg.replaceAllUsesWith(phi);
+        phi->addIncoming(&arg, entry);
+        phis.push_back(phi);
+    }
+
+    for (llvm::CallInst *call : calls) {
+        for (unsigned i = 0; i < call->arg_size(); ++i)
+            phis[i]->addIncoming(call->getArgOperand(i), call->getParent());
+
+        llvm::Instruction *ret = call->getNextNode();
+        llvm::BranchInst::Create(loop, ret);
+        ret->eraseFromParent();
+        call->eraseFromParent();
+    }
+}
+
+// musttail is only valid directly before a ret, and with matching prototypes and calling conventions,
+// anything else is demoted to a plain tail call hint
+static void verifyMustTailCalls(llvm::Function *function) {
+    for (llvm::BasicBlock &block : *function)
+        for (llvm::Instruction &inst : block) {
+            auto *call = llvm::dyn_cast<llvm::CallInst>(&inst);
+            if (!call || !call->isMustTailCall())
+                continue;
+
+            auto *ret = llvm::dyn_cast_or_null<llvm::ReturnInst>(call->getNextNode());
+            const bool valid = ret && (!ret->getReturnValue() || ret->getReturnValue() == call)
+                && call->getFunctionType() == function->getFunctionType()
+                && call->getCallingConv() == function->getCallingConv();
+
+            if (!valid)
+                call->setTailCallKind(llvm::CallInst::TCK_Tail);
+        }
+}
+
 /// PROTOTYPE
 
 FunctionPrototype::FunctionPrototype(std::string symbol, FunctionType::Ptr type, std::vector<std::string> parameters)
@@ -14,19 +109,20 @@ FunctionPrototype::~FunctionPrototype() {
 }
 
 void FunctionPrototype::analyze(Analyzer::Ptr analyzer) {
-    analyzer->insert(symbol, std::make_shared<FunctionSymbol>(analyzer, symbol, type, parameters));
+    declaration = std::make_shared<FunctionSymbol>(analyzer, symbol, type, parameters);
+    declaration->setLocation(location);
+    analyzer->insert(symbol, declaration);
 }
 
 Type::Ptr FunctionPrototype::getType(std::shared_ptr<Analyzer> analyzer) const { return type; }
 
 wyvern::Entity::Ptr FunctionPrototype::generate(wyvern::Wrapper::Ptr context) {
-    wyvern::Arg::Vec gen_args = {};
-    const auto &types = type->getParameterTypes();
+    wyvern::Func::Ptr func = context->declareFunction(type->getReturnType()->generate(context), symbol, type->generateArgs(context, parameters));
 
-    for (size_t i = 0; i < parameters.size(); ++i)
-        gen_args.push_back(wyvern::Arg::create(types[i]->generate(context), parameters[i]));
+    if (declaration)
+        declaration->setStorage(context, func);
 
-    return context->declareFunction(type->getReturnType()->generate(context), symbol, gen_args);
+    return func;
 }
 
 std::string FunctionPrototype::str() const {
@@ -64,29 +160,73 @@ Function::Function(const std::string &symbol, const FunctionType::Ptr &type, con
 : FunctionPrototype(symbol, type, parameters), body(std::move(body)) {}
 
 void Function::analyze(Analyzer::Ptr analyzer) {
-    analyzer->insert(symbol, std::make_shared<FunctionSymbol>(analyzer, symbol, type, parameters));
+    declare(analyzer);
+    analyzeBody(analyzer);
+}
 
-    if (body)
+void Function::declare(const Analyzer::Ptr &analyzer) {
+    declaration = std::make_shared<FunctionSymbol>(analyzer, symbol, type, parameters);
+    declaration->setLocation(location);
+    declaration->setDefinition(this);
+    analyzer->insert(symbol, declaration);
+}
+
+void Function::analyzeBody(const Analyzer::Ptr &analyzer) {
+    FunctionSymbol::Ptr enclosing = analyzer->getCurrentFunction();
+    Symbol::Vec enclosingArenas = analyzer->getArenas(); // not reachable from a nested function
+    analyzer->setCurrentFunction(declaration);
+    analyzer->setArenas({});
+    analyzer->enterScope();
+
+    const auto &types = type->getParameterTypes();
+    parameterSymbols.clear();
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        parameterSymbols.push_back(std::make_shared<Symbol>(analyzer, parameters[i], types[i]));
+        parameterSymbols.back()->setLocation(location); // parameters don't keep their own position
+        analyzer->insert(parameters[i], parameterSymbols.back());
+    }
+
+    if (body) {
         body->analyze(analyzer);
+        TailCallMarker(analyzer).visit(body);
+    }
+
+    analyzer->leaveScope();
+    analyzer->setArenas(std::move(enclosingArenas));
+    analyzer->setCurrentFunction(enclosing);
 }
 
 Type::Ptr Function::getType(std::shared_ptr<Analyzer> analyzer) const { return type; }
 
 wyvern::Entity::Ptr Function::generate(wyvern::Wrapper::Ptr context) {
-    wyvern::Arg::Vec gen_args = {};
-    const auto &types = type->getParameterTypes();
+    wyvern::Func::Ptr func = context->declareFunction(type->getReturnType()->generate(context), symbol, type->generateArgs(context, parameters), true);
 
-    for (size_t i = 0; i < parameters.size(); ++i)
-        gen_args.push_back(wyvern::Arg::create(types[i]->generate(context), parameters[i]));
+    // bind once per function, the body then reaches the arguments without name lookups
+    if (declaration)
+        declaration->setStorage(context, func);
+
+    if (!parameterSymbols.empty()) {
+        const auto parent = context->getCurrentParent();
+        for (size_t i = 0; i < parameterSymbols.size(); ++i)
+            parameterSymbols[i]->setStorage(context, (*parent)[parameters[i]]);
+    }
 
-    wyvern::Func::Ptr func = context->declareFunction(type->getReturnType()->generate(context), symbol, gen_args, true);
     body->generate(context);
+
+    if (llvm::Function *generated = context->getModule()->getFunction(symbol)) {
+        eliminateTailRecursion(generated);
+        verifyMustTailCalls(generated);
+    }
+
     return func;
 }
 
 std::string Function::str() const {
     std::stringstream ss;
 
+    if (comptime)
+        ss << "@comptime ";
+
     ss << symbol << "(";
 
     if (!type) {
@@ -113,4 +253,141 @@ std::string Function::str() const {
     ss << " " << body->str();
 
     return ss.str();
-}
\ No newline at end of file
+}
+
+/// GENERIC FUNCTION
+
+// match a declared parameter type against an argument's type, binding the type parameters in it
+static bool deduceType(const Type::Ptr &parameter, const Type::Ptr &argument, std::map<std::string, Type::Ptr> &deduced) {
+    switch (parameter->getKind()) {
+        case Type::GENERIC: {
+            Type::Ptr &bound = deduced[std::static_pointer_cast<GenericType>(parameter)->getName()];
+            if (!bound)
+                bound = argument;
+            return *bound == *argument;
+        }
+        case Type::REF:
+            return deduceType(std::static_pointer_cast<ReferenceType>(parameter)->getReferee(), argument, deduced);
+        case Type::PTR:
+            return argument->isPointer() && deduceType(std::static_pointer_cast<PointerType>(parameter)->getPointee(),
+                std::static_pointer_cast<PointerType>(argument)->getPointee(), deduced);
+        case Type::SLICE: {
+            const Type::Ptr &element = std::static_pointer_cast<SliceType>(parameter)->getElement();
+
+            // arrays are passed as slices
+            if (argument->isArray())
+                return deduceType(element, std::static_pointer_cast<ArrayType>(argument)->getElement(), deduced);
+
+            return argument->isSlice() && deduceType(element, std::static_pointer_cast<SliceType>(argument)->getElement(), deduced);
+        }
+        case Type::ARRAY: {
+            const auto array = std::static_pointer_cast<ArrayType>(parameter);
+            return argument->isArray() && std::static_pointer_cast<ArrayType>(argument)->getSize() == array->getSize()
+                && deduceType(array->getElement(), std::static_pointer_cast<ArrayType>(argument)->getElement(), deduced);
+        }
+        case Type::VECTOR: {
+            const auto vector = std::static_pointer_cast<VectorType>(parameter);
+            return argument->isVector() && std::static_pointer_cast<VectorType>(argument)->getLanes() == vector->getLanes()
+                && deduceType(vector->getElement(), std::static_pointer_cast<VectorType>(argument)->getElement(), deduced);
+        }
+        default:
+            return true; // no type parameters in it, checked like any other call
+    }
+}
+
+GenericFunction::GenericFunction(std::string symbol, std::vector<std::string> typeParameters, FunctionType::Ptr type,
+    std::vector<std::string> parameters, Token::Vec tokens, std::map<std::string, StructType::Ptr> structs)
+: symbol(std::move(symbol)), typeParameters(std::move(typeParameters)), type(std::move(type)), parameters(std::move(parameters)),
+  tokens(std::move(tokens)), structs(std::move(structs)) {}
+
+GenericFunction::~GenericFunction() {
+    instances.clear();
+    tokens.clear();
+}
+
+void GenericFunction::analyze(Analyzer::Ptr analyzer) {
+    declaration = std::make_shared<GenericSymbol>(analyzer, *this);
+    declaration->setLocation(location);
+    analyzer->insert(symbol, declaration);
+}
+
+Type::Ptr GenericFunction::getType(std::shared_ptr<Analyzer> analyzer) const { return type; }
+
+wyvern::Entity::Ptr GenericFunction::generate(wyvern::Wrapper::Ptr context) {
+    wyvern::Entity::Ptr ret = nullptr;
+
+    for (const auto &[name, instance] : instances) {
+        ret = instance->generate(context);
+
+        if (llvm::Function *generated = context->getModule()->getFunction(name))
+            generated->setLinkage(llvm::GlobalValue::LinkOnceODRLinkage);
+    }
+
+    return ret;
+}
+
+Type::Vec GenericFunction::deduce(const Type::Vec &arguments) const {
+    const Type::Vec &declared = type->getParameterTypes();
+
+    if (arguments.size() != declared.size())
+        throw std::invalid_argument(symbol + " takes " + std::to_string(declared.size()) + " arguments, "
+            + std::to_string(arguments.size()) + " given");
+
+    std::map<std::string, Type::Ptr> deduced = {};
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        Type::Ptr argument = arguments[i];
+        if (argument && argument->isReference())
+            argument = std::static_pointer_cast<ReferenceType>(argument)->getReferee();
+
+        if (!argument || !deduceType(declared[i], argument, deduced))
+            throw std::invalid_argument("Cannot pass " + (argument ? argument->str() : "value") + " as parameter "
+                + parameters[i] + " of " + symbol);
+    }
+
+    Type::Vec result = {};
+    for (const std::string &parameter : typeParameters) {
+        if (!deduced[parameter])
+            throw std::invalid_argument("Cannot deduce type parameter " + parameter + " of " + symbol);
+
+        result.push_back(deduced[parameter]);
+    }
+
+    return result;
+}
+
+std::shared_ptr<Function> GenericFunction::instantiate(const Type::Vec &arguments) const {
+    return std::static_pointer_cast<Function>(Parser::instantiate(tokens, structs, arguments));
+}
+
+void GenericFunction::addInstance(std::shared_ptr<Function> instance) {
+    const std::lock_guard lock(mutex);
+    instances[instance->getSymbol()] = std::move(instance);
+}
+
+std::string GenericFunction::mangle(const std::string &symbol, const Type::Vec &arguments) {
+    std::stringstream ss;
+
+    ss << symbol << "<";
+    for (size_t i = 0; i < arguments.size(); ++i)
+        ss << (i ? ", " : "") << arguments[i]->str();
+    ss << ">";
+
+    return ss.str();
+}
+
+std::string GenericFunction::str() const {
+    std::stringstream ss;
+
+    ss << symbol << "<";
+    for (size_t i = 0; i < typeParameters.size(); ++i)
+        ss << (i ? ", " : "") << typeParameters[i];
+    ss << ">(";
+
+    const auto &types = type->getParameterTypes();
+    for (size_t i = 0; i < parameters.size(); ++i)
+        ss << (i ? ", " : "") << parameters[i] << ": " << types[i]->str();
+
+    ss << ") -> " << type->getReturnType()->str();
+
+    return ss.str();
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include "stmt.h"
 #include "../analyzer/analyzer.h"
 
@@ -15,10 +17,16 @@ public:
     [[nodiscard]] constexpr AST kind() const override { return AST::FunctionPrototype; }
     [[nodiscard]] std::string str() const override;
 
+    [[nodiscard]] const std::string &getSymbol() const { return symbol; }
+    [[nodiscard]] const FunctionType::Ptr &getFunctionType() const { return type; }
+    [[nodiscard]] const std::vector<std::string> &getParameters() const { return parameters; }
+    [[nodiscard]] const FunctionSymbol::Ptr &getDeclaration() const { return declaration; }
+
 protected:
     std::string symbol;
     FunctionType::Ptr type;
     std::vector<std::string> parameters;
+    FunctionSymbol::Ptr declaration;
 };
 
 class Function : public FunctionPrototype {
@@ -29,9 +37,66 @@ public:
     Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
     wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
 
+    // analyze() in two steps, the analyzer declares all functions before analyzing any body
+    void declare(const Analyzer::Ptr &analyzer);
+    void analyzeBody(const Analyzer::Ptr &analyzer);
+
     [[nodiscard]] constexpr AST kind() const override { return AST::Function; }
     [[nodiscard]] std::string str() const override;
 
+    [[nodiscard]] const Stmt::Ptr &getBody() const { return body; }
+    [[nodiscard]] const std::vector<Symbol::Ptr> &getParameterSymbols() const { return parameterSymbols; }
+
+    // @comptime, calls with constant arguments are evaluated by the compiler
+    [[nodiscard]] bool isComptime() const { return comptime; }
+    void setComptime(bool comptime) { this->comptime = comptime; }
+
 private:
     Stmt::Ptr body;
+    std::vector<Symbol::Ptr> parameterSymbols;
+    bool comptime = false;
+};
+
+// <symbol><T, ...>(...) -> ..., every distinct list of type arguments gets its own Function,
+// parsed again from the declaration's tokens with the type parameters bound to the arguments
+class GenericFunction : public Stmt {
+public:
+    GenericFunction(std::string symbol, std::vector<std::string> typeParameters, FunctionType::Ptr type,
+        std::vector<std::string> parameters, Token::Vec tokens, std::map<std::string, StructType::Ptr> structs);
+    ~GenericFunction() override;
+
+    void analyze(Analyzer::Ptr analyzer) override;
+    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
+    // every instance, the linker keeps one copy of those generated in several modules
+    wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
+
+    // type arguments of a call with the given argument types, throws if one can't be deduced
+    [[nodiscard]] Type::Vec deduce(const Type::Vec &arguments) const;
+    // parse the function for the type arguments, it's named mangle(symbol, arguments)
+    [[nodiscard]] std::shared_ptr<Function> instantiate(const Type::Vec &arguments) const;
+    // keep an analyzed instance for code generation
+    void addInstance(std::shared_ptr<Function> instance);
+
+    // symbol of an instance, e.g. max<i64>
+    static std::string mangle(const std::string &symbol, const Type::Vec &arguments);
+
+    [[nodiscard]] constexpr AST kind() const override { return AST::Generic; }
+    [[nodiscard]] std::string str() const override;
+
+    [[nodiscard]] const std::string &getSymbol() const { return symbol; }
+    [[nodiscard]] const std::vector<std::string> &getTypeParameters() const { return typeParameters; }
+    [[nodiscard]] const FunctionType::Ptr &getFunctionType() const { return type; }
+    [[nodiscard]] const std::vector<std::string> &getParameters() const { return parameters; }
+    [[nodiscard]] const std::map<std::string, std::shared_ptr<Function>> &getInstances() const { return instances; }
+
+private:
+    std::string symbol;
+    std::vector<std::string> typeParameters;
+    FunctionType::Ptr type; // in terms of GenericType placeholders
+    std::vector<std::string> parameters;
+    Token::Vec tokens;
+    std::map<std::string, StructType::Ptr> structs; // the parser's structs, the declaration may name them
+    std::mutex mutex;
+    std::map<std::string, std::shared_ptr<Function>> instances; // by symbol
+    Symbol::Ptr declaration;
 };
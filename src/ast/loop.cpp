@@ -0,0 +1,268 @@
+#include "loop.h"
+
+#include <sstream>
+#include <utility>
+
+// LOOP HINTS
+
+std::string LoopHints::str() const {
+    std::stringstream ss;
+
+    if (unroll)
+        ss << "@unroll" << (unrollCount ? "(" + std::to_string(unrollCount) + ")" : "") << " ";
+
+    if (vectorize)
+        ss << "@vectorize" << (vectorizeWidth ? "(" + std::to_string(vectorizeWidth) + ")" : "") << " ";
+
+    return ss.str();
+}
+
+// LOOP STMT
+
+LoopStmt::LoopStmt(LoopHints hints) : hints(hints) {}
+
+void LoopStmt::setHints(const LoopHints &hints) { this->hints = hints; }
+
+void LoopStmt::generateBackedge(const wyvern::Wrapper::Ptr &context, llvm::BasicBlock *header) const {
+    auto builder = context->getBuilder();
+
+    // the body might have returned already
+    if (builder->GetInsertBlock()->getTerminator())
+        return;
+
+    llvm::BranchInst *backedge = builder->CreateBr(header);
+
+    if (hints.empty())
+        return;
+
+    llvm::LLVMContext &ctx = context->getModule()->getContext();
+    llvm::SmallVector<llvm::Metadata *, 4> properties = {nullptr}; // reserved for the self reference
+
+    const auto property = [&](const char *name, llvm::Constant *value = nullptr) {
+        if (value)
+            properties.push_back(llvm::MDNode::get(ctx, {llvm::MDString::get(ctx, name), llvm::ConstantAsMetadata::get(value)}));
+        else
+            properties.push_back(llvm::MDNode::get(ctx, {llvm::MDString::get(ctx, name)}));
+    };
+
+    if (hints.unroll) {
+        if (hints.unrollCount)
+            property("llvm.loop.unroll.count", builder->getInt32(hints.unrollCount));
+        else
+            property("llvm.loop.unroll.full");
+    }
+
+    if (hints.vectorize) {
+        property("llvm.loop.vectorize.enable", builder->getTrue());
+
+        if (hints.vectorizeWidth)
+            property("llvm.loop.vectorize.width", builder->getInt32(hints.vectorizeWidth));
+    }
+
+    llvm::MDNode *loop = llvm::MDNode::getDistinct(ctx, properties);
+    loop->replaceOperandWith(0, loop);
+    backedge->setMetadata(llvm::LLVMContext::MD_loop, loop);
+}
+
+llvm::Value *LoopStmt::generateCondition(const wyvern::Wrapper::Ptr &context, const Expr::Ptr &condition, const Type::Ptr &type) {
+    llvm::Value *value = context->typeCast(condition->generate(context), type->generate(context))->getValuePtr();
+
+    if (value->getType()->isIntegerTy(1))
+        return value;
+
+    if (value->getType()->isFloatingPointTy())
+        return context->getBuilder()->CreateFCmpONE(value, llvm::ConstantFP::get(value->getType(), 0.0));
+
+    return context->getBuilder()->CreateIsNotNull(value);
+}
+
+// WHILE STMT
+
+WhileStmt::WhileStmt(Expr::Ptr condition, Stmt::Ptr body, LoopHints hints)
+: LoopStmt(hints), condition(std::move(condition)), body(std::move(body)), conditionType(nullptr) {}
+
+WhileStmt::~WhileStmt() = default;
+
+void WhileStmt::analyze(Analyzer::Ptr analyzer) {
+    condition->analyze(analyzer);
+    conditionType = condition->getType(analyzer);
+
+    if (body)
+        body->analyze(analyzer);
+}
+
+Type::Ptr WhileStmt::getType(Analyzer::Ptr analyzer) const { return nullptr; }
+
+wyvern::Entity::Ptr WhileStmt::generate(wyvern::Wrapper::Ptr context) {
+    auto builder = context->getBuilder();
+    llvm::LLVMContext &ctx = context->getModule()->getContext();
+    llvm::Function *parent = builder->GetInsertBlock()->getParent();
+
+    llvm::BasicBlock *header = llvm::BasicBlock::Create(ctx, "while.cond", parent);
+    llvm::BasicBlock *loop = llvm::BasicBlock::Create(ctx, "while.body", parent);
+    llvm::BasicBlock *exit = llvm::BasicBlock::Create(ctx, "while.end", parent);
+
+    builder->CreateBr(header);
+
+    builder->SetInsertPoint(header);
+    builder->CreateCondBr(generateCondition(context, condition, conditionType), loop, exit);
+
+    builder->SetInsertPoint(loop);
+    if (body)
+        body->generate(context);
+    generateBackedge(context, header);
+
+    builder->SetInsertPoint(exit);
+    return context->getNull();
+}
+
+std::string WhileStmt::str() const {
+    return hints.str() + "while " + condition->str() + " " + (body ? body->str() : "{}");
+}
+
+// FOR STMT
+
+ForStmt::ForStmt(Stmt::Ptr init, Expr::Ptr condition, Expr::Ptr step, Stmt::Ptr body, LoopHints hints)
+: LoopStmt(hints), init(std::move(init)), condition(std::move(condition)), step(std::move(step)),
+  body(std::move(body)), conditionType(nullptr) {}
+
+ForStmt::~ForStmt() = default;
+
+void ForStmt::analyze(Analyzer::Ptr analyzer) {
+    analyzer->enterScope(); // init is only visible inside the loop
+
+    if (init)
+        init->analyze(analyzer);
+
+    if (condition) {
+        condition->analyze(analyzer);
+        conditionType = condition->getType(analyzer);
+    }
+
+    if (step)
+        step->analyze(analyzer);
+
+    if (body)
+        body->analyze(analyzer);
+
+    analyzer->leaveScope();
+}
+
+Type::Ptr ForStmt::getType(Analyzer::Ptr analyzer) const { return nullptr; }
+
+wyvern::Entity::Ptr ForStmt::generate(wyvern::Wrapper::Ptr context) {
+    auto builder = context->getBuilder();
+    llvm::LLVMContext &ctx = context->getModule()->getContext();
+    llvm::Function *parent = builder->GetInsertBlock()->getParent();
+
+    if (init)
+        init->generate(context);
+
+    llvm::BasicBlock *header = llvm::BasicBlock::Create(ctx, "for.cond", parent);
+    llvm::BasicBlock *loop = llvm::BasicBlock::Create(ctx, "for.body", parent);
+    llvm::BasicBlock *latch = llvm::BasicBlock::Create(ctx, "for.step", parent);
+    llvm::BasicBlock *exit = llvm::BasicBlock::Create(ctx, "for.end", parent);
+
+    builder->CreateBr(header);
+
+    builder->SetInsertPoint(header);
+    if (condition)
+        builder->CreateCondBr(generateCondition(context, condition, conditionType), loop, exit);
+    else
+        builder->CreateBr(loop);
+
+    builder->SetInsertPoint(loop);
+    if (body)
+        body->generate(context);
+    if (!builder->GetInsertBlock()->getTerminator())
+        builder->CreateBr(latch);
+
+    builder->SetInsertPoint(latch);
+    if (step)
+        step->generate(context);
+    generateBackedge(context, header);
+
+    builder->SetInsertPoint(exit);
+    return context->getNull();
+}
+
+std::string ForStmt::str() const {
+    return hints.str() + "for " + (init ? init->str() : "") + "; " + (condition ? condition->str() : "") + "; "
+        + (step ? step->str() : "") + " " + (body ? body->str() : "{}");
+}
+
+// RANGE FOR STMT
+
+RangeForStmt::RangeForStmt(std::string symbol, Expr::Ptr start, Expr::Ptr end, Stmt::Ptr body, LoopHints hints)
+: LoopStmt(hints), symbol(std::move(symbol)), start(std::move(start)), end(std::move(end)), body(std::move(body)) {}
+
+RangeForStmt::~RangeForStmt() { symbol.clear(); }
+
+void RangeForStmt::analyze(Analyzer::Ptr analyzer) {
+    start->analyze(analyzer);
+    end->analyze(analyzer);
+
+    analyzer->enterScope();
+
+    // inside the body the counter is within [start, end - 1], used to drop bounds checks
+    counter = std::make_shared<Symbol>(analyzer, symbol, std::make_shared<Type>(Type::I64));
+    counter->setLocation(location);
+    counter->setReadOnly(true);
+    const std::optional<Range> first = start->getRange(analyzer);
+    const std::optional<Range> last = end->getRange(analyzer);
+
+    if (first && last && last->max > INT64_MIN && first->min <= last->max - 1)
+        counter->setRange(Range{first->min, last->max - 1});
+
+    analyzer->insert(symbol, counter);
+
+    if (body)
+        body->analyze(analyzer);
+
+    analyzer->leaveScope();
+}
+
+Type::Ptr RangeForStmt::getType(Analyzer::Ptr analyzer) const { return nullptr; }
+
+wyvern::Entity::Ptr RangeForStmt::generate(wyvern::Wrapper::Ptr context) {
+    auto builder = context->getBuilder();
+    llvm::LLVMContext &ctx = context->getModule()->getContext();
+    llvm::Function *parent = builder->GetInsertBlock()->getParent();
+    const wyvern::Ty::Ptr ty = context->getSignedTy(64);
+
+    // bounds are evaluated once, the counter becomes the canonical induction variable after mem2reg
+    wyvern::Val::Ptr first = context->typeCast(start->generate(context), ty);
+    llvm::Value *last = context->typeCast(end->generate(context), ty)->getValuePtr();
+    wyvern::Entity::Ptr local = context->declareLocal(ty, symbol, first);
+    counter->setStorage(context, local);
+
+    llvm::BasicBlock *header = llvm::BasicBlock::Create(ctx, "range.cond", parent);
+    llvm::BasicBlock *loop = llvm::BasicBlock::Create(ctx, "range.body", parent);
+    llvm::BasicBlock *latch = llvm::BasicBlock::Create(ctx, "range.inc", parent);
+    llvm::BasicBlock *exit = llvm::BasicBlock::Create(ctx, "range.end", parent);
+
+    builder->CreateBr(header);
+
+    builder->SetInsertPoint(header);
+    llvm::Value *current = context->typeCast(local, ty)->getValuePtr();
+    builder->CreateCondBr(builder->CreateICmpSLT(current, last), loop, exit);
+
+    builder->SetInsertPoint(loop);
+    if (body)
+        body->generate(context);
+    if (!builder->GetInsertBlock()->getTerminator())
+        builder->CreateBr(latch);
+
+    builder->SetInsertPoint(latch);
+    // counter < end <= INT64_MAX, so the increment can't overflow
+    llvm::Value *next = builder->CreateNSWAdd(context->typeCast(local, ty)->getValuePtr(), builder->getInt64(1));
+    context->storeValue(local, wyvern::Val::create(context, ty, next));
+    generateBackedge(context, header);
+
+    builder->SetInsertPoint(exit);
+    return context->getNull();
+}
+
+std::string RangeForStmt::str() const {
+    return hints.str() + "for " + symbol + " in " + start->str() + ".." + end->str() + " " + (body ? body->str() : "{}");
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "expr.h"
+
+// optimization hints from @unroll and @vectorize, attached as llvm.loop metadata
+struct LoopHints {
+    static constexpr size_t MAX_UNROLL = 1024;
+
+    bool unroll = false;
+    size_t unrollCount = 0;     // 0 unrolls fully
+    bool vectorize = false;
+    size_t vectorizeWidth = 0;  // 0 lets the vectorizer choose
+
+    [[nodiscard]] constexpr bool empty() const { return !unroll && !vectorize; }
+    [[nodiscard]] std::string str() const;
+};
+
+class LoopStmt : public Stmt {
+public:
+    explicit LoopStmt(LoopHints hints);
+
+    void setHints(const LoopHints &hints);
+
+protected:
+    // branch from the latch back to the header, carrying the loop metadata
+    void generateBackedge(const wyvern::Wrapper::Ptr &context, llvm::BasicBlock *header) const;
+    // evaluate the condition as an i1
+    static llvm::Value *generateCondition(const wyvern::Wrapper::Ptr &context, const Expr::Ptr &condition, const Type::Ptr &type);
+
+    LoopHints hints;
+};
+
+class WhileStmt : public LoopStmt {
+public:
+    WhileStmt(Expr::Ptr condition, Stmt::Ptr body, LoopHints hints = {});
+    ~WhileStmt() override;
+
+    void analyze(Analyzer::Ptr analyzer) override;
+    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
+    wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
+
+    [[nodiscard]] constexpr AST kind() const override { return AST::While; }
+    [[nodiscard]] std::string str() const override;
+
+    [[nodiscard]] const Expr::Ptr &getCondition() const { return condition; }
+    [[nodiscard]] const Stmt::Ptr &getBody() const { return body; }
+
+private:
+    Expr::Ptr condition;
+    Stmt::Ptr body;
+    Type::Ptr conditionType;
+};
+
+class ForStmt : public LoopStmt {
+public:
+    ForStmt(Stmt::Ptr init, Expr::Ptr condition, Expr::Ptr step, Stmt::Ptr body, LoopHints hints = {});
+    ~ForStmt() override;
+
+    void analyze(Analyzer::Ptr analyzer) override;
+    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
+    wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
+
+    [[nodiscard]] constexpr AST kind() const override { return AST::For; }
+    [[nodiscard]] std::string str() const override;
+
+    [[nodiscard]] const Stmt::Ptr &getInit() const { return init; }
+    [[nodiscard]] const Expr::Ptr &getCondition() const { return condition; }
+    [[nodiscard]] const Expr::Ptr &getStep() const { return step; }
+    [[nodiscard]] const Stmt::Ptr &getBody() const { return body; }
+
+private:
+    Stmt::Ptr init;
+    Expr::Ptr condition, step;
+    Stmt::Ptr body;
+    Type::Ptr conditionType;
+};
+
+// for i in start..end, with i counting up from start (inclusive) to end (exclusive)
+class RangeForStmt : public LoopStmt {
+public:
+    RangeForStmt(std::string symbol, Expr::Ptr start, Expr::Ptr end, Stmt::Ptr body, LoopHints hints = {});
+    ~RangeForStmt() override;
+
+    void analyze(Analyzer::Ptr analyzer) override;
+    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
+    wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
+
+    [[nodiscard]] constexpr AST kind() const override { return AST::RangeFor; }
+    [[nodiscard]] std::string str() const override;
+
+    [[nodiscard]] const Expr::Ptr &getStart() const { return start; }
+    [[nodiscard]] const Expr::Ptr &getEnd() const { return end; }
+    [[nodiscard]] const Stmt::Ptr &getBody() const { return body; }
+    [[nodiscard]] const Symbol::Ptr &getCounter() const { return counter; }
+
+private:
+    std::string symbol;
+    Expr::Ptr start, end;
+    Stmt::Ptr body;
+    Symbol::Ptr counter;
+};
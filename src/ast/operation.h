@@ -1,11 +1,22 @@
 #pragma once
 
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <string>
+
 enum BinaryOp {
     ADD,    // addition
     SUB,    // subtraction
     MUL,    // multiplication
     DIV,    // division
     POW,    // power
+    LT,     // less than
+    GT,     // greater than
+    LTE,    // less than or equal
+    GTE,    // greater than or equal
+    EQ,     // equal
+    NEQ,    // not equal
 };
 
 enum UnaryOp {
@@ -23,10 +34,16 @@ inline const char *BinaryOpValue[] = {
     "*",
     "/",
     "^",
-    "/",
-    "^",
+    "<",
+    ">",
+    "<=",
+    ">=",
+    "==",
+    "!=",
 };
 
+constexpr bool isComparison(BinaryOp op) { return op >= LT; }
+
 inline const char *UnaryOpValue[] = {
     "&",
     "*",
@@ -34,4 +51,45 @@ inline const char *UnaryOpValue[] = {
     "--",
     "++",
     "--"
-};
\ No newline at end of file
+};
+
+// built-in functions, called as @name(...)
+enum Builtin {
+    SPLAT,          // @splat(T, x): broadcast scalar to all lanes
+    LANES,          // @lanes(T): number of lanes of a vector type
+    VECTOR_WIDTH,   // @vector_width(T): lanes of T that fit the target's widest vector register
+    LANE,           // @lane(v, i): extract lane
+    WITH_LANE,      // @with_lane(v, i, x): v with lane i replaced by x
+    SHUFFLE,        // @shuffle(a, b, i...): select lanes of a and b by constant indices
+    REDUCE_ADD,     // @reduce_add(v): horizontal sum
+    REDUCE_MUL,     // @reduce_mul(v): horizontal product
+    REDUCE_MIN,     // @reduce_min(v): horizontal minimum
+    REDUCE_MAX,     // @reduce_max(v): horizontal maximum
+    NEW,            // @new(T) or @new(T, n): zeroed T (or n of them) in the innermost @arena block, returns *T
+};
+
+inline const char *BuiltinName[] = {
+    "splat",
+    "lanes",
+    "vector_width",
+    "lane",
+    "with_lane",
+    "shuffle",
+    "reduce_add",
+    "reduce_mul",
+    "reduce_min",
+    "reduce_max",
+    "new",
+};
+
+inline std::optional<Builtin> getBuiltin(const std::string &name) {
+    const auto found = std::find(std::begin(BuiltinName), std::end(BuiltinName), name);
+
+    if (found == std::end(BuiltinName))
+        return std::nullopt;
+
+    return static_cast<Builtin>(found - std::begin(BuiltinName));
+}
+
+// does the builtin take a type as its first operand?
+constexpr bool takesType(Builtin builtin) { return builtin == SPLAT || builtin == LANES || builtin == VECTOR_WIDTH || builtin == NEW; }
\ No newline at end of file
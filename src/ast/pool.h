@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// fixed size slots carved out of large chunks, every node type gets its own pool,
+// so nodes of the same kind end up next to each other and tree walks stay in cache
+template<typename T>
+class NodePool {
+public:
+    static NodePool &get() {
+        // never destroyed, nodes may still be released during static destruction
+        static auto *pool = new NodePool();
+        return *pool;
+    }
+
+    void *allocate() {
+        std::lock_guard lock(mutex);
+
+        if (!free)
+            grow();
+
+        Slot *slot = free;
+        free = slot->next;
+        return slot;
+    }
+
+    void deallocate(void *ptr) {
+        std::lock_guard lock(mutex);
+
+        auto *slot = static_cast<Slot *>(ptr);
+        slot->next = free;
+        free = slot;
+    }
+
+private:
+    union Slot {
+        Slot *next;
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    static constexpr size_t CHUNK_SIZE = 256; // slots per chunk
+
+    void grow() {
+        chunks.push_back(std::make_unique<Slot[]>(CHUNK_SIZE));
+        Slot *chunk = chunks.back().get();
+
+        // link backwards, so slots are handed out in address order
+        for (size_t i = CHUNK_SIZE; i-- > 0;) {
+            chunk[i].next = free;
+            free = &chunk[i];
+        }
+    }
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    Slot *free = nullptr;
+};
+
+// allocator handing out single objects from their NodePool, arrays fall back to the heap
+template<typename T>
+struct PoolAllocator {
+    using value_type = T;
+
+    PoolAllocator() = default;
+    template<typename U>
+    constexpr PoolAllocator(const PoolAllocator<U> &) noexcept {}
+
+    T *allocate(size_t n) {
+        if (n != 1)
+            return std::allocator<T>().allocate(n);
+
+        return static_cast<T *>(NodePool<T>::get().allocate());
+    }
+
+    void deallocate(T *ptr, size_t n) {
+        if (n != 1)
+            std::allocator<T>().deallocate(ptr, n);
+        else
+            NodePool<T>::get().deallocate(ptr);
+    }
+
+    template<typename U>
+    constexpr bool operator==(const PoolAllocator<U> &) const noexcept { return true; }
+};
+
+// create an AST node in the pool of its kind, the shared_ptr control block lives in the same slot
+template<typename T, typename... Args>
+std::shared_ptr<T> makeNode(Args &&...args) {
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
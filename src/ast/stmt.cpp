@@ -1,6 +1,9 @@
+#include <ranges>
 #include <sstream>
 #include "stmt.h"
+#include "arena.h"
 #include "expr.h"
+#include "../parser/literal.h"
 #include "../analyzer/analyzer.h"
 
 // STMT
@@ -17,6 +20,11 @@ void Root::addStmt(Stmt::Ptr stmt) {
     program.push_back(std::move(stmt));
 }
 
+void Root::replaceStmts(size_t first, size_t count, const Vec &stmts) {
+    program.erase(program.begin() + first, program.begin() + first + count);
+    program.insert(program.begin() + first, stmts.begin(), stmts.end());
+}
+
 void Root::analyze(Analyzer::Ptr analyzer) {
     auto it = program.begin();
     while (it != program.end()) {
@@ -38,6 +46,8 @@ wyvern::Entity::Ptr Root::generate(wyvern::Wrapper::Ptr context) {
     for (const auto &stmt : program)
         ret = stmt->generate(context);
 
+    LiteralPool::release(context);
+
     return ret; // might be temporary, added this for basic testing
 }
 
@@ -64,18 +74,31 @@ void VariableStmt::analyze(Analyzer::Ptr analyzer) {
     if (type) type->analyze(analyzer);
     if (value) value->analyze(analyzer);
 
-    if (*value->getType(analyzer) != *type) {
+    if (value && *value->getType(analyzer) != *type) {
+        if (type->isSlice() && value->getType(analyzer)->isArray()) {
+            value = makeNode<SliceExpr>(value);
+            value->analyze(analyzer);
+        }
+
         // insert type cast
     }
 
-    analyzer->insert(symbol, std::make_shared<Symbol>(analyzer, symbol, type));
+    declaration = std::make_shared<Symbol>(analyzer, symbol, type);
+    declaration->setLocation(location);
+    analyzer->insert(symbol, declaration);
 }
 
 Type::Ptr VariableStmt::getType(Analyzer::Ptr analyzer) const { return type; }
 
 wyvern::Entity::Ptr VariableStmt::generate(wyvern::Wrapper::Ptr context) {
     auto val = value ? value->generate(context) : nullptr;
-    return context->declareLocal(type->generate(context), symbol, val);
+    wyvern::Entity::Ptr local = context->declareLocal(type->generate(context), symbol, val);
+
+    // uses of the variable get the local directly instead of looking it up by name
+    if (declaration)
+        declaration->setStorage(context, local);
+
+    return local;
 }
 
 std::string VariableStmt::str() const {
@@ -102,18 +125,118 @@ ReturnStmt::ReturnStmt(Expr::Ptr value) : value(std::move(value)) {}
 ReturnStmt::~ReturnStmt() = default;
 
 void ReturnStmt::analyze(Analyzer::Ptr analyzer) {
-    if (value) value->analyze(analyzer);
+    arenas = analyzer->getArenas();
+
+    if (!value)
+        return;
+
+    value->analyze(analyzer);
 }
 
 Type::Ptr ReturnStmt::getType(Analyzer::Ptr analyzer) const { return value->getType(analyzer); }
 
 wyvern::Entity::Ptr ReturnStmt::generate(wyvern::Wrapper::Ptr context) {
-    if (!value)
+    wyvern::Entity::Ptr result = value ? value->generate(context) : nullptr;
+
+    // the value is computed first, it may still read from the arenas
+    for (const auto &arena : arenas | std::views::reverse)
+        arena::destroy(context, std::static_pointer_cast<wyvern::Val>(arena->getStorage(context))->getValuePtr());
+
+    if (!result)
         return wyvern::Val::create(context, context->createRetVoid());
 
-    return wyvern::Val::create(context, context->createRet(value->generate(context)));
+    return wyvern::Val::create(context, context->createRet(result));
 }
 
 std::string ReturnStmt::str() const {
     return "ret" + (value ? " " + value->str() : "");
-}
\ No newline at end of file
+}
+
+// IMPORT STMT
+
+ImportStmt::ImportStmt(std::string module) : module(std::move(module)) {}
+
+ImportStmt::~ImportStmt() { symbols.clear(); }
+
+void ImportStmt::analyze(Analyzer::Ptr analyzer) {
+    symbols.clear();
+
+    for (const Interface::Export &entry : analyzer->import(module)->getExports()) {
+        auto symbol = std::make_shared<FunctionSymbol>(analyzer, entry.name, entry.type, entry.parameters);
+        symbol->setLocation(location);
+        symbol->setExternal(true);
+        analyzer->insert(entry.name, symbol);
+        symbols.push_back(std::move(symbol));
+    }
+}
+
+Type::Ptr ImportStmt::getType(Analyzer::Ptr) const { return nullptr; }
+
+wyvern::Entity::Ptr ImportStmt::generate(wyvern::Wrapper::Ptr context) {
+    wyvern::Entity::Ptr ret = nullptr;
+
+    // same declarations a prototype in the source would produce
+    for (const auto &symbol : symbols)
+        ret = std::static_pointer_cast<FunctionSymbol>(symbol)->declare(context);
+
+    return ret;
+}
+
+std::string ImportStmt::str() const { return "import " + module; }
+
+// STRUCT STMT
+
+StructStmt::StructStmt(StructType::Ptr type) : type(std::move(type)) {}
+
+StructStmt::~StructStmt() = default;
+
+void StructStmt::analyze(Analyzer::Ptr analyzer) {
+    const StructType::Layout &layout = type->getLayout();
+
+    if (layout.align & (layout.align - 1))
+        throw std::invalid_argument("Alignment of struct " + type->getName() + " must be a power of two");
+
+    if (layout.packed && layout.align)
+        throw std::invalid_argument("Struct " + type->getName() + " cannot be both @packed and @align");
+
+    for (size_t i = 0; i < type->getFields().size(); ++i) {
+        const StructType::Field &field = type->getFields()[i];
+        field.type->analyze(analyzer);
+
+        if (field.type->getKind() == Type::VOID || field.type->getKind() == Type::AUTO)
+            throw std::invalid_argument("Field " + type->getName() + "." + field.name + " needs a concrete type");
+
+        if (type->getFieldIndex(field.name) != i)
+            throw std::invalid_argument("Duplicate field " + type->getName() + "." + field.name);
+    }
+
+    // directly, through arrays or through other structs
+    if (type->contains(*type))
+        throw std::invalid_argument("Struct " + type->getName() + " cannot contain itself");
+}
+
+Type::Ptr StructStmt::getType(Analyzer::Ptr) const { return nullptr; }
+
+wyvern::Entity::Ptr StructStmt::generate(wyvern::Wrapper::Ptr context) {
+    type->generate(context);
+    return nullptr;
+}
+
+std::string StructStmt::str() const {
+    const StructType::Layout &layout = type->getLayout();
+    std::stringstream ss;
+
+    if (layout.packed)
+        ss << "@packed ";
+    if (layout.align)
+        ss << "@align(" << layout.align << ") ";
+    if (layout.soa)
+        ss << "@soa ";
+
+    ss << "struct " << type->getName() << " { ";
+    for (const StructType::Field &field : type->getFields())
+        ss << field.name << ": " << field.type->str() << ", ";
+    ss << "}";
+
+    return ss.str();
+}
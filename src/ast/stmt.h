@@ -4,26 +4,39 @@
 #include <vector>
 #include "../wyvern/src/wyvern.hpp"
 #include "../parser/type.h"
+#include "pool.h"
 
 class Analyzer;
 class Expr;
+class Symbol;
 
 enum class AST {
     Stmt,
     Root,
     FunctionPrototype,
     Function,
+    Generic,
     Variable,
     Return,
+    Import,
+    Struct,
+    While,
+    For,
+    RangeFor,
     Expr,
     Assignment,
     Block,
     Call,
     Binary,
     Unary,
+    Index,
+    Member,
+    Slice,
+    Builtin,
     Symbol,
     Number,
     Literal,
+    Error,
 };
 
 class Stmt {
@@ -40,7 +53,27 @@ public:
     [[nodiscard]] virtual constexpr AST kind() const { return AST::Stmt; }
     [[nodiscard]] virtual std::string str() const = 0;
 
+    // where the node's name starts, set by the parser for symbols and declarations
+    [[nodiscard]] const Location &getLocation() const { return location; }
+    void setLocation(const Location &location) { this->location = location; }
+
     constexpr bool isExpr() const { return kind() >= AST::Expr; }
+    // statements ending with a '}' aren't followed by a ';'
+    constexpr bool endsWithBlock() const {
+        switch (kind()) {
+            case AST::Function:
+            case AST::Generic:
+            case AST::Struct:
+            case AST::While:
+            case AST::For:
+            case AST::RangeFor:
+            case AST::Block:    return true;
+            default:            return false;
+        }
+    }
+
+protected:
+    Location location;
 };
 
 class Root : public Stmt {
@@ -51,6 +84,10 @@ public:
     ~Root() override;
 
     void addStmt(Stmt::Ptr stmt);
+    // replace count statements starting at first, used to splice in re-parsed statements
+    void replaceStmts(size_t first, size_t count, const Vec &stmts);
+
+    [[nodiscard]] const Vec &getProgram() const { return program; }
 
     void analyze(std::shared_ptr<Analyzer> analyzer) override;
     Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
@@ -75,10 +112,15 @@ public:
     [[nodiscard]] constexpr AST kind() const override { return AST::Variable; }
     [[nodiscard]] std::string str() const override;
 
+    [[nodiscard]] const std::string &getSymbol() const { return symbol; }
+    [[nodiscard]] const std::shared_ptr<Expr> &getValue() const { return value; }
+    [[nodiscard]] const std::shared_ptr<Symbol> &getDeclaration() const { return declaration; }
+
 private:
     std::string symbol;
     Type::Ptr type;
     std::shared_ptr<Expr> value;
+    std::shared_ptr<Symbol> declaration;
 };
 
 class ReturnStmt : public Stmt {
@@ -93,6 +135,49 @@ public:
     [[nodiscard]] constexpr AST kind() const override { return AST::Return; }
     [[nodiscard]] std::string str() const override;
 
+    [[nodiscard]] const std::shared_ptr<Expr> &getValue() const { return value; }
+
 private:
     std::shared_ptr<Expr> value;
-};
\ No newline at end of file
+    std::vector<std::shared_ptr<Symbol>> arenas; // @arena blocks left by the return, released before it
+};
+
+// import <module>; declares the exports of <module>.lymi without touching the module's source
+class ImportStmt : public Stmt {
+public:
+    explicit ImportStmt(std::string module);
+    ~ImportStmt() override;
+
+    void analyze(std::shared_ptr<Analyzer> analyzer) override;
+    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
+    wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
+
+    [[nodiscard]] constexpr AST kind() const override { return AST::Import; }
+    [[nodiscard]] std::string str() const override;
+
+    [[nodiscard]] const std::string &getModule() const { return module; }
+    [[nodiscard]] const std::vector<std::shared_ptr<Symbol>> &getSymbols() const { return symbols; }
+
+private:
+    std::string module;
+    std::vector<std::shared_ptr<Symbol>> symbols; // one FunctionSymbol per export
+};
+
+// struct <name> { <field>: <type>, ... } with optional @packed, @align(N) and @soa annotations
+class StructStmt : public Stmt {
+public:
+    explicit StructStmt(StructType::Ptr type);
+    ~StructStmt() override;
+
+    void analyze(std::shared_ptr<Analyzer> analyzer) override;
+    Type::Ptr getType(std::shared_ptr<Analyzer> analyzer) const override;
+    wyvern::Entity::Ptr generate(wyvern::Wrapper::Ptr context) override;
+
+    [[nodiscard]] constexpr AST kind() const override { return AST::Struct; }
+    [[nodiscard]] std::string str() const override;
+
+    [[nodiscard]] const StructType::Ptr &getStructType() const { return type; }
+
+private:
+    StructType::Ptr type;
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "stmt.h"
+#include "expr.h"
+#include "function.h"
+#include "loop.h"
+
+// call f on every direct child of the node, in evaluation order
+template<typename F>
+void forEachChild(Stmt &node, F &&f) {
+    const auto each = [&](const auto &child) {
+        if (child)
+            f(*child);
+    };
+
+    switch (node.kind()) {
+        case AST::Root:
+            for (const auto &stmt : static_cast<Root &>(node).getProgram())
+                each(stmt);
+            break;
+        case AST::Function:
+            each(static_cast<Function &>(node).getBody());
+            break;
+        case AST::Variable:
+            each(static_cast<VariableStmt &>(node).getValue());
+            break;
+        case AST::Return:
+            each(static_cast<ReturnStmt &>(node).getValue());
+            break;
+        case AST::While: {
+            auto &loop = static_cast<WhileStmt &>(node);
+            each(loop.getCondition());
+            each(loop.getBody());
+            break;
+        }
+        case AST::For: {
+            auto &loop = static_cast<ForStmt &>(node);
+            each(loop.getInit());
+            each(loop.getCondition());
+            each(loop.getBody());
+            each(loop.getStep());
+            break;
+        }
+        case AST::RangeFor: {
+            auto &loop = static_cast<RangeForStmt &>(node);
+            each(loop.getStart());
+            each(loop.getEnd());
+            each(loop.getBody());
+            break;
+        }
+        case AST::Assignment: {
+            auto &assignment = static_cast<AssignmentExpr &>(node);
+            each(assignment.getAssignee());
+            each(assignment.getValue());
+            break;
+        }
+        case AST::Block:
+            for (const auto &stmt : static_cast<BlockExpr &>(node).getStmts())
+                each(stmt);
+            break;
+        case AST::Call: {
+            auto &call = static_cast<CallExpr &>(node);
+            each(call.getCallee());
+            for (const auto &arg : call.getArgs())
+                each(arg);
+            break;
+        }
+        case AST::Binary: {
+            auto &binary = static_cast<BinaryExpr &>(node);
+            each(binary.getLHS());
+            each(binary.getRHS());
+            break;
+        }
+        case AST::Unary:
+            each(static_cast<UnaryExpr &>(node).getExpr());
+            break;
+        case AST::Index: {
+            auto &index = static_cast<IndexExpr &>(node);
+            each(index.getArray());
+            each(index.getIndex());
+            break;
+        }
+        case AST::Member:
+            each(static_cast<MemberExpr &>(node).getObject());
+            break;
+        case AST::Slice:
+            each(static_cast<SliceExpr &>(node).getArray());
+            break;
+        case AST::Builtin:
+            for (const auto &arg : static_cast<BuiltinExpr &>(node).getArgs())
+                each(arg);
+            break;
+        default:
+            break;
+    }
+}
+
+// AST walker dispatching on kind() instead of a virtual method per pass (CRTP),
+// Derived hides the visit methods it cares about, the others just descend into the children
+template<typename Derived, typename Result = void>
+class Visitor {
+public:
+    Result visit(Stmt &node) {
+        switch (node.kind()) {
+            case AST::Root:                 return derived().visitRoot(static_cast<Root &>(node));
+            case AST::FunctionPrototype:    return derived().visitFunctionPrototype(static_cast<FunctionPrototype &>(node));
+            case AST::Function:             return derived().visitFunction(static_cast<Function &>(node));
+            case AST::Generic:              return derived().visitGeneric(static_cast<GenericFunction &>(node));
+            case AST::Variable:             return derived().visitVariable(static_cast<VariableStmt &>(node));
+            case AST::Return:               return derived().visitReturn(static_cast<ReturnStmt &>(node));
+            case AST::Import:               return derived().visitImport(static_cast<ImportStmt &>(node));
+            case AST::Struct:               return derived().visitStruct(static_cast<StructStmt &>(node));
+            case AST::While:                return derived().visitWhile(static_cast<WhileStmt &>(node));
+            case AST::For:                  return derived().visitFor(static_cast<ForStmt &>(node));
+            case AST::RangeFor:             return derived().visitRangeFor(static_cast<RangeForStmt &>(node));
+            case AST::Assignment:           return derived().visitAssignment(static_cast<AssignmentExpr &>(node));
+            case AST::Block:                return derived().visitBlock(static_cast<BlockExpr &>(node));
+            case AST::Call:                 return derived().visitCall(static_cast<CallExpr &>(node));
+            case AST::Binary:               return derived().visitBinary(static_cast<BinaryExpr &>(node));
+            case AST::Unary:                return derived().visitUnary(static_cast<UnaryExpr &>(node));
+            case AST::Index:                return derived().visitIndex(static_cast<IndexExpr &>(node));
+            case AST::Member:               return derived().visitMember(static_cast<MemberExpr &>(node));
+            case AST::Slice:                return derived().visitSlice(static_cast<SliceExpr &>(node));
+            case AST::Builtin:              return derived().visitBuiltin(static_cast<BuiltinExpr &>(node));
+            case AST::Symbol:               return derived().visitSymbol(static_cast<SymbolExpr &>(node));
+            case AST::Number:               return derived().visitValue(static_cast<ValueExpr &>(node));
+            default:                        return Result();
+        }
+    }
+
+    Result visit(const Stmt::Ptr &node) {
+        if (!node)
+            return Result();
+
+        return visit(*node);
+    }
+
+    void visitChildren(Stmt &node) {
+        forEachChild(node, [this](Stmt &child) { visit(child); });
+    }
+
+    Result visitRoot(Root &node) { return descend(node); }
+    Result visitFunctionPrototype(FunctionPrototype &node) { return descend(node); }
+    Result visitFunction(Function &node) { return descend(node); }
+    Result visitGeneric(GenericFunction &node) { return descend(node); }
+    Result visitVariable(VariableStmt &node) { return descend(node); }
+    Result visitReturn(ReturnStmt &node) { return descend(node); }
+    Result visitImport(ImportStmt &node) { return descend(node); }
+    Result visitStruct(StructStmt &node) { return descend(node); }
+    Result visitWhile(WhileStmt &node) { return descend(node); }
+    Result visitFor(ForStmt &node) { return descend(node); }
+    Result visitRangeFor(RangeForStmt &node) { return descend(node); }
+    Result visitAssignment(AssignmentExpr &node) { return descend(node); }
+    Result visitBlock(BlockExpr &node) { return descend(node); }
+    Result visitCall(CallExpr &node) { return descend(node); }
+    Result visitBinary(BinaryExpr &node) { return descend(node); }
+    Result visitUnary(UnaryExpr &node) { return descend(node); }
+    Result visitIndex(IndexExpr &node) { return descend(node); }
+    Result visitMember(MemberExpr &node) { return descend(node); }
+    Result visitSlice(SliceExpr &node) { return descend(node); }
+    Result visitBuiltin(BuiltinExpr &node) { return descend(node); }
+    Result visitSymbol(SymbolExpr &node) { return descend(node); }
+    Result visitValue(ValueExpr &node) { return descend(node); }
+
+private:
+    Derived &derived() { return static_cast<Derived &>(*this); }
+
+    Result descend(Stmt &node) {
+        visitChildren(node);
+        return Result();
+    }
+};
@@ -0,0 +1,301 @@
+#include "driver.h"
+
+#include <filesystem>
+#include <iostream>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include "link.h"
+#include "profile.h"
+#include "../server/server.h"
+#include "../util/io.h"
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../runtime/lynxrt.h"
+#include "../vm/compiler.h"
+#include "../vm/jit.h"
+#include "../vm/vm.h"
+
+// emitted by an earlier run, read back instead of compiled
+static bool isIR(const std::string &input) { return input.ends_with(".ll") || input.ends_with(".bc"); }
+
+Driver::Driver(Options options) : options(std::move(options)), pipeline(nullptr) {}
+
+Driver::~Driver() = default;
+
+int Driver::run() {
+    wyvern::DO_NOT_LOAD = true;
+    wyvern::Wrapper::initialize();
+
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+
+    if (options.server) {
+        Server server;
+        return server.run();
+    }
+
+    pipeline = std::make_unique<Pipeline>(options.optimization);
+
+    if (options.profileGenerate)
+        pipeline->instrument(options.rawProfile);
+
+    std::string profile;
+    if (!options.profileUse.empty()) {
+        std::string error;
+        profile = prepareProfile(options.profileUse, error);
+        if (profile.empty()) {
+            std::cerr << "error: " << error << '\n';
+            return 1;
+        }
+
+        pipeline->useProfile(profile);
+    }
+
+    int result;
+    try {
+        if (options.interpret)
+            result = interpret();
+        else
+            result = options.thinLTO ? emitThinLTO() : emitIR();
+    } catch (const std::invalid_argument &e) {
+        std::cerr << "error: " << e.what() << '\n';
+        result = 1;
+    }
+
+    // raw profiles were merged into a temporary file
+    if (!profile.empty() && profile != options.profileUse)
+        llvm::sys::fs::remove(profile);
+
+    return result;
+}
+
+int Driver::emitIR() {
+    bool failed = false;
+
+    for (const std::string &input : options.inputs) {
+        if (isIR(input)) {
+            llvm::LLVMContext ctx;
+            std::unique_ptr<llvm::Module> module = load(input, ctx);
+            if (!module) {
+                failed = true;
+                continue;
+            }
+
+            pipeline->optimize(*module);
+            if (!write(*module, input))
+                failed = true;
+            continue;
+        }
+
+        wyvern::Wrapper::Ptr context = compile(input);
+        if (!context) {
+            failed = true;
+            continue;
+        }
+
+        pipeline->optimize(*context->getModule());
+        if (!write(*context->getModule(), input))
+            failed = true;
+    }
+
+    return failed ? 1 : 0;
+}
+
+int Driver::emitThinLTO() {
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> modules = {};
+    bool failed = false;
+
+    for (const std::string &input : options.inputs) {
+        if (input.ends_with(".bc")) { // compiled with -flto=thin -c before
+            llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(input);
+            if (!buffer) {
+                std::cerr << "could not open file '" << input << "'\n";
+                return 1;
+            }
+
+            modules.push_back(std::move(*buffer));
+            continue;
+        }
+
+        // textual IR gets its summary like a compiled source
+        llvm::LLVMContext ctx;
+        std::unique_ptr<llvm::Module> parsed = nullptr;
+        wyvern::Wrapper::Ptr context = nullptr;
+        llvm::Module *module;
+
+        if (input.ends_with(".ll"))
+            module = (parsed = load(input, ctx)).get();
+        else
+            module = (context = compile(input)) ? context->getModule() : nullptr;
+
+        if (!module) {
+            failed = true;
+            continue;
+        }
+
+        llvm::SmallVector<char, 0> bitcode;
+        llvm::raw_svector_ostream os(bitcode);
+        pipeline->writeThinLTOBitcode(*module, os);
+
+        if (!options.compileOnly) {
+            modules.push_back(llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef(bitcode.data(), bitcode.size()), input));
+            continue;
+        }
+
+        std::error_code ec;
+        llvm::raw_fd_ostream file(getOutput(input, ".bc"), ec, llvm::sys::fs::OF_None);
+        if (ec) {
+            std::cerr << "could not write file '" << getOutput(input, ".bc") << "': " << ec.message() << '\n';
+            return 1;
+        }
+
+        file << llvm::StringRef(bitcode.data(), bitcode.size());
+    }
+
+    if (failed)
+        return 1;
+
+    if (options.compileOnly)
+        return 0;
+
+    // instrumented programs need the profile runtime that writes the counters on exit
+    std::vector<std::string> flags = {};
+    if (options.profileGenerate)
+        flags.emplace_back("-fprofile-instr-generate");
+
+    std::string error;
+    if (!linkThinLTO(modules, options.output.empty() ? "a.out" : options.output, *pipeline, options.jobs, flags, error)) {
+        std::cerr << "error: " << error << '\n';
+        return 1;
+    }
+
+    return 0;
+}
+
+int Driver::interpret() {
+    const std::string &input = options.inputs.front();
+    const Root::Ptr root = analyze(input);
+    if (!root)
+        return 1;
+
+    const Program::Ptr program = compileBytecode(*root);
+    if (!program->main)
+        throw std::invalid_argument("The program has no main function to run");
+
+    // stdout belongs to the script, it is usually piped
+    if (options.verbose)
+        for (const BytecodeFunction &function : program->functions)
+            std::cerr << disassemble(function) << '\n';
+
+    VM vm(program);
+    JIT jit(root, program, input, options.optimization);
+    if (options.jitThreshold)
+        vm.setTier([&jit](const BytecodeFunction &function) { return jit.compile(function); }, options.jitThreshold);
+
+    int64_t result;
+    try {
+        result = vm.run();
+    } catch (const Trap &e) {
+        lynx_flush();
+        std::cerr << "error: " << e.what() << '\n';
+        return 1;
+    }
+
+    lynx_flush();
+    return static_cast<int>(result);
+}
+
+Root::Ptr Driver::analyze(const std::string &input) const {
+    const std::string source = readFile(input);
+    const Lexer lexer(source);
+    const Token::Vec tokens = lexer.lex();
+
+    if (options.verbose)
+        for (auto &token : tokens)
+            std::cout << token.str() << '\n';
+
+    auto diagnostics = std::make_shared<Diagnostics>(input);
+    Parser parser(tokens, diagnostics);
+    const Root::Ptr root = parser.parse();
+
+    // report every syntax error at once, the tree contains ErrorExpr placeholders for them
+    if (diagnostics->hasErrors()) {
+        diagnostics->print(std::cerr);
+        return nullptr;
+    }
+
+    if (options.verbose)
+        std::cout << root->str() << '\n';
+
+    Analyzer::Ptr analyzer = std::make_shared<Analyzer>(root, options.jobs);
+    analyzer->setImportPaths(options.importPaths);
+
+    ComptimeLimits limits;
+    if (options.comptimeSteps)
+        limits.steps = options.comptimeSteps;
+    if (options.comptimeMemory)
+        limits.memory = options.comptimeMemory;
+    analyzer->setComptimeLimits(limits);
+
+    analyzer->analyze();
+
+    // next to the source, -o names the compiled output
+    if (options.emitInterface)
+        Interface::collect(root)->write(std::filesystem::path(input).replace_extension(".lymi").string());
+
+    return root;
+}
+
+wyvern::Wrapper::Ptr Driver::compile(const std::string &input) const {
+    const Root::Ptr root = analyze(input);
+    if (!root)
+        return nullptr;
+
+    wyvern::Wrapper::Ptr context = wyvern::Wrapper::create(input);
+    root->generate(context);
+    // context->getFunc("puts")->addAttr(llvm::Attribute::NoCapture, 0);
+    return context;
+}
+
+std::unique_ptr<llvm::Module> Driver::load(const std::string &input, llvm::LLVMContext &ctx) {
+    llvm::SMDiagnostic error;
+    std::unique_ptr<llvm::Module> module = llvm::parseIRFile(input, error, ctx);
+    if (!module)
+        error.print("Lynx", llvm::errs());
+
+    return module;
+}
+
+bool Driver::write(const llvm::Module &module, const std::string &input) const {
+    const std::string output = getOutput(input, options.emitBitcode ? ".bc" : ".ll");
+    if (output == input) {
+        std::cerr << "error: writing '" << output << "' would overwrite the input, use -o\n";
+        return false;
+    }
+
+    std::error_code ec;
+    llvm::raw_fd_ostream file(output, ec, options.emitBitcode ? llvm::sys::fs::OF_None : llvm::sys::fs::OF_Text);
+    if (ec) {
+        std::cerr << "could not write file '" << output << "': " << ec.message() << '\n';
+        return false;
+    }
+
+    if (options.emitBitcode)
+        llvm::WriteBitcodeToFile(module, file);
+    else
+        module.print(file, nullptr);
+
+    return true;
+}
+
+std::string Driver::getOutput(const std::string &input, const std::string &extension) const {
+    if (!options.output.empty())
+        return options.output;
+
+    return std::filesystem::path(input).replace_extension(extension).string();
+}
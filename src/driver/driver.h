@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+
+#include "options.h"
+#include "pipeline.h"
+#include "../ast/stmt.h"
+#include "../wyvern/src/wyvern.hpp"
+
+class Driver {
+public:
+    explicit Driver(Options options);
+    ~Driver();
+
+    // compile and link all inputs, returns the exit code
+    int run();
+
+private:
+    // write optimized textual IR for every input
+    int emitIR();
+    // compile every input to bitcode with a ThinLTO summary, then link unless -c was given
+    int emitThinLTO();
+    // run the single input in the bytecode interpreter, hot functions are handed to the JIT
+    int interpret();
+
+    // lex, parse and analyze a single source file, nullptr after syntax errors
+    [[nodiscard]] Root::Ptr analyze(const std::string &input) const;
+
+    // lex, parse, analyze and generate a single source file, nullptr after syntax errors
+    [[nodiscard]] wyvern::Wrapper::Ptr compile(const std::string &input) const;
+    // read a module written by --emit or -flto=thin -c, textual IR or bitcode, nullptr if it can't be parsed
+    [[nodiscard]] static std::unique_ptr<llvm::Module> load(const std::string &input, llvm::LLVMContext &ctx);
+    // write textual IR or bitcode as chosen by --emit, false if the file couldn't be written
+    [[nodiscard]] bool write(const llvm::Module &module, const std::string &input) const;
+    // -o or the input path with its extension replaced
+    [[nodiscard]] std::string getOutput(const std::string &input, const std::string &extension) const;
+
+    Options options;
+    std::unique_ptr<Pipeline> pipeline;
+};
@@ -0,0 +1,137 @@
+#include "link.h"
+
+#include <optional>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/LTO/LTO.h>
+#include <llvm/Support/Caching.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/Threading.h>
+
+#include "pipeline.h"
+
+bool linkThinLTO(const std::vector<std::unique_ptr<llvm::MemoryBuffer>> &modules, const std::string &output,
+    const Pipeline &pipeline, unsigned jobs, const std::vector<std::string> &flags, std::string &error) {
+    llvm::lto::Config config;
+    config.OptLevel = pipeline.getLevel();
+    config.RelocModel = llvm::Reloc::PIC_;
+
+    if (llvm::TargetMachine *machine = pipeline.getTargetMachine()) {
+        config.CPU = machine->getTargetCPU().str();
+        config.MAttrs = {machine->getTargetFeatureString().str()};
+        config.DefaultTriple = machine->getTargetTriple().str();
+    }
+
+    llvm::lto::ThinBackend backend = llvm::lto::createInProcessThinBackend(llvm::heavyweight_hardware_concurrency(jobs));
+    llvm::lto::LTO lto(std::move(config), std::move(backend));
+
+    std::vector<std::unique_ptr<llvm::lto::InputFile>> inputs;
+    for (const auto &module : modules) {
+        llvm::Expected<std::unique_ptr<llvm::lto::InputFile>> input = llvm::lto::InputFile::create(module->getMemBufferRef());
+        if (!input) {
+            error = llvm::toString(input.takeError());
+            return false;
+        }
+
+        inputs.push_back(std::move(*input));
+    }
+
+    // a strong definition prevails over weak ones (linkonce_odr), of those the first is kept,
+    // two strong definitions are an error like with any other linker
+    llvm::StringMap<llvm::StringRef> strong;
+    for (size_t i = 0; i < inputs.size(); ++i)
+        for (const llvm::lto::InputFile::Symbol &symbol : inputs[i]->symbols()) {
+            if (symbol.isUndefined() || symbol.isWeak() || symbol.isCommon())
+                continue;
+
+            const auto [found, added] = strong.try_emplace(symbol.getName(), modules[i]->getBufferIdentifier());
+            if (!added) {
+                error = "duplicate symbol '" + symbol.getName().str() + "' in '" + found->second.str()
+                    + "' and '" + modules[i]->getBufferIdentifier().str() + "'";
+                return false;
+            }
+        }
+
+    llvm::StringSet<> defined;
+
+    for (auto &input : inputs) {
+        std::vector<llvm::lto::SymbolResolution> resolutions;
+        for (const llvm::lto::InputFile::Symbol &symbol : input->symbols()) {
+            llvm::lto::SymbolResolution resolution;
+            const bool definition = !symbol.isUndefined();
+            const bool weak = symbol.isWeak() || symbol.isCommon();
+            resolution.Prevailing = definition && (!weak || !strong.count(symbol.getName())) && defined.insert(symbol.getName()).second;
+            resolution.FinalDefinitionInLinkageUnit = definition;
+            resolution.VisibleToRegularObj = symbol.getName() == "main";
+            resolutions.push_back(resolution);
+        }
+
+        if (llvm::Error err = lto.add(std::move(input), resolutions)) {
+            error = llvm::toString(std::move(err));
+            return false;
+        }
+    }
+
+    // one object per backend task, written concurrently
+    std::vector<std::string> objects(lto.getMaxTasks());
+    const auto addStream = [&](unsigned task, const llvm::Twine &) -> llvm::Expected<std::unique_ptr<llvm::CachedFileStream>> {
+        int fd;
+        llvm::SmallString<128> path;
+        if (const std::error_code ec = llvm::sys::fs::createTemporaryFile("lynx-thinlto", "o", fd, path))
+            return llvm::errorCodeToError(ec);
+
+        objects[task] = path.str().str();
+        return std::make_unique<llvm::CachedFileStream>(std::make_unique<llvm::raw_fd_ostream>(fd, true));
+    };
+
+    if (llvm::Error err = lto.run(addStream)) {
+        error = llvm::toString(std::move(err));
+        return false;
+    }
+
+    std::erase(objects, "");
+    const bool linked = linkObjects(objects, output, flags, error);
+
+    for (const std::string &object : objects)
+        llvm::sys::fs::remove(object);
+
+    return linked;
+}
+
+bool linkObjects(const std::vector<std::string> &objects, const std::string &output,
+    const std::vector<std::string> &flags, std::string &error) {
+    llvm::ErrorOr<std::string> linker = llvm::sys::findProgramByName("clang");
+
+    // the flags are clang's, e.g. -fprofile-instr-generate which GCC rejects
+    if (!linker && !flags.empty()) {
+        error = "could not find 'clang', which is needed to link with " + flags.front();
+        return false;
+    }
+
+    if (!linker)
+        linker = llvm::sys::findProgramByName("cc");
+
+    if (!linker) {
+        error = "could not find 'clang' or 'cc' to link with";
+        return false;
+    }
+
+    std::vector<llvm::StringRef> args = {*linker, "-o", output};
+    args.insert(args.end(), flags.begin(), flags.end());
+    args.insert(args.end(), objects.begin(), objects.end());
+
+#ifdef LYNX_RUNTIME
+    // after the objects, an archive only provides what they reference
+    args.emplace_back(LYNX_RUNTIME);
+    args.emplace_back("-lpthread");
+#endif
+
+    if (llvm::sys::ExecuteAndWait(*linker, args, std::nullopt, {}, 0, 0, &error) != 0) {
+        if (error.empty())
+            error = "linker failed";
+        return false;
+    }
+
+    return true;
+}
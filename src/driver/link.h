@@ -0,0 +1,18 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <llvm/Support/MemoryBuffer.h>
+
+class Pipeline;
+
+// run the ThinLTO backend in parallel across the bitcode modules and link the resulting objects,
+// only main stays exported so everything else can be internalized, inlined across modules and stripped
+bool linkThinLTO(const std::vector<std::unique_ptr<llvm::MemoryBuffer>> &modules, const std::string &output,
+    const Pipeline &pipeline, unsigned jobs, const std::vector<std::string> &flags, std::string &error);
+
+// link object files and the Lynx runtime into an executable using the system's C compiler driver,
+// clang is preferred and required with flags, instrumented builds need its profile runtime (-fprofile-instr-generate)
+bool linkObjects(const std::vector<std::string> &objects, const std::string &output,
+    const std::vector<std::string> &flags, std::string &error);
@@ -0,0 +1,134 @@
+#include "options.h"
+
+#include <charconv>
+#include <iostream>
+#include <string_view>
+
+#include "profile.h"
+
+[[noreturn]] static void usage(const std::string &error) {
+    std::cerr << "error: " << error << "\n"
+              << "usage: Lynx [options] <inputs...>\n"
+              << "  -o <file>     output file\n"
+              << "  -c            compile only, don't link\n"
+              << "  -O<level>     optimization level (0-3)\n"
+              << "  -flto=thin    emit bitcode with ThinLTO summaries, link with the ThinLTO backend\n"
+              << "  -j<N>         threads used for analysis and by the ThinLTO backend (default: all cores)\n"
+              << "  -v            print tokens and the AST\n"
+              << "  -I<dir>       search <dir> for module interfaces (.lymi)\n"
+              << "  --emit=<ll|bc>\n"
+              << "                write textual IR (default) or bitcode, .ll and .bc inputs are read back\n"
+              << "  --emit-interface\n"
+              << "                write the exported prototypes of every input to <input>.lymi\n"
+              << "  --server      run as a language server (LSP) on stdin and stdout\n"
+              << "  -fprofile-generate[=<file>]\n"
+              << "                instrument the program (with -flto=thin), it writes its profile to <file> (default: "
+              << DEFAULT_RAW_PROFILE << ")\n"
+              << "  -fprofile-use=<file>\n"
+              << "                optimize with a profile written by an instrumented build\n"
+              << "  -fcomptime-steps=<N>\n"
+              << "                steps a @comptime call may take before compilation fails\n"
+              << "  -fcomptime-memory=<N>\n"
+              << "                bytes of arrays a @comptime call may hold at once before compilation fails\n"
+              << "  --interpret   run the program in the bytecode interpreter instead of compiling it\n"
+              << "  -fjit-threshold=<N>\n"
+              << "                calls after which --interpret compiles a function with the JIT, 0 never (default: 1000)\n";
+    exit(1);
+}
+
+// the whole value is a decimal number that fits, usage error otherwise
+template <typename T>
+static T parseNumber(std::string_view arg, size_t prefix) {
+    const std::string_view value = arg.substr(prefix);
+    T number = 0;
+
+    const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (ec != std::errc() || end != value.data() + value.size())
+        usage("invalid number in '" + std::string(arg) + "'");
+
+    return number;
+}
+
+Options Options::parse(int argc, char **argv) {
+    Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+
+        if (arg == "-o") {
+            if (++i >= argc)
+                usage("missing file after '-o'");
+            options.output = argv[i];
+        } else if (arg == "-c")
+            options.compileOnly = true;
+        else if (arg == "-v")
+            options.verbose = true;
+        else if (arg == "--server")
+            options.server = true;
+        else if (arg == "--interpret")
+            options.interpret = true;
+        else if (arg == "--emit=ll")
+            options.emitBitcode = false;
+        else if (arg == "--emit=bc")
+            options.emitBitcode = true;
+        else if (arg == "--emit-interface")
+            options.emitInterface = true;
+        else if (arg == "-I") {
+            if (++i >= argc)
+                usage("missing directory after '-I'");
+            options.importPaths.emplace_back(argv[i]);
+        } else if (arg.starts_with("-I"))
+            options.importPaths.emplace_back(arg.substr(2));
+        else if (arg.starts_with("-O") && arg.size() == 3 && arg[2] >= '0' && arg[2] <= '3')
+            options.optimization = arg[2] - '0';
+        else if (arg == "-flto=thin")
+            options.thinLTO = true;
+        else if (arg == "-fprofile-generate") {
+            options.profileGenerate = true;
+            options.rawProfile = DEFAULT_RAW_PROFILE;
+        } else if (arg.starts_with("-fprofile-generate=")) {
+            options.profileGenerate = true;
+            options.rawProfile = arg.substr(arg.find('=') + 1);
+        } else if (arg.starts_with("-fprofile-use=") && arg.size() > 14)
+            options.profileUse = arg.substr(14);
+        else if (arg.starts_with("-fcomptime-steps=") && arg.size() > 17)
+            options.comptimeSteps = parseNumber<uint64_t>(arg, 17);
+        else if (arg.starts_with("-fcomptime-memory=") && arg.size() > 18)
+            options.comptimeMemory = parseNumber<uint64_t>(arg, 18);
+        else if (arg.starts_with("-fjit-threshold=") && arg.size() > 16)
+            options.jitThreshold = parseNumber<uint64_t>(arg, 16);
+        else if (arg.starts_with("-j") && arg.size() > 2)
+            options.jobs = parseNumber<unsigned>(arg, 2);
+        else if (arg.starts_with("-"))
+            usage("unknown option '" + std::string(arg) + "'");
+        else
+            options.inputs.emplace_back(arg);
+    }
+
+    // no arguments: compile the development test file like before
+    if (argc == 1) {
+        options.inputs = {"src/test/test.lynx"};
+        options.verbose = true;
+    }
+
+    if (options.inputs.empty() && !options.server)
+        usage("no input files");
+
+    if (options.profileGenerate && !options.profileUse.empty())
+        usage("'-fprofile-generate' and '-fprofile-use' can't be combined");
+
+    // only the ThinLTO path links, the instrumented program needs the profile runtime
+    if (options.profileGenerate && !options.thinLTO)
+        usage("'-fprofile-generate' needs '-flto=thin' to link the instrumented program");
+
+    if (options.interpret && options.inputs.size() != 1)
+        usage("'--interpret' runs a single input");
+
+    if (options.interpret && (options.inputs.front().ends_with(".ll") || options.inputs.front().ends_with(".bc")))
+        usage("'--interpret' runs Lynx sources, not IR");
+
+    if (!options.output.empty() && options.inputs.size() > 1 && (options.compileOnly || !options.thinLTO))
+        usage("'-o' can't be used with multiple inputs unless linking");
+
+    return options;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// command line options of the compiler
+struct Options {
+    std::vector<std::string> inputs;
+    std::string output;         // -o, derived from the input if empty
+    unsigned optimization = 0;  // -O0 to -O3
+    bool compileOnly = false;   // -c, don't link
+    bool thinLTO = false;       // -flto=thin, emit bitcode with ThinLTO summaries and link with the ThinLTO backend
+    unsigned jobs = 0;          // -j, threads for analysis and the ThinLTO backend, 0 uses all cores
+    bool verbose = false;       // -v, print tokens and the AST
+    bool emitBitcode = false;   // --emit=bc, write bitcode instead of textual IR (--emit=ll)
+    bool emitInterface = false; // --emit-interface, write <input>.lymi with the exported prototypes
+    std::vector<std::string> importPaths;   // -I, directories searched for module interfaces
+    bool server = false;        // --server, run as a language server on stdin and stdout
+    bool profileGenerate = false;   // -fprofile-generate[=file], build with InstrProf instrumentation
+    std::string rawProfile;         // where the instrumented program writes its counters
+    std::string profileUse;         // -fprofile-use=file, optimize with a .profdata or .profraw profile
+    uint64_t comptimeSteps = 0;     // -fcomptime-steps=N, steps of each @comptime call, 0 keeps the default
+    uint64_t comptimeMemory = 0;    // -fcomptime-memory=N, bytes of arrays of each @comptime call, 0 keeps the default
+    bool interpret = false;         // --interpret, run main in the bytecode interpreter instead of compiling
+    uint64_t jitThreshold = 1000;   // -fjit-threshold=N, calls of an interpreted function before the JIT compiles it, 0 never
+
+    // parse the arguments, prints an error and exits on invalid ones
+    static Options parse(int argc, char **argv);
+};
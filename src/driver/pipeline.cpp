@@ -0,0 +1,94 @@
+#include "pipeline.h"
+
+#include <iostream>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/SubtargetFeature.h>
+#include <llvm/Transforms/IPO/ThinLTOBitcodeWriter.h>
+
+static llvm::OptimizationLevel getOptimizationLevel(unsigned level) {
+    switch (level) {
+        case 0:     return llvm::OptimizationLevel::O0;
+        case 1:     return llvm::OptimizationLevel::O1;
+        case 2:     return llvm::OptimizationLevel::O2;
+        default:    return llvm::OptimizationLevel::O3;
+    }
+}
+
+Pipeline::Pipeline(unsigned level) : level(level), machine(nullptr), profile(std::nullopt) {
+    const std::string triple = llvm::sys::getProcessTriple();
+    std::string error;
+    const llvm::Target *target = llvm::TargetRegistry::lookupTarget(triple, error);
+
+    if (!target) {
+        std::cerr << "could not find target '" << triple << "': " << error << '\n';
+        return;
+    }
+
+    llvm::SubtargetFeatures features;
+    for (const auto &feature : llvm::sys::getHostCPUFeatures())
+        features.AddFeature(feature.getKey(), feature.getValue());
+
+    machine.reset(target->createTargetMachine(triple, llvm::sys::getHostCPUName(), features.getString(),
+        llvm::TargetOptions(), llvm::Reloc::PIC_));
+}
+
+Pipeline::~Pipeline() = default;
+
+void Pipeline::instrument(const std::string &rawProfile) {
+    profile = llvm::PGOOptions(rawProfile, "", "", "", llvm::vfs::getRealFileSystem(), llvm::PGOOptions::IRInstr);
+}
+
+void Pipeline::useProfile(const std::string &indexedProfile) {
+    profile = llvm::PGOOptions(indexedProfile, "", "", "", llvm::vfs::getRealFileSystem(), llvm::PGOOptions::IRUse);
+}
+
+void Pipeline::optimize(llvm::Module &module) {
+    if (level == 0 && !profile)
+        return;
+
+    run(module, [&](llvm::PassBuilder &builder) {
+        return level == 0
+            ? builder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0)
+            : builder.buildPerModuleDefaultPipeline(getOptimizationLevel(level));
+    });
+}
+
+void Pipeline::writeThinLTOBitcode(llvm::Module &module, llvm::raw_ostream &os) {
+    run(module, [&](llvm::PassBuilder &builder) {
+        llvm::ModulePassManager passes = level == 0
+            ? builder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0, llvm::ThinOrFullLTOPhase::ThinLTOPreLink)
+            : builder.buildThinLTOPreLinkDefaultPipeline(getOptimizationLevel(level));
+        passes.addPass(llvm::ThinLTOBitcodeWriterPass(os, nullptr));
+        return passes;
+    });
+}
+
+unsigned Pipeline::getLevel() const { return level; }
+
+llvm::TargetMachine *Pipeline::getTargetMachine() const { return machine.get(); }
+
+void Pipeline::run(llvm::Module &module, const std::function<llvm::ModulePassManager(llvm::PassBuilder &)> &build) {
+    if (machine) {
+        module.setTargetTriple(machine->getTargetTriple().str());
+        module.setDataLayout(machine->createDataLayout());
+    }
+
+    // analysis results are cached per module, so every run gets fresh managers
+    llvm::LoopAnalysisManager LAM;
+    llvm::FunctionAnalysisManager FAM;
+    llvm::CGSCCAnalysisManager CGAM;
+    llvm::ModuleAnalysisManager MAM;
+
+    // the PGO passes run inside the default pipelines, before inlining
+    llvm::PassBuilder builder(machine.get(), llvm::PipelineTuningOptions(), profile);
+    builder.registerModuleAnalyses(MAM);
+    builder.registerCGSCCAnalyses(CGAM);
+    builder.registerFunctionAnalyses(FAM);
+    builder.registerLoopAnalyses(LAM);
+    builder.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+    llvm::ModulePassManager passes = build(builder);
+    passes.run(module, MAM);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <llvm/IR/Module.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/PGOOptions.h>
+#include <llvm/Target/TargetMachine.h>
+
+// optimization pipelines of LLVM's new pass manager, set up for the host
+class Pipeline {
+public:
+    explicit Pipeline(unsigned level);
+    ~Pipeline();
+
+    // insert InstrProf counters, the program writes them to the given raw profile on exit
+    void instrument(const std::string &rawProfile);
+    // annotate branch weights and entry counts from an indexed profile, guides inlining and block layout
+    void useProfile(const std::string &indexedProfile);
+
+    // run the default per-module pipeline, only instruments at -O0
+    void optimize(llvm::Module &module);
+    // run the ThinLTO pre-link pipeline and write bitcode with a module summary
+    void writeThinLTOBitcode(llvm::Module &module, llvm::raw_ostream &os);
+
+    [[nodiscard]] unsigned getLevel() const;
+    [[nodiscard]] llvm::TargetMachine *getTargetMachine() const;
+
+private:
+    void run(llvm::Module &module, const std::function<llvm::ModulePassManager(llvm::PassBuilder &)> &build);
+
+    unsigned level;
+    std::unique_ptr<llvm::TargetMachine> machine;
+    std::optional<llvm::PGOOptions> profile;
+};
@@ -0,0 +1,62 @@
+#include "profile.h"
+
+#include <llvm/ProfileData/InstrProfReader.h>
+#include <llvm/ProfileData/InstrProfWriter.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+// merge a raw profile into the indexed format the PGO passes read
+static std::string indexProfile(llvm::InstrProfReader &reader, std::string &error) {
+    llvm::InstrProfWriter writer;
+    if (llvm::Error err = writer.mergeProfileKind(reader.getProfileKind())) {
+        error = llvm::toString(std::move(err));
+        return "";
+    }
+
+    for (llvm::NamedInstrProfRecord &record : reader) {
+        writer.addRecord(std::move(record), [&](llvm::Error err) {
+            error = llvm::toString(std::move(err));
+        });
+    }
+
+    if (reader.hasError()) {
+        error = llvm::toString(reader.getError());
+        return "";
+    }
+
+    if (!error.empty())
+        return "";
+
+    int fd;
+    llvm::SmallString<128> path;
+    if (const std::error_code ec = llvm::sys::fs::createTemporaryFile("lynx-profile", "profdata", fd, path)) {
+        error = ec.message();
+        return "";
+    }
+
+    llvm::raw_fd_ostream os(fd, true);
+    if (llvm::Error err = writer.write(os)) {
+        error = llvm::toString(std::move(err));
+        return "";
+    }
+
+    return path.str().str();
+}
+
+std::string prepareProfile(const std::string &path, std::string &error) {
+    const llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fs = llvm::vfs::getRealFileSystem();
+
+    // already indexed, only make sure it can be read
+    if (llvm::Expected<std::unique_ptr<llvm::IndexedInstrProfReader>> indexed = llvm::IndexedInstrProfReader::create(path, *fs))
+        return path;
+    else
+        llvm::consumeError(indexed.takeError());
+
+    llvm::Expected<std::unique_ptr<llvm::InstrProfReader>> reader = llvm::InstrProfReader::create(path, *fs);
+    if (!reader) {
+        error = "invalid profile '" + path + "': " + llvm::toString(reader.takeError());
+        return "";
+    }
+
+    return indexProfile(**reader, error);
+}
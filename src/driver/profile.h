@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+// default file the instrumented program writes its counters to, %m keeps runs of different binaries apart
+inline const std::string DEFAULT_RAW_PROFILE = "default_%m.profraw";
+
+// check a profile given to -fprofile-use and return the path of an indexed profile for the pipeline,
+// raw profiles (.profraw) written by an instrumented build are merged into a temporary .profdata,
+// so no llvm-profdata is needed, returns an empty string and sets the error on failure
+std::string prepareProfile(const std::string &path, std::string &error);
@@ -1,121 +1,143 @@
-#include <regex>
+#include <algorithm>
 #include <iostream>
-#include <sstream>
+#include <vector>
 #include "lexer.h"
+#include "../util/io.h"
+#include "../util/scan.h"
 
-const std::vector<std::pair<TokenType, std::regex>> patterns = {
-    // sorted after length due to priority when matching
-
-    // undefined length
-    {NUMBER, std::regex(R"(\d*\.\d+|\d+)")},
-    {IDENTIFIER, std::regex(R"([a-zA-Z_]\w*)")},
-    {LITERAL, std::regex(R"(\".*\")")}, // std::regex doesn't support lookbehind
-
+// sorted after length due to priority when matching
+const std::vector<std::pair<TokenType, std::string_view>> punctuators = {
     // three characters
-    {TRIPLE_EQUALS, std::regex(R"(===)")},
-    {LSH_EQUALS, std::regex(R"(<<=)")},
-    {RSH_EQUALS, std::regex(R"(>>=)")},
+    {TRIPLE_EQUALS, "==="},
+    {LSH_EQUALS, "<<="},
+    {RSH_EQUALS, ">>="},
 
     // two characters
-    {POINTER, std::regex(R"(->)")},
-    {PLUS_PLUS, std::regex(R"(\+\+)")},
-    {MINUS_MINUS, std::regex(R"(--)")},
-    {PLUS_EQUALS, std::regex(R"(\+=)")},
-    {MINUS_EQUALS, std::regex(R"(-=)")},
-    {ASTERISK_EQUALS, std::regex(R"(\*=)")},
-    {SLASH_EQUALS, std::regex(R"(/=)")},
-    {CARET_EQUALS, std::regex(R"(\^=)")},
-    {PERCENT_EQUALS, std::regex(R"(%=)")},
-    {OR_EQUALS, std::regex(R"(\|=)")},
-    {AND_EQUALS, std::regex(R"(&=)")},
-    {SWAP, std::regex(R"(<>)")},
-    {EQUALS_EQUALS, std::regex(R"(==)")},
-    {NOT_EQUALS, std::regex(R"(!=)")},
-    {LTEQUALS, std::regex(R"(<=)")},
-    {GTEQUALS, std::regex(R"(>=)")},
-    {OR, std::regex(R"(\|\|)")},
-    {AND, std::regex(R"(&&)")},
-    {BIT_XOR, std::regex(R"(><)")},
-    {BIT_LSHIFT, std::regex(R"(<<)")},
-    {BIT_RSHIFT, std::regex(R"(>>)")},
+    {POINTER, "->"},
+    {COLON_COLON, "::"},
+    {DOT_DOT, ".."},
+    {PLUS_PLUS, "++"},
+    {MINUS_MINUS, "--"},
+    {PLUS_EQUALS, "+="},
+    {MINUS_EQUALS, "-="},
+    {ASTERISK_EQUALS, "*="},
+    {SLASH_EQUALS, "/="},
+    {CARET_EQUALS, "^="},
+    {PERCENT_EQUALS, "%="},
+    {OR_EQUALS, "|="},
+    {AND_EQUALS, "&="},
+    {SWAP, "<>"},
+    {EQUALS_EQUALS, "=="},
+    {NOT_EQUALS, "!="},
+    {LTEQUALS, "<="},
+    {GTEQUALS, ">="},
+    {OR, "||"},
+    {AND, "&&"},
+    {BIT_XOR, "><"},
+    {BIT_LSHIFT, "<<"},
+    {BIT_RSHIFT, ">>"},
 
     // one character
-    {LPAREN, std::regex(R"(\()")},
-    {RPAREN, std::regex(R"(\))")},
-    {LBRACKET, std::regex(R"(\[)")},
-    {RBRACKET, std::regex(R"(\])")},
-    {LBRACE, std::regex(R"(\{)")},
-    {RBRACE, std::regex(R"(\})")},
-    {COLON, std::regex(R"(:)")},
-    {SEMICOLON, std::regex(R"(;)")},
-    {DOT, std::regex(R"(\.)")},
-    {COMMA, std::regex(R"(,)")},
-    {AT, std::regex(R"(@)")},
-    {EQUALS, std::regex(R"(\=)")},
-    {LESSTHAN, std::regex(R"(<)")},
-    {GREATERTHAN, std::regex(R"(>)")},
-    {EXCLAMATION, std::regex(R"(!)")},
-    {QUESTION, std::regex(R"(\?)")},
-    {PLUS, std::regex(R"(\+)")},
-    {MINUS, std::regex(R"(-)")},
-    {ASTERISK, std::regex(R"(\*)")},
-    {SLASH, std::regex(R"(\/)")},
-    {CARET, std::regex(R"(\^)")},
-    {PERCENT, std::regex(R"(%)")},
-    {BIT_NOT, std::regex(R"(~)")},
-    {BIT_OR, std::regex(R"(\|)")},
-    {BIT_AND, std::regex(R"(&)")},
-
+    {LPAREN, "("},
+    {RPAREN, ")"},
+    {LBRACKET, "["},
+    {RBRACKET, "]"},
+    {LBRACE, "{"},
+    {RBRACE, "}"},
+    {COLON, ":"},
+    {SEMICOLON, ";"},
+    {DOT, "."},
+    {COMMA, ","},
+    {AT, "@"},
+    {EQUALS, "="},
+    {LESSTHAN, "<"},
+    {GREATERTHAN, ">"},
+    {EXCLAMATION, "!"},
+    {QUESTION, "?"},
+    {PLUS, "+"},
+    {MINUS, "-"},
+    {ASTERISK, "*"},
+    {SLASH, "/"},
+    {CARET, "^"},
+    {PERCENT, "%"},
+    {BIT_NOT, "~"},
+    {BIT_OR, "|"},
+    {BIT_AND, "&"},
 };
 
+// end of the number at from (digits, or digits with a fraction like .5 and 1.5), from if there is none
+static size_t skipNumber(std::string_view text, size_t from) {
+    const size_t integer = scan::skipDigits(text, from);
+    if (integer < text.size() && text[integer] == '.' && integer + 1 < text.size() && scan::isDigit(text[integer + 1]))
+        return scan::skipDigits(text, integer + 1);
+
+    return integer;
+}
+
 Lexer::Lexer(const std::string &source) : source(source) {}
 
 Lexer::~Lexer() = default;
 
-Token::Vec Lexer::lex() const {
+Token::Vec Lexer::lex(size_t firstLine) const {
     Token::Vec tokens = {};
-    std::string current_line;
-    std::istringstream stream(source);
-    size_t line = 1;
-
-    while (std::getline(stream, current_line)) {
+    const std::string_view text = source;
+    size_t line = firstLine;
+
+    // lines like std::getline splits them, a final newline doesn't start another line
+    for (size_t begin = 0; begin < text.size(); ++line) {
+        const size_t newline = std::min(text.find('\n', begin), text.size());
+        const std::string_view current_line = text.substr(begin, newline - begin);
+        begin = newline + 1;
         size_t pos = 0;
 
         while (pos < current_line.length()) {
             // Skip whitespace
-            while (pos < current_line.length() && std::isspace(current_line[pos]))
-                pos++;
-            
+            pos = scan::skipWhitespace(current_line, pos);
+
             if (pos >= current_line.length())
                 break;
 
             if (current_line[pos] == '/' && pos + 1 < current_line.length() && current_line[pos + 1] == '/')
                 break;
 
-            bool matched = false;
-            std::cout << "Trying to match " << current_line.substr(pos) << std::endl;
-            for (const auto &[tokenType, pattern] : patterns) {
-                std::string remaining = current_line.substr(pos);
-                std::smatch match;
-
-                try {
-                    if (std::regex_search(remaining, match, pattern, std::regex_constants::match_continuous)) {
-
-                        // Remove quotes from literal tokens (TODO: I should rewrite this whole Lexer)
-                        std::string value = match.str();
-                        if (tokenType == LITERAL)
-                            value = value.substr(1, match.str().length() - 2);
-
-                        tokens.emplace_back(tokenType, value, line, pos + 1, pos + match.length());
-                        pos += match.length();
-                        matched = true;
-                        break;
-                    }
-                } catch (const std::regex_error& e) {
-                    std::cerr << "Regex error: " << e.what() << std::endl;
+            // identifiers and literals are most of the input, they are scanned first
+            if (scan::isIdentifier(current_line[pos]) && !scan::isDigit(current_line[pos])) {
+                const size_t end = scan::skipIdentifier(current_line, pos);
+                tokens.emplace_back(IDENTIFIER, std::string(current_line.substr(pos, end - pos)), line, pos + 1, end);
+                pos = end;
+                continue;
+            }
+
+            if (current_line[pos] == '"') {
+                size_t end = scan::findQuoteOrBackslash(current_line, pos + 1);
+                while (end + 1 < current_line.length() && current_line[end] == '\\')
+                    end = scan::findQuoteOrBackslash(current_line, end + 2);
+
+                if (end < current_line.length() && current_line[end] == '"') {
+                    tokens.emplace_back(LITERAL, escapeSequences(std::string(current_line.substr(pos + 1, end - pos - 1))), line, pos + 1, end + 1);
+                    pos = end + 1;
+                    continue;
                 }
+                // unterminated, reported as an invalid character below
+            }
+
+            // before the punctuators, .5 is a number and not a dot
+            if (const size_t end = skipNumber(current_line, pos); end > pos) {
+                tokens.emplace_back(NUMBER, std::string(current_line.substr(pos, end - pos)), line, pos + 1, end);
+                pos = end;
+                continue;
             }
 
+            bool matched = false;
+            const std::string_view remaining = current_line.substr(pos);
+            for (const auto &[tokenType, punctuator] : punctuators)
+                if (remaining.starts_with(punctuator)) {
+                    tokens.emplace_back(tokenType, std::string(punctuator), line, pos + 1, pos + punctuator.length());
+                    pos += punctuator.length();
+                    matched = true;
+                    break;
+                }
+
             if (!matched) {
                 std::cerr << "Invalid character at line " << line << ", position " << pos 
                          << " (ASCII: " << static_cast<int>(static_cast<unsigned char>(current_line[pos])) 
@@ -123,8 +145,6 @@ Token::Vec Lexer::lex() const {
                 pos++;
             }
         }
-
-        line++;
     }
 
     return tokens;
@@ -8,7 +8,8 @@ public:
      explicit Lexer(const std::string &source);
      ~Lexer();
 
-     Token::Vec lex() const;
+     // lex the source, numbering lines from firstLine (used to re-lex single lines of a file)
+     Token::Vec lex(size_t firstLine = 1) const;
 
 private:
     const std::string &source;
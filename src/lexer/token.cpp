@@ -10,8 +10,10 @@ const char *tokenTypeNames[] = {
     "lbrace",
     "rbrace",
     "colon",
+    "colon_colon",
     "semicolon",
     "dot",
+    "dot_dot",
     "comma",
     "pointer",
     "at",
@@ -60,6 +62,8 @@ const char *tokenTypeNames[] = {
     "identifier",
     "number",
     "literal",
+
+    "end_of_file",
 };
 
 const char *tokenTypeValues[] = {
@@ -70,8 +74,10 @@ const char *tokenTypeValues[] = {
     "{",
     "}",
     ":",
+    "::",
     ";",
     ".",
+    "..",
     ",",
     "->",
     "@",
@@ -120,6 +126,8 @@ const char *tokenTypeValues[] = {
     "identifier",
     "number",
     "literal",
+
+    "end of file",
 };
 
 Token::Token(const TokenType &tokenType, std::string value, size_t line, size_t start, size_t end)
@@ -144,6 +152,10 @@ size_t Token::getStart() const { return start; }
 
 size_t Token::getEnd() const { return end; }
 
+Location Token::getLocation() const { return {line, start}; }
+
+void Token::setLine(size_t line) { this->line = line; }
+
 std::string Token::getTypeName(TokenType type) { return tokenTypeNames[type]; }
 
 std::string Token::getTypeValue(TokenType type) { return tokenTypeValues[type]; }
\ No newline at end of file
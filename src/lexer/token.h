@@ -11,8 +11,10 @@ enum TokenType {
     LBRACE,         // {
     RBRACE,         // }
     COLON,          // :
+    COLON_COLON,    // ::
     SEMICOLON,      // ;
     DOT,            // .
+    DOT_DOT,        // ..
     COMMA,          // ,
     POINTER,        // ->
     AT,             // @
@@ -66,6 +68,13 @@ enum TokenType {
     IDENTIFIER,
     NUMBER,
     LITERAL,
+
+    END_OF_FILE,    // appended by the parser, never lexed
+};
+
+// position in the source, both 1-based
+struct Location {
+    size_t line = 0, column = 0;
 };
 
 class Token {
@@ -73,6 +82,10 @@ public:
     using Vec = std::vector<Token>;
 
     Token(const TokenType &tokenType, std::string value, size_t line, size_t start, size_t end);
+    Token(const Token &) = default;
+    Token(Token &&) noexcept = default; // the declared destructor would otherwise turn moves into copies
+    Token &operator=(const Token &) = default;
+    Token &operator=(Token &&) noexcept = default;
     ~Token();
 
     bool operator==(TokenType type) const;
@@ -84,6 +97,10 @@ public:
     [[nodiscard]] size_t getLine() const;
     [[nodiscard]] size_t getStart() const;
     [[nodiscard]] size_t getEnd() const;
+    [[nodiscard]] Location getLocation() const;
+
+    // lines added or removed above the token by an edit
+    void setLine(size_t line);
 
     [[nodiscard]] static std::string getTypeName(TokenType type);
     [[nodiscard]] static std::string getTypeValue(TokenType type);
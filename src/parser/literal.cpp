@@ -0,0 +1,42 @@
+#include "literal.h"
+
+std::mutex LiteralPool::mutex;
+std::map<std::weak_ptr<wyvern::Wrapper>, LiteralPool::Pool, std::owner_less<>> LiteralPool::pools;
+
+// pointer to the first byte of an [N x i8] constant
+static llvm::Constant *getFirstByte(llvm::GlobalVariable *global) {
+    llvm::Type *i32 = llvm::Type::getInt32Ty(global->getContext());
+    llvm::Type *i64 = llvm::Type::getInt64Ty(global->getContext());
+    llvm::Constant *indices[] = {llvm::ConstantInt::get(i32, 0), llvm::ConstantInt::get(i64, 0)};
+    return llvm::ConstantExpr::getInBoundsGetElementPtr(global->getValueType(), global, indices);
+}
+
+wyvern::Val::Ptr LiteralPool::get(const wyvern::Wrapper::Ptr &context, const std::string &literal) {
+    llvm::Module *module = context->getModule();
+    llvm::GlobalVariable *&global = [&]() -> llvm::GlobalVariable *& {
+        const std::lock_guard lock(mutex);
+
+        auto it = pools.find(context);
+        if (it == pools.end()) {
+            std::erase_if(pools, [](const auto &entry) { return entry.first.expired(); });
+            it = pools.emplace(context, Pool()).first;
+        }
+
+        return it->second[literal];
+    }();
+
+    // in a mergeable string section, equal literals of other modules and suffixes share their bytes at link time
+    if (!global) {
+        llvm::Constant *data = llvm::ConstantDataArray::getString(*context->getContext(), literal);
+        global = new llvm::GlobalVariable(*module, data->getType(), true, llvm::GlobalValue::PrivateLinkage, data, ".str");
+        global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+        global->setAlignment(llvm::Align(1));
+    }
+
+    return wyvern::Val::create(context, context->getUnsignedPtrTy(8), getFirstByte(global));
+}
+
+void LiteralPool::release(const wyvern::Wrapper::Ptr &context) {
+    const std::lock_guard lock(mutex);
+    pools.erase(context);
+}
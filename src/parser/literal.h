@@ -0,0 +1,27 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "../wyvern/src/wyvern.hpp"
+
+// string literals of a module, every distinct string is generated once as a private unnamed_addr C string,
+// the linker merges equal ones across objects and tail merges them in its string sections
+class LiteralPool {
+public:
+    // pointer to the NUL-terminated string, uses of the same string share one global
+    static wyvern::Val::Ptr get(const wyvern::Wrapper::Ptr &context, const std::string &literal);
+
+    // forget the module's strings, called once the module is generated
+    static void release(const wyvern::Wrapper::Ptr &context);
+
+private:
+    using Pool = std::map<std::string, llvm::GlobalVariable *>;
+
+    // by owner of the context, a weak key keeps its control block alive so a later context can't take over the
+    // pool of one whose generation threw before release(), those are dropped once their context is gone
+    static std::mutex mutex;
+    static std::map<std::weak_ptr<wyvern::Wrapper>, Pool, std::owner_less<>> pools;
+};
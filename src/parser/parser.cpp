@@ -1,93 +1,349 @@
 #include "parser.h"
 
+#include <algorithm>
+#include <charconv>
+#include <sstream>
 #include <thread>
 #include <utility>
 
 #include "function.h"
 
-Parser::Parser(Token::Vec tokens) : root(std::make_shared<Root>()), tokens(std::move(tokens)) {}
+Parser::Parser(Token::Vec tokens, Diagnostics::Ptr diagnostics, std::map<std::string, StructType::Ptr> structs)
+: root(makeNode<Root>()), tokens(std::move(tokens)),
+  diagnostics(diagnostics ? std::move(diagnostics) : std::make_shared<Diagnostics>()), lastError(nullptr), blockDepth(0),
+  structs(std::move(structs)) {
+    // the parser always has a token to look at, even past the last one
+    const size_t line = this->tokens.empty() ? 1 : this->tokens.back().getLine();
+    const size_t column = this->tokens.empty() ? 1 : this->tokens.back().getEnd() + 1;
+    this->tokens.emplace_back(END_OF_FILE, "", line, column, column);
+}
 
 Root::Ptr Parser::parse() {
     it = tokens.begin();
 
-    Stmt::Ptr stmt;
-    while (it != tokens.end())
-        if ((stmt = parseStmt())) { // check if stmt isn't null
-            if (stmt->kind() != AST::Block
-                && stmt->kind() != AST::Function) // expect ';' after stmt
+    while (*it != END_OF_FILE && !diagnostics->limitReached()) {
+        const size_t first = it - tokens.begin();
+
+        try {
+            Stmt::Ptr stmt = parseStmt();
+            if (!stmt->endsWithBlock()) // expect ';' after stmt
                 expect(SEMICOLON);
             root->addStmt(stmt);
+        } catch (const ParseError &) {
+            root->addStmt(makeNode<ErrorExpr>());
+            synchronize();
         }
 
+        spans.emplace_back(first, std::max<size_t>(it - tokens.begin(), first + 1) - 1);
+    }
+
     return root;
 }
 
-Stmt::Ptr Parser::parseStmt() { return parseFunctionStmt(); }
+Stmt::Ptr Parser::instantiate(Token::Vec tokens, std::map<std::string, StructType::Ptr> structs, Type::Vec arguments) {
+    Parser parser(std::move(tokens));
+    parser.structs = std::move(structs);
+    parser.instance = std::move(arguments);
+    parser.it = parser.tokens.begin();
+
+    try {
+        Stmt::Ptr function = parser.parseGenericFunctionStmt();
+        if (!parser.diagnostics->hasErrors() && function->kind() == AST::Function)
+            return function;
+    } catch (const ParseError &) {}
+
+    std::stringstream ss;
+    parser.diagnostics->print(ss);
+    throw std::invalid_argument("Could not instantiate generic function: " + ss.str());
+}
+
+Stmt::Ptr Parser::parseStmt() { return parseImportStmt(); }
 
-Stmt::Ptr Parser::parseFunctionStmt() {
-    if (*it == IDENTIFIER && peek() == LPAREN) {
-        auto start = it++; // start at the lparen
-
-        // skip any other parens
-        for (size_t depth = 0;;) {
-            if      (eat(LPAREN)) ++depth;
-            else if (eat(RPAREN)) --depth;
-            else if (it == tokens.end()) {
-                std::cerr << "Expected ')' at line " << it->getLine() << ":" << it->getStart() << std::endl;
-                return nullptr;
-            } else eat();
-
-            // it doesn't check whether depth is < 0
-            // as the function parameters will be parsed
-            // later and any error doesn't matter yet
-            if (depth <= 0)
-                break;
+Stmt::Ptr Parser::parseImportStmt() {
+    // import module; or import dir.module;
+    if (*it != IDENTIFIER || it->getValue() != "import" || peek() != IDENTIFIER)
+        return parseStructStmt();
+
+    if (blockDepth > 0)
+        error(*it, "Imports are only allowed at the top level");
+
+    const Location location = eat().getLocation();
+    std::string module = expect(IDENTIFIER).getValue();
+    while (eat(DOT))
+        module += "." + expect(IDENTIFIER).getValue();
+
+    auto import = makeNode<ImportStmt>(module);
+    import->setLocation(location);
+    return import;
+}
+
+Stmt::Ptr Parser::parseStructStmt() {
+    StructType::Layout layout;
+    bool annotated = false;
+
+    // @packed, @align(N), @soa
+    while (*it == AT && (peek().getValue() == "packed" || peek().getValue() == "align" || peek().getValue() == "soa")) {
+        ++it;
+        const std::string annotation = eat().getValue();
+
+        if (annotation == "packed")
+            layout.packed = true;
+        else if (annotation == "soa")
+            layout.soa = true;
+        else {
+            expect(LPAREN);
+            layout.align = parseCount("Alignment", StructType::MAX_ALIGN);
+            expect(RPAREN);
         }
 
-        if (*it != POINTER) { // not a function declaration but a function call
-            it = start;
+        annotated = true;
+    }
+
+    // struct Name { field: type, ... }
+    if (*it != IDENTIFIER || it->getValue() != "struct" || peek() != IDENTIFIER) {
+        if (annotated)
+            error(*it, "Expected struct after annotation");
+
+        return parseLoopStmt();
+    }
+
+    if (blockDepth > 0)
+        error(*it, "Structs are only allowed at the top level");
+
+    eat(); // struct
+    const Token &name = eat();
+    StructType::Ptr &type = structs[name.getValue()];
+
+    if (!type)
+        type = std::make_shared<StructType>(name.getValue());
+    else if (type->isDefined())
+        error(name, "Struct " + name.getValue() + " is already declared");
+
+    expect(LBRACE);
+
+    std::vector<StructType::Field> fields = {};
+    while (*it != RBRACE && *it != END_OF_FILE) {
+        std::string field = expect(IDENTIFIER).getValue();
+        expect(COLON);
+        fields.push_back({std::move(field), parseType()});
+
+        if (!eat(COMMA))
+            break;
+    }
+    expect(RBRACE);
+
+    type->define(std::move(fields), layout);
+
+    auto stmt = makeNode<StructStmt>(type);
+    stmt->setLocation(name.getLocation());
+    return stmt;
+}
+
+Stmt::Ptr Parser::parseLoopStmt() {
+    LoopHints hints;
+    bool annotated = false;
+
+    // @unroll, @unroll(N), @vectorize, @vectorize(N)
+    while (*it == AT && (peek().getValue() == "unroll" || peek().getValue() == "vectorize")) {
+        ++it;
+        const bool unroll = eat().getValue() == "unroll";
+        size_t count = 0;
+
+        if (eat(LPAREN)) {
+            count = parseCount(unroll ? "Unroll count" : "Vector width", unroll ? LoopHints::MAX_UNROLL : VectorType::MAX_LANES);
+            expect(RPAREN);
+        }
+
+        if (unroll) {
+            hints.unroll = true;
+            hints.unrollCount = count;
+        } else {
+            hints.vectorize = true;
+            hints.vectorizeWidth = count;
+        }
+
+        annotated = true;
+    }
+
+    if (eat("while")) {
+        Expr::Ptr condition = parseExpr();
+        return makeNode<WhileStmt>(condition, parseBlockExpr(), hints);
+    }
+
+    if (eat("for")) {
+        if (*it == IDENTIFIER && peek().getValue() == "in") { // for i in start..end
+            const Location location = it->getLocation();
+            std::string symbol = eat().getValue();
+            eat(); // in
+            Expr::Ptr start = parseExpr();
+            expect(DOT_DOT);
+            Expr::Ptr end = parseExpr();
+
+            auto loop = makeNode<RangeForStmt>(symbol, start, end, parseBlockExpr(), hints);
+            loop->setLocation(location);
+            return loop;
+        }
+
+        // for init; condition; step
+        Stmt::Ptr init = *it != SEMICOLON ? parseStmt() : nullptr;
+        expect(SEMICOLON);
+        Expr::Ptr condition = *it != SEMICOLON ? parseExpr() : nullptr;
+        expect(SEMICOLON);
+        Expr::Ptr step = *it != LBRACE ? parseExpr() : nullptr;
+        return makeNode<ForStmt>(init, condition, step, parseBlockExpr(), hints);
+    }
+
+    if (annotated)
+        error(*it, "Expected loop after annotation");
+
+    return parseFunctionStmt();
+}
+
+Stmt::Ptr Parser::parseFunctionStmt() {
+    // @comptime name(...) -> type { ... }
+    if (*it == AT && peek().getValue() == "comptime") {
+        ++it;
+        const Token &annotation = eat();
+        Stmt::Ptr function = parseFunctionStmt();
+
+        if (function->kind() != AST::Function)
+            error(annotation, "Expected function after @comptime");
+        else
+            static_cast<Function &>(*function).setComptime(true);
+
+        return function;
+    }
+
+    if (*it == IDENTIFIER && peek() == LESSTHAN) {
+        // name<T, ...>(...) ->
+        int offset = 2;
+        while (peek(offset) == IDENTIFIER && peek(offset + 1) == COMMA)
+            offset += 2;
+
+        if (peek(offset) == IDENTIFIER && peek(offset + 1) == GREATERTHAN && peek(offset + 2) == LPAREN && isParameterList(offset + 2))
+            return parseGenericFunctionStmt();
+    }
+
+    if (*it == IDENTIFIER && peek() == LPAREN) {
+        if (!isParameterList(1)) { // not a function declaration but a function call
             // We have to call parseExpr() instead of parseCallExpr() to handle situations like this one:
             // someCall() = x;
             return parseExpr();
         }
 
-        it = start;
+        const Location location = it->getLocation();
         std::string symbol = eat().getValue();
-        eat(LPAREN);
-
-        Type::Vec parameter_types = {};
-        std::vector<std::string> parameter_names = {};
-        if (*it != RPAREN)
-            do {
-                auto [name, type] = parseFunctionParameter();
-                parameter_names.push_back(std::move(name));
-                parameter_types.push_back(std::move(type));
-            } while (eat(COMMA));
-        expect(RPAREN);
-
-        eat(); // POINTER
-        Type::Ptr type = parseType();
+        return parseFunction(symbol, location);
+    }
+
+    return parseVariableStmt();
+}
 
-        FunctionType::Ptr ftype = std::make_shared<FunctionType>(type, parameter_types);
+Stmt::Ptr Parser::parseGenericFunctionStmt() {
+    const auto start = it;
+    const Location location = it->getLocation();
+    std::string symbol = eat().getValue();
+    eat(); // <
+
+    std::vector<std::string> typeParameters = {};
+    do typeParameters.push_back(expect(IDENTIFIER).getValue()); while (eat(COMMA));
+    expect(GREATERTHAN);
+
+    if (blockDepth > 0)
+        error(*start, "Generic functions are only allowed at the top level");
+
+    // bound to placeholders for the declaration, or to the type arguments when parsing an instance
+    const Type::Vec arguments = std::exchange(instance, {});
+    if (!arguments.empty() && arguments.size() != typeParameters.size())
+        fail(*start, "Expected " + std::to_string(typeParameters.size()) + " type arguments for " + symbol);
+
+    const std::map<std::string, Type::Ptr> enclosing = typeArguments;
+    for (size_t i = 0; i < typeParameters.size(); ++i)
+        typeArguments[typeParameters[i]] = arguments.empty() ? std::make_shared<GenericType>(typeParameters[i]) : arguments[i];
+
+    Stmt::Ptr function;
+    try {
+        function = parseFunction(arguments.empty() ? symbol : GenericFunction::mangle(symbol, arguments), location);
+    } catch (const ParseError &) {
+        typeArguments = enclosing;
+        throw;
+    }
+    typeArguments = enclosing;
 
-        if (*it == SEMICOLON)
-            return std::make_shared<FunctionPrototype>(symbol, ftype, parameter_names);
+    if (!arguments.empty())
+        return function;
 
-        Stmt::Ptr body;
-        if (*it == LBRACE)
-            body = parseBlockExpr();
-        else {
-            body = parseStmt();
-            expect(SEMICOLON);
-        }
-        return std::make_shared<Function>(symbol, ftype, parameter_names, body);
+    if (function->kind() != AST::Function)
+        fail(*start, "Generic function " + symbol + " needs a body");
+
+    const auto &declared = static_cast<const Function &>(*function);
+    auto generic = makeNode<GenericFunction>(symbol, typeParameters, declared.getFunctionType(), declared.getParameters(),
+        Token::Vec(start, it), structs);
+    generic->setLocation(location);
+    return generic;
+}
+
+Stmt::Ptr Parser::parseFunction(const std::string &symbol, const Location &location) {
+    expect(LPAREN);
+
+    Type::Vec parameter_types = {};
+    std::vector<std::string> parameter_names = {};
+    if (*it != RPAREN)
+        do {
+            auto [name, type] = parseFunctionParameter();
+            parameter_names.push_back(std::move(name));
+            parameter_types.push_back(std::move(type));
+        } while (eat(COMMA));
+    expect(RPAREN);
+
+    eat(); // POINTER
+    Type::Ptr type = parseType();
+
+    FunctionType::Ptr ftype = std::make_shared<FunctionType>(type, parameter_types);
+
+    if (*it == SEMICOLON) {
+        auto prototype = makeNode<FunctionPrototype>(symbol, ftype, parameter_names);
+        prototype->setLocation(location);
+        return prototype;
     }
 
-    return parseVariableStmt();
+    Stmt::Ptr body;
+    if (*it == LBRACE)
+        body = parseBlockExpr();
+    else {
+        body = parseStmt();
+        expect(SEMICOLON);
+    }
+
+    auto function = makeNode<Function>(symbol, ftype, parameter_names, body);
+    function->setLocation(location);
+    return function;
+}
+
+bool Parser::isParameterList(int offset) {
+    auto cursor = it + offset; // at the lparen
+
+    // skip any other parens
+    for (size_t depth = 0;;) {
+        if      (*cursor == LPAREN) ++depth;
+        else if (*cursor == RPAREN) --depth;
+        else if (*cursor == END_OF_FILE)
+            fail(*cursor, "Expected ')'");
+        ++cursor;
+
+        // it doesn't check whether depth is < 0
+        // as the function parameters will be parsed
+        // later and any error doesn't matter yet
+        if (depth <= 0)
+            break;
+    }
+
+    return *cursor == POINTER;
 }
 
 Stmt::Ptr Parser::parseVariableStmt() {
     if (*it == IDENTIFIER && peek() == COLON) {
+        const Location location = it->getLocation();
         std::string symbol = eat().getValue();
         eat(); // colon
         Type::Ptr type = parseType();
@@ -96,7 +352,9 @@ Stmt::Ptr Parser::parseVariableStmt() {
         if (eat(EQUALS))
             value = parseExpr();
 
-        return std::make_shared<VariableStmt>(symbol, type, value);
+        auto variable = makeNode<VariableStmt>(symbol, type, value);
+        variable->setLocation(location);
+        return variable;
     }
 
     return parseReturnStmt();
@@ -107,9 +365,9 @@ Stmt::Ptr Parser::parseReturnStmt() {
         return parseExpr();
 
     if (*it == SEMICOLON)
-        return std::make_shared<ReturnStmt>();
+        return makeNode<ReturnStmt>();
 
-    return std::make_shared<ReturnStmt>(parseExpr());
+    return makeNode<ReturnStmt>(parseExpr());
 }
 
 
@@ -119,7 +377,7 @@ Expr::Ptr Parser::parseAssignmentExpr() {
     Expr::Ptr LHS = parseCallExpr();
 
     if (LHS && eat(EQUALS))
-        return std::make_shared<AssignmentExpr>(LHS ,parseExpr());
+        return makeNode<AssignmentExpr>(LHS ,parseExpr());
 
     return LHS;
 }
@@ -136,33 +394,63 @@ Expr::Ptr Parser::parseCallExpr() {
             expect(RPAREN);
         }
 
-        return std::make_shared<CallExpr>(callee, args);
+        return makeNode<CallExpr>(callee, args);
     }
 
     return callee;
 }
 
-Expr::Ptr Parser::parseBlockExpr() {
+Expr::Ptr Parser::parseBlockExpr(bool arena) {
     if (eat(LBRACE)) {
         Stmt::Vec stmts = {};
+        ++blockDepth;
 
-        while (!eat(RBRACE))
-            if (it == tokens.end())
-                std::cerr << "Expected '}' at line " << it->getLine() << ":" << it->getStart() << std::endl;
-            else {
+        while (!eat(RBRACE)) {
+            if (*it == END_OF_FILE || diagnostics->limitReached()) {
+                --blockDepth;
+                fail(*it, "Expected '}'");
+            }
+
+            try {
                 stmts.push_back(parseStmt());
-                if (stmts.back()->isExpr() && *it != SEMICOLON) { // convert trailing expr to return stmt
+                if (stmts.back()->isExpr() && *it == RBRACE) { // convert trailing expr to return stmt
                     auto expr = std::static_pointer_cast<Expr>(stmts.back());
                     stmts.pop_back();
-                    stmts.push_back(std::make_shared<ReturnStmt>(expr));
-                } else if (stmts.back()->kind() != AST::Block)
+                    stmts.push_back(makeNode<ReturnStmt>(expr));
+                } else if (!stmts.back()->endsWithBlock())
                     expect(SEMICOLON);
+            } catch (const ParseError &) {
+                stmts.push_back(makeNode<ErrorExpr>());
+                synchronize();
             }
+        }
 
-        return std::make_shared<BlockExpr>(stmts);
+        --blockDepth;
+        return makeNode<BlockExpr>(stmts, arena);
     }
 
-    return parseAdditiveExpr();
+    return parseComparisonExpr();
+}
+
+Expr::Ptr Parser::parseComparisonExpr() {
+    Expr::Ptr LHS = parseAdditiveExpr();
+
+    for (;;) {
+        BinaryOp op;
+
+        switch (it->getType()) {
+            case LESSTHAN:      op = LT; break;
+            case GREATERTHAN:   op = GT; break;
+            case LTEQUALS:      op = LTE; break;
+            case GTEQUALS:      op = GTE; break;
+            case EQUALS_EQUALS: op = EQ; break;
+            case NOT_EQUALS:    op = NEQ; break;
+            default:            return LHS;
+        }
+
+        ++it;
+        LHS = makeNode<BinaryExpr>(op, LHS, parseAdditiveExpr());
+    }
 }
 
 Expr::Ptr Parser::parseAdditiveExpr() {
@@ -170,7 +458,7 @@ Expr::Ptr Parser::parseAdditiveExpr() {
 
     while (*it == PLUS || *it == MINUS) {
         auto op = eat() == PLUS ? ADD : SUB;
-        LHS = std::make_shared<BinaryExpr>(op, LHS, parseMultiplicativeExpr());
+        LHS = makeNode<BinaryExpr>(op, LHS, parseMultiplicativeExpr());
     }
 
     return LHS;
@@ -181,7 +469,7 @@ Expr::Ptr Parser::parseMultiplicativeExpr() {
 
     while (*it == ASTERISK || *it == SLASH) {
         auto op = eat() == ASTERISK ? MUL : DIV;
-        LHS = std::make_shared<BinaryExpr>(op, LHS, parsePowerExpr());
+        LHS = makeNode<BinaryExpr>(op, LHS, parsePowerExpr());
     }
 
     return LHS;
@@ -191,21 +479,21 @@ Expr::Ptr Parser::parsePowerExpr() {
     Expr::Ptr LHS = parseAddressOfExpr();
 
     while (eat(CARET))
-        LHS = std::make_shared<BinaryExpr>(POW, LHS, parseAddressOfExpr());
+        LHS = makeNode<BinaryExpr>(POW, LHS, parseAddressOfExpr());
 
     return LHS;
 }
 
 Expr::Ptr Parser::parseAddressOfExpr() {
     if (eat(BIT_AND))
-        return std::make_shared<UnaryExpr>(ADDR, parseAddressOfExpr());
+        return makeNode<UnaryExpr>(ADDR, parseAddressOfExpr());
 
     return parseDereferenceExpr();
 }
 
 Expr::Ptr Parser::parseDereferenceExpr() {
     if (eat(ASTERISK))
-        return std::make_shared<UnaryExpr>(DEREF, parseDereferenceExpr());
+        return makeNode<UnaryExpr>(DEREF, parseDereferenceExpr());
 
     return parseIncrementDecrementExpr();
 }
@@ -214,31 +502,107 @@ Expr::Ptr Parser::parseIncrementDecrementExpr() {
     Expr::Ptr LHS;
 
     if (*it == MINUS_MINUS || *it == PLUS_PLUS)
-        LHS = std::make_shared<UnaryExpr>(eat() == MINUS_MINUS ? PRE_DEC : PRE_INC, parseIncrementDecrementExpr());
+        LHS = makeNode<UnaryExpr>(eat() == MINUS_MINUS ? PRE_DEC : PRE_INC, parseIncrementDecrementExpr());
     else
-        LHS = parsePrimaryExpr();
+        LHS = parseIndexExpr();
 
     while (*it == MINUS_MINUS || *it == PLUS_PLUS)
-        LHS = std::make_shared<UnaryExpr>(eat() == MINUS_MINUS ? POST_DEC : POST_INC, LHS);
+        LHS = makeNode<UnaryExpr>(eat() == MINUS_MINUS ? POST_DEC : POST_INC, LHS);
+
+    return LHS;
+}
+
+Expr::Ptr Parser::parseIndexExpr() {
+    Expr::Ptr LHS = parsePrimaryExpr();
+
+    while (LHS && (*it == LBRACKET || *it == DOT)) {
+        if (eat(DOT)) { // field access
+            LHS = makeNode<MemberExpr>(LHS, expect(IDENTIFIER).getValue());
+            continue;
+        }
+
+        eat(); // lbracket
+        Expr::Ptr index = parseExpr();
+        expect(RBRACKET);
+        LHS = makeNode<IndexExpr>(LHS, index);
+    }
 
     return LHS;
 }
 
 Expr::Ptr Parser::parsePrimaryExpr() {
     switch (it->getType()) {
-        case IDENTIFIER: return std::make_shared<SymbolExpr>(eat().getValue());
-        case NUMBER:
-        case LITERAL: return std::make_shared<ValueExpr>(eat());
+        case IDENTIFIER: {
+            const Location location = it->getLocation();
+            std::string name = eat().getValue();
+
+            // qualified name, e.g. core::println
+            while (eat(COLON_COLON))
+                name += "::" + expect(IDENTIFIER).getValue();
+
+            auto symbol = makeNode<SymbolExpr>(name);
+            symbol->setLocation(location);
+            return symbol;
+        }
+        case NUMBER: {
+            // the value is converted by ValueExpr, which can't report a literal out of range
+            const std::string value = it->getValue();
+            int64_t integer = 0;
+            double real = 0;
+            const auto [end, ec] = value.find('.') == std::string::npos
+                ? std::from_chars(value.data(), value.data() + value.size(), integer)
+                : std::from_chars(value.data(), value.data() + value.size(), real);
+
+            if (ec != std::errc() || end != value.data() + value.size())
+                fail(*it, "Number " + value + " is out of range");
+
+            return makeNode<ValueExpr>(eat());
+        }
+        case LITERAL: return makeNode<ValueExpr>(eat());
         case LPAREN: {
             ++it;
             Expr::Ptr expr = parseExpr();
             expect(RPAREN);
             return expr;
         }
+        case AT: { // builtin
+            ++it;
+
+            // @arena { ... }
+            if (it->getValue() == "arena" && peek() == LBRACE) {
+                ++it;
+                return parseBlockExpr(true);
+            }
+
+            const Token &name = expect(IDENTIFIER);
+            const std::optional<Builtin> builtin = getBuiltin(name.getValue());
+
+            if (!builtin)
+                fail(name, "Unknown builtin '@" + name.getValue() + "'");
+
+            expect(LPAREN);
+
+            Type::Ptr type = nullptr;
+            if (takesType(*builtin)) {
+                type = parseType();
+                eat(COMMA);
+            }
+
+            Expr::Vec args = {};
+            if (*it != RPAREN)
+                do args.push_back(parseExpr()); while (eat(COMMA));
+            expect(RPAREN);
+
+            return makeNode<BuiltinExpr>(*builtin, type, args);
+        }
         default: {
-            std::cerr << "Unexpected token '" << it->getValue() << "' at line " << it->getLine() << ":" << it->getStart() << std::endl;
-            eat();
-            return nullptr;
+            error(*it, "Unexpected " + (*it == END_OF_FILE ? "end of file" : "token '" + it->getValue() + "'"));
+
+            // leave the statement's end for the caller to synchronize on
+            if (*it != SEMICOLON && *it != RBRACE)
+                eat();
+
+            return makeNode<ErrorExpr>();
         }
     }
 }
@@ -246,8 +610,28 @@ Expr::Ptr Parser::parsePrimaryExpr() {
 Type::Ptr Parser::parseType(bool parameter) {
     Type::Ptr type = nullptr;
 
-    if (*it == IDENTIFIER) {
-        type = Type::create(eat());
+    if (eat(LBRACKET)) { // [N]T array or []T slice
+        if (eat(RBRACKET))
+            type = std::make_shared<SliceType>(parseType());
+        else {
+            const size_t size = parseCount("Array size", ArrayType::MAX_SIZE);
+            expect(RBRACKET);
+            type = std::make_shared<ArrayType>(parseType(), size);
+        }
+    } else if (*it == IDENTIFIER) {
+        const Token &name = eat();
+        type = typeArguments.contains(name.getValue()) ? typeArguments[name.getValue()] : Type::create(name);
+
+        if (type->isVector() && !VectorType::isValidLanes(std::static_pointer_cast<VectorType>(type)->getLanes()))
+            fail(name, "Vector types need 1 to " + std::to_string(VectorType::MAX_LANES) + " lanes");
+
+        // any other name is a struct, possibly declared further down
+        if (type->getKind() == Type::AUTO && name.getValue() != "auto") {
+            StructType::Ptr &structType = structs[name.getValue()];
+            if (!structType)
+                structType = std::make_shared<StructType>(name.getValue());
+            type = structType;
+        }
 
         while (eat(ASTERISK))
             type = type->getPointerTo();
@@ -271,15 +655,28 @@ std::pair<std::string, Type::Ptr> Parser::parseFunctionParameter() {
     return {"", parseType(true)};
 }
 
-constexpr const Token &Parser::eat() {
-    if (it != tokens.end())
+size_t Parser::parseCount(const std::string &what, size_t max) {
+    const Token &token = expect(NUMBER);
+    const std::string value = token.getValue();
+    size_t count = 0;
+
+    // numbers may be fractional or too large for any count
+    const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), count);
+    if (ec != std::errc() || end != value.data() + value.size() || count > max)
+        fail(token, what + " must be a whole number up to " + std::to_string(max));
+
+    return count;
+}
+
+const Token &Parser::eat() {
+    if (*it != END_OF_FILE)
         return *it++;
 
     return *it;
 }
 
-constexpr bool Parser::eat(TokenType type) {
-    if (it != tokens.end() && *it == type) {
+bool Parser::eat(TokenType type) {
+    if (*it != END_OF_FILE && *it == type) {
         ++it;
         return true;
     }
@@ -287,8 +684,8 @@ constexpr bool Parser::eat(TokenType type) {
     return false;
 }
 
-constexpr bool Parser::eat(const std::string &value) {
-    if (it != tokens.end() && it->getValue() == value) {
+bool Parser::eat(const std::string &value) {
+    if (*it != END_OF_FILE && it->getValue() == value) {
         ++it;
         return true;
     }
@@ -301,12 +698,51 @@ constexpr const Token &Parser::peek(int offset) const {
 }
 
 const Token &Parser::expect(TokenType type) {
-    if (it == tokens.end() || *it != type)
-        // TODO: proper errors
-        std::cerr << "Expected '"+Token::getTypeValue(type)+"' at line " << it->getLine() << ":" << it->getStart() << std::endl;
+    if (*it != type)
+        fail(*it, "Expected '" + Token::getTypeValue(type) + "' but found "
+            + (*it == END_OF_FILE ? "end of file" : "'" + it->getValue() + "'"));
 
-    if (it != tokens.end())
-        return *it++;
+    return *it++;
+}
 
-    return *it;
+void Parser::error(const Token &token, const std::string &message) {
+    if (&token == lastError)
+        return;
+
+    lastError = &token;
+    diagnostics->error(token.getLine(), token.getStart(), message);
+}
+
+void Parser::fail(const Token &token, const std::string &message) {
+    error(token, message);
+    throw ParseError(message);
+}
+
+void Parser::synchronize() {
+    size_t depth = 0; // blocks opened while skipping are skipped as a whole
+
+    while (*it != END_OF_FILE) {
+        if (*it == SEMICOLON && depth == 0) {
+            ++it;
+            return;
+        }
+
+        if (*it == LBRACE)
+            ++depth;
+        else if (*it == RBRACE) {
+            if (depth == 0) {
+                // the '}' closes the enclosing block, a stray one at the top level is dropped
+                if (blockDepth == 0)
+                    ++it;
+                return;
+            }
+
+            if (--depth == 0) {
+                ++it;
+                return;
+            }
+        }
+
+        ++it;
+    }
 }
\ No newline at end of file
@@ -3,46 +3,92 @@
 #include "../ast/function.h"
 #include "../lexer/token.h"
 #include "../ast/expr.h"
+#include "../ast/loop.h"
+#include "../util/diagnostics.h"
+
+// thrown to abandon the current statement, the parser then synchronizes at the next ';' or '}'
+class ParseError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
 
 class Parser {
 public:
-    explicit Parser(Token::Vec tokens);
+    // structs are those declared or used by the rest of the file when only part of it is parsed
+    explicit Parser(Token::Vec tokens, Diagnostics::Ptr diagnostics = nullptr, std::map<std::string, StructType::Ptr> structs = {});
 
+    // statements that fail to parse become ErrorExpr nodes, check getDiagnostics() for errors
     Root::Ptr parse();
+    // parse the tokens of a generic function again with its type parameters bound to arguments,
+    // throws std::invalid_argument if they don't form a function
+    static Stmt::Ptr instantiate(Token::Vec tokens, std::map<std::string, StructType::Ptr> structs, Type::Vec arguments);
+
+    [[nodiscard]] const Diagnostics::Ptr &getDiagnostics() const { return diagnostics; }
+    // every struct declared or used so far, by name
+    [[nodiscard]] const std::map<std::string, StructType::Ptr> &getStructs() const { return structs; }
+    // indices of the first and last token of every top-level statement
+    [[nodiscard]] const std::vector<std::pair<size_t, size_t>> &getSpans() const { return spans; }
 
     Stmt::Ptr parseStmt();
+    Stmt::Ptr parseImportStmt();
+    Stmt::Ptr parseStructStmt();
+    Stmt::Ptr parseLoopStmt();
     Stmt::Ptr parseFunctionStmt();
+    Stmt::Ptr parseGenericFunctionStmt();
     Stmt::Ptr parseVariableStmt();
     Stmt::Ptr parseReturnStmt();
 
     Expr::Ptr parseExpr();
     Expr::Ptr parseAssignmentExpr();
     Expr::Ptr parseCallExpr();
-    Expr::Ptr parseBlockExpr();
+    Expr::Ptr parseBlockExpr(bool arena = false);
+    Expr::Ptr parseComparisonExpr();
     Expr::Ptr parseAdditiveExpr();
     Expr::Ptr parseMultiplicativeExpr();
     Expr::Ptr parsePowerExpr();
     Expr::Ptr parseAddressOfExpr();
     Expr::Ptr parseDereferenceExpr();
     Expr::Ptr parseIncrementDecrementExpr();
+    Expr::Ptr parseIndexExpr();
     Expr::Ptr parsePrimaryExpr();
 
     Type::Ptr parseType(bool parameter = false);
     std::pair<std::string, Type::Ptr> parseFunctionParameter();
 
 private:
+    // parameter list, return type and body of a function or prototype, starting at the '('
+    Stmt::Ptr parseFunction(const std::string &symbol, const Location &location);
+    // the next token as a whole number up to max, array sizes and annotation arguments
+    size_t parseCount(const std::string &what, size_t max);
+    // is the parenthesized list offset tokens ahead followed by '->'? doesn't move
+    bool isParameterList(int offset);
+
     // advance to the next token and return the current
-    constexpr const Token &eat();
+    const Token &eat();
     // advance to the next token and return true if the current token is of the given type
-    constexpr bool eat(TokenType type);
+    bool eat(TokenType type);
     // advance to the next token and return true if the current token has the given value
-    constexpr bool eat(const std::string &value);
+    bool eat(const std::string &value);
     // advance to the next token if the current token is of the given type, throw error otherwise
     const Token &expect(TokenType type);
     // peek to the next token, further or back (does not check for EOF)
     [[nodiscard]] constexpr const Token &peek(int offset = 1) const;
 
+    // report an error at the token, repeated errors at the same token are dropped
+    void error(const Token &token, const std::string &message);
+    // report an error and abandon the current statement
+    [[noreturn]] void fail(const Token &token, const std::string &message);
+    // skip to the start of the next statement
+    void synchronize();
+
     Root::Ptr root;
     Token::Vec tokens;
     Token::Vec::const_iterator it;
+    Diagnostics::Ptr diagnostics;
+    std::vector<std::pair<size_t, size_t>> spans;
+    const Token *lastError; // token of the last reported error
+    size_t blockDepth;      // nesting of the block being parsed
+    std::map<std::string, StructType::Ptr> structs; // by name, created by the first use or the declaration
+    std::map<std::string, Type::Ptr> typeArguments; // type parameters of the generic function being parsed
+    Type::Vec instance;                             // type arguments of the instance being parsed, if any
 };
@@ -0,0 +1,165 @@
+#include "source.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "../ast/visitor.h"
+#include "../lexer/lexer.h"
+
+// move a statement that kept its tree down by delta lines, together with the symbols it declares
+static void shiftLines(Stmt &node, long delta) {
+    if (node.getLocation().line > 0)
+        node.setLocation({node.getLocation().line + delta, node.getLocation().column});
+
+    const auto place = [&](const Symbol::Ptr &symbol) {
+        if (symbol)
+            symbol->setLocation(node.getLocation());
+    };
+
+    switch (node.kind()) {
+        case AST::Variable:
+            place(static_cast<VariableStmt &>(node).getDeclaration());
+            break;
+        case AST::RangeFor:
+            place(static_cast<RangeForStmt &>(node).getCounter());
+            break;
+        case AST::Function:
+            for (const Symbol::Ptr &parameter : static_cast<Function &>(node).getParameterSymbols())
+                place(parameter);
+            [[fallthrough]];
+        case AST::FunctionPrototype:
+            place(static_cast<FunctionPrototype &>(node).getDeclaration());
+            break;
+        default:
+            break;
+    }
+
+    forEachChild(node, [&](Stmt &child) { shiftLines(child, delta); });
+}
+
+SourceFile::SourceFile(std::string text, std::string name)
+: text(std::move(text)), name(std::move(name)), tokens({}), root(nullptr), diagnostics(nullptr), spans({}) {
+    reparse();
+}
+
+SourceFile::Change SourceFile::apply(const Edit &edit) {
+    const size_t begin = offsetOf(edit.start);
+    const size_t end = std::max(begin, offsetOf(edit.end));
+    text.replace(begin, end - begin, edit.text);
+
+    const auto delta = static_cast<long>(std::ranges::count(edit.text, '\n')) - static_cast<long>(edit.end.line - edit.start.line);
+
+    // errors may come from anywhere, only a clean file can be updated in place
+    if (diagnostics->hasErrors())
+        return reparse();
+
+    // grow the edited lines until they cover whole statements, in lines before the edit
+    size_t firstLine = edit.start.line, lastLine = edit.end.line;
+    for (bool grown = true; grown;) {
+        grown = false;
+
+        for (const Span &span : spans)
+            if (span.lastLine >= firstLine && span.firstLine <= lastLine) {
+                grown |= span.firstLine < firstLine || span.lastLine > lastLine;
+                firstLine = std::min(firstLine, span.firstLine);
+                lastLine = std::max(lastLine, span.lastLine);
+            }
+    }
+
+    // an edit between statements replaces none of them, but still inserts at the right place
+    const size_t first = std::ranges::count_if(spans, [&](const Span &span) { return span.lastLine < firstLine; });
+    const size_t count = std::ranges::count_if(spans, [&](const Span &span) {
+        return span.lastLine >= firstLine && span.firstLine <= lastLine;
+    });
+
+    // re-lex the covered lines as they are after the edit
+    const size_t newLastLine = lastLine + delta;
+    const size_t from = offsetOf({firstLine, 1});
+    size_t to = offsetOf({newLastLine, 1});
+    to = std::min(text.find('\n', to), text.size());
+
+    Token::Vec relexed = Lexer(text.substr(from, to - from)).lex(firstLine);
+
+    // statements after the edit keep their tokens, shifted in place by the lines added or removed instead of copied
+    const auto coveredBegin = std::ranges::partition_point(tokens, [&](const Token &token) { return token.getLine() < firstLine; });
+    const auto coveredEnd = std::partition_point(coveredBegin, tokens.end(), [&](const Token &token) { return token.getLine() <= lastLine; });
+
+    if (delta != 0)
+        for (auto token = coveredEnd; token != tokens.end(); ++token)
+            token->setLine(token->getLine() + delta);
+
+    const auto inserted = tokens.erase(coveredBegin, coveredEnd);
+    tokens.insert(inserted, relexed.begin(), relexed.end());
+
+    // the rest of the file holds on to the types of the structs declared in the region
+    const Stmt::Vec &program = root->getProgram();
+    if (std::any_of(program.begin() + first, program.begin() + first + count, [](const Stmt::Ptr &stmt) { return stmt->kind() == AST::Struct; }))
+        return reparse();
+
+    // a region that doesn't parse on its own (e.g. an unbalanced brace) may change how the rest parses
+    auto regionDiagnostics = std::make_shared<Diagnostics>(name);
+    Parser parser(relexed, regionDiagnostics, structs);
+    const Root::Ptr region = parser.parse();
+
+    if (regionDiagnostics->hasErrors())
+        return reparse();
+
+    structs = parser.getStructs();
+    Change change = {false, first, Stmt::Vec(program.begin() + first, program.begin() + first + count), region->getProgram()};
+    root->replaceStmts(first, count, change.inserted);
+
+    std::vector<Span> regionSpans = toLines(parser, relexed);
+    for (size_t i = first + count; i < spans.size(); ++i) {
+        spans[i].firstLine += delta;
+        spans[i].lastLine += delta;
+
+        if (delta != 0)
+            shiftLines(*program[i - count + change.inserted.size()], delta);
+    }
+
+    spans.erase(spans.begin() + first, spans.begin() + first + count);
+    spans.insert(spans.begin() + first, regionSpans.begin(), regionSpans.end());
+
+    return change;
+}
+
+SourceFile::Change SourceFile::reparse() {
+    tokens = Lexer(text).lex();
+    diagnostics = std::make_shared<Diagnostics>(name);
+
+    Parser parser(tokens, diagnostics);
+    const Stmt::Vec removed = root ? root->getProgram() : Stmt::Vec();
+    root = parser.parse();
+    spans = toLines(parser, tokens);
+    structs = parser.getStructs();
+
+    return {true, 0, removed, root->getProgram()};
+}
+
+size_t SourceFile::offsetOf(const Location &location) const {
+    size_t offset = 0;
+
+    for (size_t line = 1; line < location.line; ++line) {
+        const size_t next = text.find('\n', offset);
+        if (next == std::string::npos)
+            return text.size();
+
+        offset = next + 1;
+    }
+
+    const size_t lineEnd = std::min(text.find('\n', offset), text.size());
+    return std::min(offset + (location.column > 0 ? location.column - 1 : 0), lineEnd);
+}
+
+std::vector<SourceFile::Span> SourceFile::toLines(const Parser &parser, const Token::Vec &tokens) {
+    std::vector<Span> lines = {};
+
+    for (const auto &[first, last] : parser.getSpans()) {
+        // the last span may end at the end of file token
+        const Token &start = tokens[std::min(first, tokens.size() - 1)];
+        const Token &end = tokens[std::min(last, tokens.size() - 1)];
+        lines.push_back({start.getLine(), end.getLine()});
+    }
+
+    return lines;
+}
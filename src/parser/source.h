@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "parser.h"
+
+// a parsed source file kept up to date with text edits, only the edited lines are lexed again
+// and only the top-level statements touching them are parsed again and spliced into the tree
+class SourceFile {
+public:
+    // replace the text from start up to (excluding) end
+    struct Edit {
+        Location start, end;
+        std::string text;
+    };
+
+    // what an edit changed in the tree
+    struct Change {
+        bool full;          // the whole file was parsed again
+        size_t first;       // index of the first re-parsed top-level statement
+        Stmt::Vec removed;  // statements replaced by the edit
+        Stmt::Vec inserted;
+    };
+
+    explicit SourceFile(std::string text, std::string name = "");
+
+    Change apply(const Edit &edit);
+
+    [[nodiscard]] const std::string &getText() const { return text; }
+    [[nodiscard]] const Token::Vec &getTokens() const { return tokens; }
+    [[nodiscard]] const Root::Ptr &getRoot() const { return root; }
+    [[nodiscard]] const Diagnostics::Ptr &getDiagnostics() const { return diagnostics; }
+
+private:
+    // first and last line of a top-level statement
+    struct Span {
+        size_t firstLine, lastLine;
+    };
+
+    // lex and parse everything
+    Change reparse();
+    // offset of a location in the text, clamped to the end of its line
+    [[nodiscard]] size_t offsetOf(const Location &location) const;
+    // spans of the parsed statements in lines
+    static std::vector<Span> toLines(const Parser &parser, const Token::Vec &tokens);
+
+    std::string text;
+    std::string name;
+    Token::Vec tokens;
+    Root::Ptr root;
+    Diagnostics::Ptr diagnostics;
+    std::vector<Span> spans; // one per top-level statement, in order
+    std::map<std::string, StructType::Ptr> structs; // of the whole file, a re-parsed region uses the same types
+};
@@ -1,17 +1,27 @@
 #include "type.h"
 
+#include <algorithm>
+#include <charconv>
+#include <set>
 #include <sstream>
 #include <utility>
 #include "../analyzer/analyzer.h"
 
 const char *TypeKindString[] = {
     "void",
+    "bool",
     "u8",
     "i32",
     "i64",
     "f64",
     "ptr",
     "ref",
+    "func",
+    "array",
+    "slice",
+    "vector",
+    "struct",
+    "generic",
     "literal",
     "auto",
 };
@@ -23,7 +33,26 @@ Type::Type(Kind kind) : kind(kind) {}
 Type::~Type() = default;
 
 Type::Ptr Type::create(const Token &token) {
-    return std::make_shared<Type>(getKind(token.getValue()));
+    const std::string value = token.getValue();
+
+    // vector types: <scalar>x<lanes>
+    const size_t x = value.rfind('x');
+    if (x != std::string::npos && x + 1 < value.size()
+        && std::all_of(value.begin() + x + 1, value.end(), [](char c) { return std::isdigit(c); }))
+        switch (const Kind element = getKind(value.substr(0, x))) {
+            case U8:
+            case I32:
+            case I64:
+            case F64: {
+                // out of range leaves 0 lanes, the parser rejects the type
+                size_t lanes = 0;
+                std::from_chars(value.data() + x + 1, value.data() + value.size(), lanes);
+                return std::make_shared<VectorType>(std::make_shared<Type>(element), lanes);
+            }
+            default:    break;
+        }
+
+    return std::make_shared<Type>(getKind(value));
 }
 
 std::string Type::getKindValue(Kind kind) { return TypeKindString[kind]; }
@@ -44,20 +73,70 @@ void Type::analyze(const Analyzer::Ptr &analyzer) {
 
 }
 
-wyvern::Ty::Ptr Type::generate(const wyvern::Wrapper::Ptr &context) {
+const wyvern::Ty::Ptr &Type::generate(const wyvern::Wrapper::Ptr &context) {
+    // same owner as the live context, returned by reference so the hit doesn't touch the reference count
+    if (!generatedFor.owner_before(context) && !context.owner_before(generatedFor))
+        return generated;
+
+    generated = lower(context);
+    generatedPointer = nullptr;
+    generatedFor = context;
+    return generated;
+}
+
+const wyvern::Ty::Ptr &Type::generatePointerTo(const wyvern::Wrapper::Ptr &context) {
+    const wyvern::Ty::Ptr &pointee = generate(context);
+    if (!generatedPointer)
+        generatedPointer = pointee->getPtrTo();
+
+    return generatedPointer;
+}
+
+wyvern::Ty::Ptr Type::lower(const wyvern::Wrapper::Ptr &context) {
     switch (kind) {
         case VOID:  return context->getVoidTy();
+        case BOOL:  return context->getUnsignedTy(1);
         case U8:    return context->getUnsignedTy(8);
         case I32:   return context->getSignedTy(32);
         case I64:   return context->getSignedTy(64);
         case F64:   return context->getFloatTy(64);
         case PTR: {
             auto cast = std::static_pointer_cast<PointerType>(shared_from_this());
-            return cast->getPointee()->generate(context)->getPtrTo();
+            return cast->getPointee()->generatePointerTo(context);
         }
         case REF: {
             auto cast = std::static_pointer_cast<ReferenceType>(shared_from_this());
-            return cast->getReferee()->generate(context)->getPtrTo();
+            return cast->getReferee()->generatePointerTo(context);
+        }
+        case ARRAY: {
+            auto cast = std::static_pointer_cast<ArrayType>(shared_from_this());
+
+            // structure of arrays, { [N x field0], [N x field1], ... }
+            if (cast->getElement()->isStruct()) {
+                auto element = std::static_pointer_cast<StructType>(cast->getElement());
+
+                if (element->getLayout().soa) {
+                    std::vector<llvm::Type *> arrays = {};
+                    for (const auto &field : element->getFields())
+                        arrays.push_back(llvm::ArrayType::get(field.type->generate(context)->getTy(), cast->getSize()));
+
+                    return wyvern::Ty::create(context, llvm::StructType::get(*context->getContext(), arrays));
+                }
+            }
+
+            llvm::Type *element = cast->getElement()->generate(context)->getTy();
+            return wyvern::Ty::create(context, llvm::ArrayType::get(element, cast->getSize()));
+        }
+        case SLICE: {
+            auto cast = std::static_pointer_cast<SliceType>(shared_from_this());
+            llvm::Type *data = cast->getElement()->generate(context)->getPtrTo()->getTy();
+            llvm::Type *length = context->getSignedTy(64)->getTy();
+            return wyvern::Ty::create(context, llvm::StructType::get(context->getModule()->getContext(), {data, length}));
+        }
+        case VECTOR: {
+            auto cast = std::static_pointer_cast<VectorType>(shared_from_this());
+            llvm::Type *element = cast->getElement()->generate(context)->getTy();
+            return wyvern::Ty::create(context, llvm::FixedVectorType::get(element, cast->getLanes()));
         }
         case LITERAL: return context->getUnsignedPtrTy(8);
         case AUTO:
@@ -80,10 +159,10 @@ bool PointerType::operator==(const Type &comp) const {
     if (comp.getKind() != PTR)
         return false;
 
-    return pointee == dynamic_cast<const PointerType *>(&comp)->pointee;
+    return *this == *dynamic_cast<const PointerType *>(&comp);
 }
 
-bool PointerType::operator==(const PointerType &comp) const { return pointee == comp.pointee; }
+bool PointerType::operator==(const PointerType &comp) const { return *pointee == *comp.pointee; }
 
 Type::Ptr PointerType::getPointee() const { return pointee; }
 
@@ -97,15 +176,70 @@ bool ReferenceType::operator==(const Type &comp) const {
     if (comp.getKind() != REF)
         return false;
 
-    return referee == dynamic_cast<const ReferenceType *>(&comp)->referee;
+    return *this == *dynamic_cast<const ReferenceType *>(&comp);
 }
 
-bool ReferenceType::operator==(const ReferenceType &comp) const { return referee == comp.referee; }
+bool ReferenceType::operator==(const ReferenceType &comp) const { return *referee == *comp.referee; }
 
 Type::Ptr ReferenceType::getReferee() const { return referee; }
 
 std::string ReferenceType::str() const { return "ref<" + referee->str() + ">"; }
 
+// ARRAY TYPE
+
+ArrayType::ArrayType(Type::Ptr element, size_t size) : Type(ARRAY), element(std::move(element)), size(size) {}
+
+bool ArrayType::operator==(const Type &comp) const {
+    if (comp.getKind() != ARRAY)
+        return false;
+
+    return *this == *dynamic_cast<const ArrayType *>(&comp);
+}
+
+bool ArrayType::operator==(const ArrayType &comp) const { return size == comp.size && *element == *comp.element; }
+
+const Type::Ptr &ArrayType::getElement() const { return element; }
+
+size_t ArrayType::getSize() const { return size; }
+
+std::string ArrayType::str() const { return "[" + std::to_string(size) + "]" + element->str(); }
+
+// SLICE TYPE
+
+SliceType::SliceType(Type::Ptr element) : Type(SLICE), element(std::move(element)) {}
+
+bool SliceType::operator==(const Type &comp) const {
+    if (comp.getKind() != SLICE)
+        return false;
+
+    return *this == *dynamic_cast<const SliceType *>(&comp);
+}
+
+bool SliceType::operator==(const SliceType &comp) const { return *element == *comp.element; }
+
+const Type::Ptr &SliceType::getElement() const { return element; }
+
+std::string SliceType::str() const { return "[]" + element->str(); }
+
+// VECTOR TYPE
+
+VectorType::VectorType(Type::Ptr element, size_t lanes) : Type(VECTOR), element(std::move(element)), lanes(lanes) {}
+
+bool VectorType::operator==(const Type &comp) const {
+    if (comp.getKind() != VECTOR)
+        return false;
+
+    return *this == *dynamic_cast<const VectorType *>(&comp);
+}
+
+bool VectorType::operator==(const VectorType &comp) const { return lanes == comp.lanes && *element == *comp.element; }
+
+const Type::Ptr &VectorType::getElement() const { return element; }
+
+size_t VectorType::getLanes() const { return lanes; }
+
+std::string VectorType::str() const { return element->str() + "x" + std::to_string(lanes); }
+
 // FUNCTION TYPE
 
 FunctionType::FunctionType(Type::Ptr returnType, Type::Vec parameterTypes)
@@ -115,12 +249,32 @@ bool FunctionType::operator==(const Type &comp) const {
     if (comp.getKind() != FUNC)
         return false;
 
-    const auto &cast = dynamic_cast<const FunctionType *>(&comp);
-    return returnType == cast->returnType && parameterTypes == cast->parameterTypes;
+    return *this == *dynamic_cast<const FunctionType *>(&comp);
 }
 
 bool FunctionType::operator==(const FunctionType &comp) const {
-    return returnType == comp.returnType && parameterTypes == comp.parameterTypes;
+    if (*returnType != *comp.returnType || parameterTypes.size() != comp.parameterTypes.size())
+        return false;
+
+    for (size_t i = 0; i < parameterTypes.size(); ++i)
+        if (*parameterTypes[i] != *comp.parameterTypes[i])
+            return false;
+
+    return true;
+}
+
+const wyvern::Arg::Vec &FunctionType::generateArgs(const wyvern::Wrapper::Ptr &context, const std::vector<std::string> &names) {
+    if (!argsFor.owner_before(context) && !context.owner_before(argsFor) && argNames == names)
+        return args;
+
+    args.clear();
+    args.reserve(names.size());
+    for (size_t i = 0; i < names.size(); ++i)
+        args.push_back(wyvern::Arg::create(parameterTypes[i]->generate(context), names[i]));
+
+    argNames = names;
+    argsFor = context;
+    return args;
 }
 
 std::string FunctionType::str() const {
@@ -134,4 +288,95 @@ std::string FunctionType::str() const {
     ss << ") -> " << returnType->str();
 
     return ss.str();
-}
\ No newline at end of file
+}
+
+// STRUCT TYPE
+
+StructType::StructType(std::string name) : Type(STRUCT), name(std::move(name)), layout(), defined(false) {}
+
+void StructType::define(std::vector<Field> fields, Layout layout) {
+    this->fields = std::move(fields);
+    this->layout = layout;
+    defined = true;
+}
+
+bool StructType::operator==(const Type &comp) const {
+    if (comp.getKind() != STRUCT)
+        return false;
+
+    return name == static_cast<const StructType &>(comp).name;
+}
+
+void StructType::analyze(const Analyzer::Ptr &analyzer) {
+    if (!defined)
+        throw std::invalid_argument("Unknown type " + name);
+}
+
+wyvern::Ty::Ptr StructType::lower(const wyvern::Wrapper::Ptr &context) {
+    llvm::LLVMContext &ctx = *context->getContext();
+
+    if (llvm::StructType *existing = llvm::StructType::getTypeByName(ctx, "struct." + name))
+        return wyvern::Ty::create(context, existing);
+
+    // named before the body is generated, fields may point back to the struct
+    llvm::StructType *type = llvm::StructType::create(ctx, "struct." + name);
+    std::vector<llvm::Type *> elements = {};
+
+    // a zero-sized vector of the requested size has that alignment by default, it raises the struct's
+    // alignment and rounds its size up to a multiple of it without taking up space itself
+    if (layout.align)
+        elements.push_back(llvm::ArrayType::get(llvm::FixedVectorType::get(llvm::Type::getInt8Ty(ctx), layout.align), 0));
+
+    for (const Field &field : fields)
+        elements.push_back(field.type->generate(context)->getTy());
+
+    type->setBody(elements, layout.packed);
+    return wyvern::Ty::create(context, type);
+}
+
+std::optional<size_t> StructType::getFieldIndex(const std::string &field) const {
+    for (size_t i = 0; i < fields.size(); ++i)
+        if (fields[i].name == field)
+            return i;
+
+    return std::nullopt;
+}
+
+// visited structs were searched already, cycles not involving the target end there
+static bool containsInline(const Type::Ptr &type, const StructType &target, std::set<const StructType *> &visited) {
+    Type::Ptr stored = type;
+    while (stored->isArray())
+        stored = std::static_pointer_cast<ArrayType>(stored)->getElement();
+
+    if (!stored->isStruct())
+        return false;
+
+    const auto &record = static_cast<const StructType &>(*stored);
+    if (record == target)
+        return true;
+
+    if (!visited.insert(&record).second)
+        return false;
+
+    return std::ranges::any_of(record.getFields(), [&](const StructType::Field &field) { return containsInline(field.type, target, visited); });
+}
+
+bool StructType::contains(const StructType &other) const {
+    std::set<const StructType *> visited = {this};
+    return std::ranges::any_of(fields, [&](const Field &field) { return containsInline(field.type, other, visited); });
+}
+
+std::string StructType::str() const { return name; }
+
+// GENERIC TYPE
+
+GenericType::GenericType(std::string name) : Type(GENERIC), name(std::move(name)) {}
+
+bool GenericType::operator==(const Type &comp) const {
+    if (comp.getKind() != GENERIC)
+        return false;
+
+    return name == static_cast<const GenericType &>(comp).name;
+}
+
+std::string GenericType::str() const { return name; }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "token.h"
@@ -16,6 +17,7 @@ public:
 
     enum Kind {
         VOID,
+        BOOL,
         U8,
         I32,
         I64,
@@ -23,6 +25,11 @@ public:
         PTR,
         REF,
         FUNC,
+        ARRAY,
+        SLICE,
+        VECTOR,
+        STRUCT,
+        GENERIC,
         LITERAL,
         AUTO,
     };
@@ -38,7 +45,10 @@ public:
     virtual bool operator==(const Type &comp) const;
 
     virtual void analyze(const std::shared_ptr<Analyzer> &analyzer);
-    virtual wyvern::Ty::Ptr generate(const wyvern::Wrapper::Ptr &context);
+    // lowered once per context, later calls return the cached type
+    const wyvern::Ty::Ptr &generate(const wyvern::Wrapper::Ptr &context);
+    // pointer to this type, cached here since pointer types are created on the fly by getPointerTo()
+    const wyvern::Ty::Ptr &generatePointerTo(const wyvern::Wrapper::Ptr &context);
 
     Ptr getPointerTo(); // get PtrType to this type
 
@@ -48,13 +58,25 @@ public:
     [[nodiscard]] virtual constexpr bool isPointer() const { return false; }
     [[nodiscard]] virtual constexpr bool isReference() const { return false; }
     [[nodiscard]] virtual constexpr bool isFunction() const { return false; }
+    [[nodiscard]] virtual constexpr bool isArray() const { return false; }
+    [[nodiscard]] virtual constexpr bool isSlice() const { return false; }
+    [[nodiscard]] virtual constexpr bool isVector() const { return false; }
+    [[nodiscard]] virtual constexpr bool isStruct() const { return false; }
 
     [[nodiscard]] Kind getKind() const;
 
     [[nodiscard]] virtual std::string str() const;
 
 protected:
+    virtual wyvern::Ty::Ptr lower(const wyvern::Wrapper::Ptr &context);
+
     Kind kind;
+
+private:
+    // the weak owner keeps the context's control block alive, a new context can't be mistaken for the cached one
+    std::weak_ptr<wyvern::Wrapper> generatedFor;
+    wyvern::Ty::Ptr generated;
+    wyvern::Ty::Ptr generatedPointer; // for the same context, null until asked for
 };
 
 class PointerType : public Type {
@@ -94,6 +116,79 @@ private:
     Type::Ptr referee;
 };
 
+class ArrayType : public Type {
+public:
+    using Ptr = std::shared_ptr<ArrayType>;
+
+    // most elements of an array type, larger ones can't live on the stack anyway
+    static constexpr size_t MAX_SIZE = size_t(1) << 32;
+
+    ArrayType(Type::Ptr element, size_t size);
+
+    bool operator==(const Type &comp) const override;
+    bool operator==(const ArrayType &comp) const;
+
+    [[nodiscard]] const Type::Ptr &getElement() const;
+    [[nodiscard]] size_t getSize() const;
+
+    [[nodiscard]] constexpr bool isArray() const override { return true; }
+
+    [[nodiscard]] std::string str() const override;
+
+private:
+    Type::Ptr element;
+    size_t size;
+};
+
+// pointer to the first element plus length, lowered to { T*, i64 }
+class SliceType : public Type {
+public:
+    using Ptr = std::shared_ptr<SliceType>;
+
+    explicit SliceType(Type::Ptr element);
+
+    bool operator==(const Type &comp) const override;
+    bool operator==(const SliceType &comp) const;
+
+    [[nodiscard]] const Type::Ptr &getElement() const;
+
+    [[nodiscard]] constexpr bool isSlice() const override { return true; }
+
+    [[nodiscard]] std::string str() const override;
+
+private:
+    Type::Ptr element;
+};
+
+// SIMD vector written as <scalar>x<lanes>, e.g. f64x4, lowered to llvm::FixedVectorType
+class VectorType : public Type {
+public:
+    using Ptr = std::shared_ptr<VectorType>;
+
+    // widest vector the front end accepts, LLVM asserts on 0 lanes and scalarizes far narrower ones already
+    static constexpr size_t MAX_LANES = 256;
+
+    VectorType(Type::Ptr element, size_t lanes);
+
+    [[nodiscard]] static constexpr bool isValidLanes(size_t lanes) { return lanes > 0 && lanes <= MAX_LANES; }
+
+    bool operator==(const Type &comp) const override;
+    bool operator==(const VectorType &comp) const;
+
+    [[nodiscard]] const Type::Ptr &getElement() const;
+    [[nodiscard]] size_t getLanes() const;
+
+    [[nodiscard]] bool isFloat() const override { return element->isFloat(); }
+    [[nodiscard]] bool isSigned() const override { return element->isSigned(); }
+    [[nodiscard]] constexpr bool isVector() const override { return true; }
+
+    [[nodiscard]] std::string str() const override;
+
+private:
+    Type::Ptr element;
+    size_t lanes;
+};
+
 class FunctionType : public Type {
 public:
     using Ptr = std::shared_ptr<FunctionType>;
@@ -108,9 +203,86 @@ public:
 
     [[nodiscard]] constexpr bool isFunction() const override { return true; }
 
+    // parameters lowered with their names, built once per context for every declaration of the function
+    const wyvern::Arg::Vec &generateArgs(const wyvern::Wrapper::Ptr &context, const std::vector<std::string> &names);
+
     [[nodiscard]] std::string str() const override;
 
 private:
     Type::Ptr returnType;
     Type::Vec parameterTypes;
-};
\ No newline at end of file
+
+    std::weak_ptr<wyvern::Wrapper> argsFor;
+    std::vector<std::string> argNames;
+    wyvern::Arg::Vec args;
+};
+
+// record with named fields, lowered to a named llvm::StructType, types are compared by name,
+// uses can be created before the declaration and are completed by define()
+class StructType : public Type {
+public:
+    using Ptr = std::shared_ptr<StructType>;
+
+    struct Field {
+        std::string name;
+        Type::Ptr type;
+    };
+
+    struct Layout {
+        bool packed = false;    // @packed, no padding between fields
+        size_t align = 0;       // @align(N), minimum alignment in bytes, 0 for the natural one
+        bool soa = false;       // @soa, arrays of the struct are stored as one array per field
+    };
+
+    static constexpr size_t MAX_ALIGN = 4096;
+
+    explicit StructType(std::string name);
+
+    void define(std::vector<Field> fields, Layout layout);
+
+    bool operator==(const Type &comp) const override;
+
+    // throws if the struct was used but never declared
+    void analyze(const std::shared_ptr<Analyzer> &analyzer) override;
+
+    [[nodiscard]] const std::string &getName() const { return name; }
+    [[nodiscard]] const std::vector<Field> &getFields() const { return fields; }
+    [[nodiscard]] const Layout &getLayout() const { return layout; }
+    [[nodiscard]] bool isDefined() const { return defined; }
+
+    [[nodiscard]] std::optional<size_t> getFieldIndex(const std::string &field) const;
+    // other is stored inline in this struct, in a field, an array of them or a struct nested that way,
+    // pointers and slices don't count, a struct containing itself has no size
+    [[nodiscard]] bool contains(const StructType &other) const;
+    // index of a field in the generated llvm::StructType, @align adds a leading member
+    [[nodiscard]] unsigned getElementIndex(size_t field) const { return static_cast<unsigned>(field + (layout.align ? 1 : 0)); }
+
+    [[nodiscard]] constexpr bool isInteger() const override { return false; }
+    [[nodiscard]] constexpr bool isStruct() const override { return true; }
+
+    [[nodiscard]] std::string str() const override;
+
+protected:
+    wyvern::Ty::Ptr lower(const wyvern::Wrapper::Ptr &context) override;
+
+private:
+    std::string name;
+    std::vector<Field> fields;
+    Layout layout;
+    bool defined;
+};
+
+// type parameter of a generic function, only appears in the declared signature, instances use the type arguments
+class GenericType : public Type {
+public:
+    explicit GenericType(std::string name);
+
+    bool operator==(const Type &comp) const override;
+
+    [[nodiscard]] const std::string &getName() const { return name; }
+
+    [[nodiscard]] std::string str() const override;
+
+private:
+    std::string name;
+};
@@ -1,6 +1,7 @@
 #include "value.h"
 
 #include <utility>
+#include "literal.h"
 #include "../util/io.h"
 
 Value::Value(const int32_t &value) :    type(std::make_shared<Type>(Type::I32)), i32(value) {}
@@ -8,17 +9,59 @@ Value::Value(const int64_t &value) :    type(std::make_shared<Type>(Type::I64)),
 Value::Value(const double &value) :     type(std::make_shared<Type>(Type::F64)), f64(value) {}
 Value::Value(std::string value) :       type(std::make_shared<Type>(Type::LITERAL)), literal(std::move(value)) {}
 
+Value::Value(Type::Ptr type, const int64_t &value) : type(std::move(type)), i64(value) {
+    if (this->type->getKind() == Type::I32)
+        i32 = static_cast<int32_t>(value);
+}
+
+Value::Value(ArrayType::Ptr type, std::vector<Ptr> elements) : type(std::move(type)), i64(0), elements(std::move(elements)) {}
+
 Value::~Value() {}
 
 const Type::Ptr &Value::getType() const { return type; }
 
+std::optional<int64_t> Value::getInteger() const {
+    switch (type->getKind()) {
+        case Type::I32: return i32;
+        case Type::BOOL:
+        case Type::U8:
+        case Type::I64: return i64;
+        default:        return std::nullopt;
+    }
+}
+
+std::optional<double> Value::getFloat() const {
+    if (type->getKind() == Type::F64)
+        return f64;
+
+    return std::nullopt;
+}
+
+std::optional<std::string> Value::getLiteral() const {
+    if (type->getKind() == Type::LITERAL)
+        return literal;
+
+    return std::nullopt;
+}
+
 wyvern::Val::Ptr Value::generate(const wyvern::Wrapper::Ptr &context) const {
     switch (type->getKind()) {
         // TODO: need a proper function to get signed values
         case Type::I32:     return wyvern::Val::create(context, context->getSignedTy(32), context->getBuilder()->getInt32(i32));
         case Type::I64:     return wyvern::Val::create(context, context->getSignedTy(64), context->getBuilder()->getInt64(i64));
-        case Type::F64:     return context->getFloat(64);
-        case Type::LITERAL: return context->getLiteral(escapeSequences(literal));
+        case Type::BOOL:    return wyvern::Val::create(context, context->getUnsignedTy(1), context->getBuilder()->getInt1(i64));
+        case Type::U8:      return wyvern::Val::create(context, context->getUnsignedTy(8), context->getBuilder()->getInt8(i64));
+        case Type::F64:     return wyvern::Val::create(context, context->getFloatTy(64), llvm::ConstantFP::get(context->getFloatTy(64)->getTy(), f64));
+        case Type::LITERAL: return LiteralPool::get(context, literal); // escaped by the lexer
+        case Type::ARRAY: {
+            const wyvern::Ty::Ptr ty = type->generate(context);
+            std::vector<llvm::Constant *> constants = {};
+
+            for (const Ptr &element : elements)
+                constants.push_back(llvm::cast<llvm::Constant>(element->generate(context)->getValuePtr()));
+
+            return wyvern::Val::create(context, ty, llvm::ConstantArray::get(llvm::cast<llvm::ArrayType>(ty->getTy()), constants));
+        }
         default:            return context->getNull();
     }
 }
@@ -26,9 +69,17 @@ wyvern::Val::Ptr Value::generate(const wyvern::Wrapper::Ptr &context) const {
 std::string Value::str() const {
     switch (type->getKind()) {
         case Type::I32:     return std::to_string(i32);
+        case Type::BOOL:
+        case Type::U8:
         case Type::I64:     return std::to_string(i64);
         case Type::F64:     return std::to_string(f64);
-        case Type::LITERAL: return '"'+literal+'"';
+        case Type::ARRAY: {
+            std::string result = "[";
+            for (size_t i = 0; i < elements.size(); ++i)
+                result += (i ? ", " : "") + elements[i]->str();
+            return result + "]";
+        }
+        case Type::LITERAL: return '"'+unescapeSequences(literal)+'"';
         default:            return "INVALID_VALUE";
     }
 }
\ No newline at end of file
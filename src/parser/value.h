@@ -1,7 +1,9 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "type.h"
 #include "../wyvern/src/wyvern.hpp"
@@ -14,10 +16,19 @@ public:
     explicit Value(const int64_t &value);
     explicit Value(const double &value);
     explicit Value(std::string value);
+    // integer of the given type (bool, u8, i32 or i64)
+    Value(Type::Ptr type, const int64_t &value);
+    // constant array, the elements have the array's element type
+    Value(ArrayType::Ptr type, std::vector<Ptr> elements);
 
     ~Value();
 
     [[nodiscard]] const Type::Ptr &getType() const;
+    // the value as a 64-bit integer, nullopt if it isn't one
+    [[nodiscard]] std::optional<int64_t> getInteger() const;
+    [[nodiscard]] std::optional<double> getFloat() const;
+    [[nodiscard]] std::optional<std::string> getLiteral() const;
+    [[nodiscard]] const std::vector<Ptr> &getElements() const { return elements; }
     [[nodiscard]] wyvern::Val::Ptr generate(const wyvern::Wrapper::Ptr &context) const;
 
     [[nodiscard]] std::string str() const;
@@ -30,4 +41,5 @@ private:
         double f64;
         std::string literal;
     };
+    std::vector<Ptr> elements;
 };
@@ -0,0 +1,319 @@
+#include "lynxrt.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// plain C against libc only, programs are linked by the C compiler driver without the C++ runtime
+
+#define BUFFER_SIZE (64 * 1024)
+
+typedef struct {
+    char data[BUFFER_SIZE];
+    size_t size;
+    bool registered;
+} Buffer;
+
+static _Thread_local Buffer buffer;
+
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static pthread_key_t key;
+// a terminal gets every line right away, anything else only full buffers
+static bool interactive;
+
+static void writeAll(const char *data, size_t size) {
+    while (size > 0) {
+        const ssize_t written = write(STDOUT_FILENO, data, size);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return; // nowhere to report it, the output is lost like with a closed stdout
+        }
+
+        data += written;
+        size -= (size_t) written;
+    }
+}
+
+static void flushThread(void *unused) {
+    (void) unused;
+    lynx_flush();
+}
+
+static void flushMain(void) { lynx_flush(); }
+
+static void initialize(void) {
+    interactive = isatty(STDOUT_FILENO);
+    pthread_key_create(&key, flushThread);
+    atexit(flushMain);
+}
+
+// the key's destructor flushes threads other than main when they exit, it only runs for non-null values
+static Buffer *getBuffer(void) {
+    if (!buffer.registered) {
+        pthread_once(&once, initialize);
+        pthread_setspecific(key, &buffer);
+        buffer.registered = true;
+    }
+
+    return &buffer;
+}
+
+static void append(const char *data, size_t size) {
+    Buffer *out = getBuffer();
+
+    if (out->size + size > BUFFER_SIZE) {
+        lynx_flush();
+
+        // too large to be worth copying
+        if (size >= BUFFER_SIZE) {
+            writeAll(data, size);
+            return;
+        }
+    }
+
+    memcpy(out->data + out->size, data, size);
+    out->size += size;
+}
+
+static void endLine(void) {
+    append("\n", 1);
+
+    if (interactive)
+        lynx_flush();
+}
+
+// digits of value at the end of out, returns the first one
+static char *formatUnsigned(char *end, uint64_t value) {
+    do {
+        *--end = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    return end;
+}
+
+static size_t formatInt(char *out, int64_t value) {
+    char digits[20];
+    char *end = digits + sizeof(digits);
+    // negating INT64_MIN overflows, its magnitude still fits unsigned
+    const uint64_t magnitude = value < 0 ? 0 - (uint64_t) value : (uint64_t) value;
+    const char *first = formatUnsigned(end, magnitude);
+
+    size_t size = 0;
+    if (value < 0)
+        out[size++] = '-';
+
+    memcpy(out + size, first, (size_t) (end - first));
+    return size + (size_t) (end - first);
+}
+
+// like printf's %g: 6 significant digits, fixed notation for exponents from -4 to 5, no trailing zeros
+static size_t formatFloat(char *out, double value) {
+    size_t size = 0;
+
+    if (value != value) {
+        memcpy(out, "nan", 3);
+        return 3;
+    }
+
+    if (value < 0 || (value == 0 && 1 / value < 0)) {
+        out[size++] = '-';
+        value = -value;
+    }
+
+    if (value > 1.7976931348623157e308) {
+        memcpy(out + size, "inf", 3);
+        return size + 3;
+    }
+
+    if (value == 0) {
+        out[size++] = '0';
+        return size;
+    }
+
+    // mantissa in [1, 10)
+    int exponent = 0;
+    while (value >= 10) {
+        value /= 10;
+        ++exponent;
+    }
+    while (value < 1) {
+        value *= 10;
+        --exponent;
+    }
+
+    uint64_t mantissa = (uint64_t) (value * 100000 + 0.5);
+    if (mantissa >= 1000000) { // rounded up to the next power of ten
+        mantissa /= 10;
+        ++exponent;
+    }
+
+    char digits[6];
+    formatUnsigned(digits + sizeof(digits), mantissa);
+
+    size_t count = sizeof(digits);
+    while (count > 1 && digits[count - 1] == '0')
+        --count;
+
+    if (exponent < -4 || exponent >= 6) { // d.ddddde+XX
+        out[size++] = digits[0];
+        if (count > 1) {
+            out[size++] = '.';
+            memcpy(out + size, digits + 1, count - 1);
+            size += count - 1;
+        }
+
+        out[size++] = 'e';
+        out[size++] = exponent < 0 ? '-' : '+';
+
+        char exponentDigits[3];
+        char *end = exponentDigits + sizeof(exponentDigits);
+        const char *first = formatUnsigned(end, (uint64_t) (exponent < 0 ? -exponent : exponent));
+        if (end - first < 2)
+            out[size++] = '0';
+
+        memcpy(out + size, first, (size_t) (end - first));
+        return size + (size_t) (end - first);
+    }
+
+    if (exponent < 0) { // 0.000ddd
+        out[size++] = '0';
+        out[size++] = '.';
+        for (int i = -1; i > exponent; --i)
+            out[size++] = '0';
+
+        memcpy(out + size, digits, count);
+        return size + count;
+    }
+
+    // integer digits, padded with zeros if the significant ones run out
+    for (int i = 0; i <= exponent; ++i)
+        out[size++] = (size_t) i < count ? digits[i] : '0';
+
+    if ((size_t) exponent + 1 < count) {
+        out[size++] = '.';
+        memcpy(out + size, digits + exponent + 1, count - (size_t) exponent - 1);
+        size += count - (size_t) exponent - 1;
+    }
+
+    return size;
+}
+
+void lynx_print(const char *text) { append(text, strlen(text)); }
+
+void lynx_println(const char *text) {
+    append(text, strlen(text));
+    endLine();
+}
+
+void lynx_print_int(int64_t value) {
+    char out[32];
+    append(out, formatInt(out, value));
+}
+
+void lynx_print_float(double value) {
+    char out[32];
+    append(out, formatFloat(out, value));
+}
+
+void lynx_flush(void) {
+    writeAll(buffer.data, buffer.size);
+    buffer.size = 0;
+}
+
+// ARENA
+
+#define CHUNK_SIZE (64 * 1024)
+#define CACHED_CHUNKS 8
+
+typedef struct Chunk {
+    struct Chunk *next;
+    size_t size; // usable bytes after the header
+} Chunk;
+
+struct LynxArena {
+    Chunk *chunks; // current chunk first
+    char *position, *end;
+};
+
+// standard chunks of destroyed arenas, arenas created per request then don't go to malloc
+static _Thread_local Chunk *cache;
+static _Thread_local size_t cached;
+
+static void *allocateOrAbort(size_t size) {
+    void *memory = malloc(size);
+    if (!memory) {
+        static const char message[] = "lynx: out of memory\n";
+        lynx_flush();
+        writeAll(message, sizeof(message) - 1);
+        abort();
+    }
+
+    return memory;
+}
+
+static Chunk *takeChunk(size_t size) {
+    if (size <= CHUNK_SIZE && cache) {
+        Chunk *chunk = cache;
+        cache = chunk->next;
+        --cached;
+        return chunk;
+    }
+
+    // larger requests get a chunk of their own
+    const size_t usable = size > CHUNK_SIZE ? size : CHUNK_SIZE;
+    Chunk *chunk = allocateOrAbort(sizeof(Chunk) + usable);
+    chunk->size = usable;
+    return chunk;
+}
+
+static void releaseChunk(Chunk *chunk) {
+    if (chunk->size == CHUNK_SIZE && cached < CACHED_CHUNKS) {
+        chunk->next = cache;
+        cache = chunk;
+        ++cached;
+    } else
+        free(chunk);
+}
+
+LynxArena *lynx_arena_create(void) {
+    LynxArena *arena = allocateOrAbort(sizeof(LynxArena));
+    arena->chunks = NULL;
+    arena->position = arena->end = NULL;
+    return arena;
+}
+
+void *lynx_arena_alloc(LynxArena *arena, uint64_t size, uint64_t align) {
+    if (align == 0)
+        align = 1;
+
+    uintptr_t start = ((uintptr_t) arena->position + align - 1) & ~(uintptr_t) (align - 1);
+
+    if (!arena->position || start + size > (uintptr_t) arena->end) {
+        // the header keeps the chunk's data aligned to max_align_t, bigger alignments need padding
+        Chunk *chunk = takeChunk(size + align);
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->position = (char *) (chunk + 1);
+        arena->end = arena->position + chunk->size;
+        start = ((uintptr_t) arena->position + align - 1) & ~(uintptr_t) (align - 1);
+    }
+
+    arena->position = (char *) (start + size);
+    return memset((void *) start, 0, size);
+}
+
+void lynx_arena_destroy(LynxArena *arena) {
+    for (Chunk *chunk = arena->chunks; chunk;) {
+        Chunk *next = chunk->next;
+        releaseChunk(chunk);
+        chunk = next;
+    }
+
+    free(arena);
+}
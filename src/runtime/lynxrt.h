@@ -0,0 +1,32 @@
+#ifndef LYNXRT_H
+#define LYNXRT_H
+
+#include <stdint.h>
+
+// runtime library linked into every Lynx program, the core:: prelude calls these,
+// output is collected in a buffer per thread and written when it fills up, at thread exit and at exit
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void lynx_print(const char *text);
+void lynx_println(const char *text);
+void lynx_print_int(int64_t value);
+void lynx_print_float(double value);
+// write the calling thread's buffered output
+void lynx_flush(void);
+
+// region allocator behind @arena blocks and @new, everything allocated in an arena is released together
+typedef struct LynxArena LynxArena;
+
+LynxArena *lynx_arena_create(void);
+// zeroed memory, aborts if the system is out of memory
+void *lynx_arena_alloc(LynxArena *arena, uint64_t size, uint64_t align);
+void lynx_arena_destroy(LynxArena *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
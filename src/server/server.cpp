@@ -0,0 +1,469 @@
+#include "server.h"
+
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+
+#include "../ast/visitor.h"
+
+// JSON-RPC error codes
+constexpr int PARSE_ERROR = -32700;
+constexpr int METHOD_NOT_FOUND = -32601;
+constexpr int REQUEST_FAILED = -32803;
+
+// collect every resolved symbol use and declaration of a document
+class ReferenceCollector : public Visitor<ReferenceCollector> {
+public:
+    explicit ReferenceCollector(std::vector<Document::Reference> &references) : references(references) {}
+
+    void visitSymbol(SymbolExpr &node) { add(node.getLocation(), node.getSymbol()); }
+
+    void visitVariable(VariableStmt &node) {
+        add(node.getLocation(), node.getDeclaration());
+        visitChildren(node);
+    }
+
+    void visitFunctionPrototype(FunctionPrototype &node) { add(node.getLocation(), node.getDeclaration()); }
+
+    void visitFunction(Function &node) {
+        add(node.getLocation(), node.getDeclaration());
+        visitChildren(node);
+    }
+
+    void visitRangeFor(RangeForStmt &node) {
+        add(node.getLocation(), node.getCounter());
+        visitChildren(node);
+    }
+
+private:
+    void add(const Location &location, const Symbol::Ptr &symbol) {
+        if (symbol && location.line > 0)
+            references.push_back({location, symbol->getName().size(), symbol});
+    }
+
+    std::vector<Document::Reference> &references;
+};
+
+// LSP positions are 0-based
+static llvm::json::Value toRange(const Location &location, size_t length) {
+    const int64_t line = static_cast<int64_t>(location.line) - 1;
+    const int64_t column = static_cast<int64_t>(location.column) - 1;
+
+    return llvm::json::Object{
+        {"start", llvm::json::Object{{"line", line}, {"character", column}}},
+        {"end", llvm::json::Object{{"line", line}, {"character", column + static_cast<int64_t>(length)}}},
+    };
+}
+
+// character offsets are taken as bytes, which matches UTF-16 for ASCII sources
+static std::optional<Location> getPosition(const llvm::json::Object &params, llvm::StringRef key = "position") {
+    const llvm::json::Object *position = params.getObject(key);
+    if (!position)
+        return std::nullopt;
+
+    const auto line = position->getInteger("line");
+    const auto character = position->getInteger("character");
+    if (!line || !character)
+        return std::nullopt;
+
+    return Location{static_cast<size_t>(*line) + 1, static_cast<size_t>(*character) + 1};
+}
+
+static std::optional<std::string> getUri(const llvm::json::Object &params) {
+    if (const llvm::json::Object *document = params.getObject("textDocument"))
+        if (const auto uri = document->getString("uri"))
+            return uri->str();
+
+    return std::nullopt;
+}
+
+Server::Server() : documents(), out(llvm::outs()), shutdown(false), exited(false) {}
+
+Server::~Server() {
+    for (auto &[uri, document] : documents)
+        if (document.analyzer)
+            document.analyzer->clear();
+}
+
+int Server::run() {
+    // the compiler phases print progress, which would corrupt the protocol stream
+    std::streambuf *previous = std::cout.rdbuf(std::cerr.rdbuf());
+
+    while (!exited) {
+        const std::optional<std::string> body = readMessage();
+        if (!body)
+            break;
+
+        llvm::Expected<llvm::json::Value> message = llvm::json::parse(*body);
+        if (!message) {
+            replyError(nullptr, PARSE_ERROR, llvm::toString(message.takeError()));
+            continue;
+        }
+
+        if (const llvm::json::Object *object = message->getAsObject())
+            handle(*object);
+    }
+
+    std::cout.rdbuf(previous);
+    return shutdown ? 0 : 1;
+}
+
+std::optional<std::string> Server::readMessage() {
+    size_t length = 0;
+    bool valid = true;
+    std::string line;
+
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        if (line.empty()) { // end of the header
+            if (valid)
+                break;
+
+            // without its length the body can't be skipped, its lines are read as headers until the next message
+            replyError(nullptr, PARSE_ERROR, "Invalid Content-Length header");
+            length = 0;
+            valid = true;
+            continue;
+        }
+
+        if (line.starts_with("Content-Length:")) {
+            const size_t first = line.find_first_not_of(" \t", 15);
+            const char *begin = line.data() + std::min(first, line.size());
+            const char *end = line.data() + line.size();
+            const auto [parsed, error] = std::from_chars(begin, end, length);
+            valid = error == std::errc() && parsed == end;
+        }
+    }
+
+    if (!std::cin || length == 0)
+        return std::nullopt;
+
+    std::string body(length, '\0');
+    if (!std::cin.read(body.data(), static_cast<std::streamsize>(length)))
+        return std::nullopt;
+
+    return body;
+}
+
+void Server::send(const llvm::json::Value &message) {
+    std::string body;
+    llvm::raw_string_ostream os(body);
+    os << message;
+    os.flush();
+
+    out << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+    out.flush();
+}
+
+void Server::reply(const llvm::json::Value &id, llvm::json::Value result) {
+    send(llvm::json::Object{{"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}});
+}
+
+void Server::replyError(const llvm::json::Value &id, int code, const std::string &message) {
+    send(llvm::json::Object{
+        {"jsonrpc", "2.0"},
+        {"id", id},
+        {"error", llvm::json::Object{{"code", code}, {"message", message}}},
+    });
+}
+
+void Server::notify(const std::string &method, llvm::json::Value params) {
+    send(llvm::json::Object{{"jsonrpc", "2.0"}, {"method", method}, {"params", std::move(params)}});
+}
+
+void Server::handle(const llvm::json::Object &message) {
+    const auto method = message.getString("method");
+    const llvm::json::Value *id = message.get("id");
+    static const llvm::json::Object empty;
+    const llvm::json::Object *found = message.getObject("params");
+    const llvm::json::Object &params = found ? *found : empty;
+
+    if (!method) // a response, the server doesn't send requests
+        return;
+
+    if (*method == "initialize" && id) {
+        reply(*id, llvm::json::Object{
+            {"capabilities", llvm::json::Object{
+                {"textDocumentSync", 2}, // incremental, only the edited ranges are sent
+                {"hoverProvider", true},
+                {"definitionProvider", true},
+            }},
+            {"serverInfo", llvm::json::Object{{"name", "lynx"}}},
+        });
+        return;
+    }
+
+    if (*method == "shutdown" && id) {
+        shutdown = true;
+        reply(*id, nullptr);
+        return;
+    }
+
+    if (*method == "exit") {
+        exited = true;
+        return;
+    }
+
+    const std::optional<std::string> uri = getUri(params);
+
+    if (*method == "textDocument/didOpen") {
+        if (const llvm::json::Object *document = params.getObject("textDocument"))
+            if (const auto text = document->getString("text"); uri && text)
+                update(*uri, text->str(), document->getInteger("version").value_or(0));
+        return;
+    }
+
+    if (*method == "textDocument/didChange") {
+        const llvm::json::Array *changes = params.getArray("contentChanges");
+        const llvm::json::Object *document = params.getObject("textDocument");
+
+        const int64_t version = document ? document->getInteger("version").value_or(0) : 0;
+
+        if (!uri || !changes)
+            return;
+
+        std::vector<SourceFile::Edit> edits = {};
+        for (const llvm::json::Value &value : *changes) {
+            const llvm::json::Object *change = value.getAsObject();
+            if (!change || !change->getString("text"))
+                continue;
+
+            const std::string text = change->getString("text")->str();
+
+            const llvm::json::Object *range = change->getObject("range");
+            const std::optional<Location> start = range ? getPosition(*range, "start") : std::nullopt;
+            const std::optional<Location> end = range ? getPosition(*range, "end") : std::nullopt;
+
+            // a change without a range replaces the whole text
+            if (!start || !end) {
+                if (!edits.empty())
+                    edit(*uri, edits, version);
+
+                edits.clear();
+                update(*uri, text, version);
+                continue;
+            }
+
+            edits.push_back({*start, *end, text});
+        }
+
+        if (!edits.empty())
+            edit(*uri, edits, version);
+        return;
+    }
+
+    if (*method == "textDocument/didClose") {
+        if (uri && documents.contains(*uri)) {
+            if (documents[*uri].analyzer)
+                documents[*uri].analyzer->clear();
+            documents.erase(*uri);
+            notify("textDocument/publishDiagnostics", llvm::json::Object{{"uri", *uri}, {"diagnostics", llvm::json::Array()}});
+        }
+        return;
+    }
+
+    if (!id) // unknown notification
+        return;
+
+    const auto document = uri ? documents.find(*uri) : documents.end();
+    const std::optional<Location> position = getPosition(params);
+
+    if (*method == "textDocument/hover")
+        reply(*id, document != documents.end() && position ? hover(document->second, *position) : nullptr);
+    else if (*method == "textDocument/definition")
+        reply(*id, document != documents.end() && position ? definition(*uri, document->second, *position) : nullptr);
+    else if (*method == "lynx/emitIR") {
+        if (document == documents.end())
+            replyError(*id, REQUEST_FAILED, "document is not open");
+        else
+            try {
+                reply(*id, emitIR(document->second));
+            } catch (const std::invalid_argument &e) {
+                replyError(*id, REQUEST_FAILED, e.what());
+            }
+    } else
+        replyError(*id, METHOD_NOT_FOUND, "unknown method '" + method->str() + "'");
+}
+
+// the statements declare the same functions with the same types, so uses elsewhere stay valid
+static bool sameInterface(const Stmt::Vec &removed, const Stmt::Vec &inserted) {
+    if (removed.size() != inserted.size())
+        return false;
+
+    for (size_t i = 0; i < removed.size(); ++i) {
+        const AST kind = removed[i]->kind();
+        if ((kind != AST::Function && kind != AST::FunctionPrototype) || inserted[i]->kind() != kind)
+            return false;
+
+        const auto &before = static_cast<const FunctionPrototype &>(*removed[i]);
+        const auto &after = static_cast<const FunctionPrototype &>(*inserted[i]);
+        if (before.getSymbol() != after.getSymbol() || *before.getFunctionType() != *after.getFunctionType())
+            return false;
+    }
+
+    return true;
+}
+
+void Server::update(const std::string &uri, std::string text, int64_t version) {
+    Document &document = documents[uri];
+
+    document.source = std::make_unique<SourceFile>(std::move(text), uri);
+    document.version = version;
+    document.context = nullptr;
+
+    analyze(document);
+    collectReferences(document);
+    publishDiagnostics(uri, document);
+}
+
+void Server::edit(const std::string &uri, const std::vector<SourceFile::Edit> &edits, int64_t version) {
+    Document &document = documents[uri];
+    if (!document.source)
+        return;
+
+    bool full = false;
+    Stmt::Vec changed = {};
+    std::vector<std::pair<Stmt::Ptr, Stmt::Ptr>> replaced = {}; // removed and inserted declaration
+
+    for (const SourceFile::Edit &edit : edits) {
+        SourceFile::Change change = document.source->apply(edit);
+        full |= change.full || !sameInterface(change.removed, change.inserted);
+
+        if (!full)
+            for (size_t i = 0; i < change.removed.size(); ++i)
+                replaced.emplace_back(change.removed[i], change.inserted[i]);
+
+        // statements replaced by a later edit don't need analysis anymore
+        std::erase_if(changed, [&](const Stmt::Ptr &stmt) { return std::ranges::find(change.removed, stmt) != change.removed.end(); });
+        changed.insert(changed.end(), change.inserted.begin(), change.inserted.end());
+    }
+
+    document.version = version;
+    document.context = nullptr;
+
+    if (full)
+        analyze(document);
+    else
+        // the global symbols of everything else are still in the analyzer
+        try {
+            for (const Stmt::Ptr &stmt : changed)
+                stmt->analyze(document.analyzer);
+
+            // uses elsewhere are still bound to the old symbols, point them to the new declaration
+            for (const auto &[removed, inserted] : replaced) {
+                const auto &before = static_cast<const FunctionPrototype &>(*removed).getDeclaration();
+                const auto &after = static_cast<const FunctionPrototype &>(*inserted).getDeclaration();
+                if (before && after)
+                    before->setLocation(after->getLocation());
+            }
+        } catch (const std::invalid_argument &e) {
+            document.source->getDiagnostics()->error(1, 1, e.what());
+        }
+
+    collectReferences(document);
+    publishDiagnostics(uri, document);
+}
+
+void Server::analyze(Document &document) {
+    // symbols reference their analyzer, without this the old analysis is never freed
+    if (document.analyzer)
+        document.analyzer->clear();
+
+    document.analyzer = std::make_shared<Analyzer>(document.source->getRoot());
+
+    // analysis expects a well-formed tree
+    if (!document.source->getDiagnostics()->hasErrors())
+        try {
+            document.analyzer->analyze();
+        } catch (const std::invalid_argument &e) {
+            // the analyzer doesn't track positions yet, a later edit parses the file again to clear this
+            document.source->getDiagnostics()->error(1, 1, e.what());
+        }
+}
+
+void Server::collectReferences(Document &document) {
+    document.references.clear();
+    ReferenceCollector(document.references).visit(document.source->getRoot());
+
+    std::ranges::sort(document.references, [](const Document::Reference &a, const Document::Reference &b) {
+        return std::tie(a.location.line, a.location.column) < std::tie(b.location.line, b.location.column);
+    });
+}
+
+void Server::publishDiagnostics(const std::string &uri, const Document &document) {
+    llvm::json::Array diagnostics;
+
+    for (const Diagnostic &diagnostic : document.source->getDiagnostics()->get())
+        diagnostics.push_back(llvm::json::Object{
+            {"range", toRange({diagnostic.line, diagnostic.column}, 1)},
+            {"severity", static_cast<int>(diagnostic.severity) + 1},
+            {"source", "lynx"},
+            {"message", diagnostic.message},
+        });
+
+    notify("textDocument/publishDiagnostics", llvm::json::Object{
+        {"uri", uri},
+        {"version", document.version},
+        {"diagnostics", std::move(diagnostics)},
+    });
+}
+
+llvm::json::Value Server::hover(const Document &document, const Location &position) const {
+    const Document::Reference *reference = findReference(document, position);
+    if (!reference)
+        return nullptr;
+
+    return llvm::json::Object{
+        {"contents", llvm::json::Object{
+            {"kind", "markdown"},
+            {"value", "```lynx\n" + reference->symbol->str() + "\n```"},
+        }},
+        {"range", toRange(reference->location, reference->length)},
+    };
+}
+
+llvm::json::Value Server::definition(const std::string &uri, const Document &document, const Location &position) const {
+    const Document::Reference *reference = findReference(document, position);
+    if (!reference || reference->symbol->getLocation().line == 0)
+        return nullptr;
+
+    return llvm::json::Object{
+        {"uri", uri},
+        {"range", toRange(reference->symbol->getLocation(), reference->length)},
+    };
+}
+
+llvm::json::Value Server::emitIR(Document &document) const {
+    if (document.source->getDiagnostics()->hasErrors())
+        throw std::invalid_argument("document has errors");
+
+    if (!document.context) {
+        document.context = wyvern::Wrapper::create("lynx");
+        document.source->getRoot()->generate(document.context);
+    }
+
+    std::string ir;
+    llvm::raw_string_ostream os(ir);
+    document.context->getModule()->print(os, nullptr);
+    os.flush();
+
+    return llvm::json::Object{{"ir", ir}};
+}
+
+const Document::Reference *Server::findReference(const Document &document, const Location &position) {
+    // first reference starting after the position, the one before might cover it
+    const auto after = std::ranges::upper_bound(document.references, position, [](const Location &a, const Location &b) {
+        return std::tie(a.line, a.column) < std::tie(b.line, b.column);
+    }, &Document::Reference::location);
+
+    if (after == document.references.begin())
+        return nullptr;
+
+    const Document::Reference &reference = *std::prev(after);
+    if (reference.location.line != position.line || position.column >= reference.location.column + reference.length)
+        return nullptr;
+
+    return &reference;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "../ast/stmt.h"
+#include "../analyzer/analyzer.h"
+#include "../parser/source.h"
+#include "../util/diagnostics.h"
+
+// a source file open in the editor, kept parsed and analyzed between requests
+struct Document {
+    // a symbol or declaration in the source and what it resolved to
+    struct Reference {
+        Location location;
+        size_t length;
+        Symbol::Ptr symbol;
+    };
+
+    std::unique_ptr<SourceFile> source; // text, tokens, tree and syntax errors, updated in place on edits
+    int64_t version = 0;
+    Analyzer::Ptr analyzer;
+    std::vector<Reference> references;  // sorted by location
+    wyvern::Wrapper::Ptr context;       // generated IR, created on the first lynx/emitIR request
+};
+
+// language server speaking LSP over stdin and stdout, LLVM is initialized once
+// and every open document stays analyzed until it changes
+class Server {
+public:
+    Server();
+    ~Server();
+
+    // serve requests until the client exits, returns the exit code
+    int run();
+
+private:
+    // read one message with its Content-Length header, nullopt at the end of the input
+    std::optional<std::string> readMessage();
+    void send(const llvm::json::Value &message);
+    void reply(const llvm::json::Value &id, llvm::json::Value result);
+    void replyError(const llvm::json::Value &id, int code, const std::string &message);
+    void notify(const std::string &method, llvm::json::Value params);
+
+    void handle(const llvm::json::Object &message);
+
+    // parse and analyze a document after it was opened or replaced
+    void update(const std::string &uri, std::string text, int64_t version);
+    // apply the edits of a didChange, only statements touched by them are parsed and analyzed again
+    void edit(const std::string &uri, const std::vector<SourceFile::Edit> &edits, int64_t version);
+    // analyze the whole tree with a fresh analyzer
+    static void analyze(Document &document);
+    // index every resolved symbol for hover and definition
+    static void collectReferences(Document &document);
+    void publishDiagnostics(const std::string &uri, const Document &document);
+
+    [[nodiscard]] llvm::json::Value hover(const Document &document, const Location &position) const;
+    [[nodiscard]] llvm::json::Value definition(const std::string &uri, const Document &document, const Location &position) const;
+    [[nodiscard]] llvm::json::Value emitIR(Document &document) const;
+
+    // reference covering the position, if any
+    [[nodiscard]] static const Document::Reference *findReference(const Document &document, const Location &position);
+
+    std::map<std::string, Document> documents;
+    llvm::raw_ostream &out;
+    bool shutdown;
+    bool exited;
+};
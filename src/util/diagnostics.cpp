@@ -0,0 +1,48 @@
+#include "diagnostics.h"
+
+#include <utility>
+
+static const char *severityNames[] = {
+    "error",
+    "warning",
+    "note",
+};
+
+std::string Diagnostic::str(const std::string &file) const {
+    return (file.empty() ? "" : file + ":") + std::to_string(line) + ":" + std::to_string(column) + ": "
+        + severityNames[static_cast<int>(severity)] + ": " + message;
+}
+
+Diagnostics::Diagnostics(std::string file, size_t maxErrors)
+: file(std::move(file)), maxErrors(maxErrors), errors(0), diagnostics({}) {}
+
+void Diagnostics::error(size_t line, size_t column, const std::string &message) {
+    if (limitReached())
+        return;
+
+    ++errors;
+    report(Severity::ERROR, line, column, message);
+
+    if (limitReached())
+        report(Severity::NOTE, line, column, "too many errors, stopping");
+}
+
+void Diagnostics::warning(size_t line, size_t column, const std::string &message) {
+    report(Severity::WARNING, line, column, message);
+}
+
+void Diagnostics::note(size_t line, size_t column, const std::string &message) {
+    report(Severity::NOTE, line, column, message);
+}
+
+void Diagnostics::print(std::ostream &os) const {
+    for (const Diagnostic &diagnostic : diagnostics)
+        os << diagnostic.str(file) << '\n';
+
+    if (errors > 0)
+        os << errors << (errors == 1 ? " error" : " errors") << " generated.\n";
+}
+
+void Diagnostics::report(Severity severity, size_t line, size_t column, const std::string &message) {
+    diagnostics.push_back({severity, message, line, column});
+}
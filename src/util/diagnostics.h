@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class Severity {
+    ERROR,
+    WARNING,
+    NOTE,
+};
+
+struct Diagnostic {
+    Severity severity;
+    std::string message;
+    size_t line, column;
+
+    [[nodiscard]] std::string str(const std::string &file = "") const;
+};
+
+// collects the errors of one compilation, so all of them can be reported at once
+class Diagnostics {
+public:
+    using Ptr = std::shared_ptr<Diagnostics>;
+
+    explicit Diagnostics(std::string file = "", size_t maxErrors = 20);
+
+    void error(size_t line, size_t column, const std::string &message);
+    void warning(size_t line, size_t column, const std::string &message);
+    void note(size_t line, size_t column, const std::string &message);
+
+    [[nodiscard]] bool hasErrors() const { return errors > 0; }
+    [[nodiscard]] size_t getErrorCount() const { return errors; }
+    // too many errors, further ones are most likely cascading from the first
+    [[nodiscard]] bool limitReached() const { return errors >= maxErrors; }
+
+    [[nodiscard]] const std::vector<Diagnostic> &get() const { return diagnostics; }
+    [[nodiscard]] const std::string &getFile() const { return file; }
+
+    void print(std::ostream &os) const;
+
+private:
+    void report(Severity severity, size_t line, size_t column, const std::string &message);
+
+    std::string file;
+    size_t maxErrors;
+    size_t errors;
+    std::vector<Diagnostic> diagnostics;
+};
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <sstream>
 #include "io.h"
+#include "scan.h"
 
 std::string readFile(const std::string &filePath) {
     std::ifstream file(filePath);
@@ -16,36 +17,53 @@ std::string readFile(const std::string &filePath) {
     return buffer.str();
 }
 
-std::string escapeSequences(std::string value) {
+std::string escapeSequences(const std::string &value) {
     std::string buffer;
+    buffer.reserve(value.size());
 
-    for (size_t i = 0; i < value.size(); i++)
-        if (value.at(i) == '\\')
-            switch (value.at(++i)) {
-                case 'a':   buffer += '\a'; break;  // alert
-                case 'b':   buffer += '\b'; break;  // backspace
-                case 'f':   buffer += '\f'; break;  // form feed
-                case 'n':   buffer += '\n'; break;  // new line
-                case 'r':   buffer += '\r'; break;  // carriage return
-                case 't':   buffer += '\t'; break;  // horizontal tab
-                case 'v':   buffer += '\v'; break;  // vertical tab
-                case '\'':  buffer += '\''; break;  // single quote
-                case '\"':  buffer += '\"'; break;  // double quote
-                case '\?':  buffer += '\?'; break;  // question mark
-                case '\\':  buffer += '\\'; break;  // backslash
-                default:    break;                  // remove invalid escape sequences
-            }
-        else
-            buffer += value.at(i);
+    // copy everything up to the next backslash at once
+    for (size_t i = 0; i < value.size();) {
+        const size_t backslash = scan::findBackslash(value, i);
+        buffer.append(value, i, backslash - i);
+
+        if (backslash + 1 >= value.size()) { // no sequence or a trailing backslash
+            buffer.append(value, backslash, std::string::npos);
+            break;
+        }
+
+        switch (value[backslash + 1]) {
+            case 'a':   buffer += '\a'; break;  // alert
+            case 'b':   buffer += '\b'; break;  // backspace
+            case 'f':   buffer += '\f'; break;  // form feed
+            case 'n':   buffer += '\n'; break;  // new line
+            case 'r':   buffer += '\r'; break;  // carriage return
+            case 't':   buffer += '\t'; break;  // horizontal tab
+            case 'v':   buffer += '\v'; break;  // vertical tab
+            case '\'':  buffer += '\''; break;  // single quote
+            case '\"':  buffer += '\"'; break;  // double quote
+            case '\?':  buffer += '\?'; break;  // question mark
+            case '\\':  buffer += '\\'; break;  // backslash
+            default:    break;                  // remove invalid escape sequences
+        }
+
+        i = backslash + 2;
+    }
 
     return buffer;
 }
 
 std::string unescapeSequences(const std::string &value) {
     std::string buffer;
+    buffer.reserve(value.size());
 
-    for (char i : value)
-        switch (i) {
+    for (size_t i = 0; i < value.size(); ++i) {
+        const size_t special = scan::findEscapable(value, i);
+        buffer.append(value, i, special - i);
+
+        if (special >= value.size())
+            break;
+
+        switch (value[special]) {
             case '\a':  buffer += "\\a"; break;
             case '\b':  buffer += "\\b"; break;
             case '\f':  buffer += "\\f"; break;
@@ -57,8 +75,11 @@ std::string unescapeSequences(const std::string &value) {
             case '\"':  buffer += "\\\""; break;
             case '\?':  buffer += "\\?"; break;
             case '\\':  buffer += "\\\\"; break;
-            default:    buffer += i; break;
+            default:    break;
         }
 
+        i = special;
+    }
+
     return buffer;
-}
\ No newline at end of file
+}
@@ -5,7 +5,7 @@
 std::string readFile(const std::string &path);
 
 // escape all escape sequences in string
-std::string escapeSequences(std::string value);
+std::string escapeSequences(const std::string &value);
 
 // unescape all escape sequences in string
 std::string unescapeSequences(const std::string &value);
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// byte scanners for the lexer and escape handling, they test 32 (AVX2) or 16 (SSE2) bytes
+// at once and fall back to a plain loop for the tail and on other targets,
+// all return the index of the first matching byte at or after from, or text.size() if there is none
+namespace scan {
+
+#if defined(__AVX2__)
+#define LYNX_SCAN_SIMD 1
+using Block = __m256i;
+constexpr size_t WIDTH = 32;
+constexpr uint32_t ALL = 0xffffffff;
+
+inline Block load(const char *data) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data)); }
+inline Block splat(char c) { return _mm256_set1_epi8(c); }
+inline Block either(Block a, Block b) { return _mm256_or_si256(a, b); }
+inline Block both(Block a, Block b) { return _mm256_and_si256(a, b); }
+inline Block equal(Block a, char c) { return _mm256_cmpeq_epi8(a, splat(c)); }
+// signed, bytes >= 0x80 are never in an ASCII range
+inline Block between(Block a, char min, char max) {
+    return both(_mm256_cmpgt_epi8(a, splat(static_cast<char>(min - 1))), _mm256_cmpgt_epi8(splat(static_cast<char>(max + 1)), a));
+}
+inline uint32_t bits(Block a) { return static_cast<uint32_t>(_mm256_movemask_epi8(a)); }
+#elif defined(__SSE2__)
+#define LYNX_SCAN_SIMD 1
+using Block = __m128i;
+constexpr size_t WIDTH = 16;
+constexpr uint32_t ALL = 0xffff;
+
+inline Block load(const char *data) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data)); }
+inline Block splat(char c) { return _mm_set1_epi8(c); }
+inline Block either(Block a, Block b) { return _mm_or_si128(a, b); }
+inline Block both(Block a, Block b) { return _mm_and_si128(a, b); }
+inline Block equal(Block a, char c) { return _mm_cmpeq_epi8(a, splat(c)); }
+inline Block between(Block a, char min, char max) {
+    return both(_mm_cmpgt_epi8(a, splat(static_cast<char>(min - 1))), _mm_cmpgt_epi8(splat(static_cast<char>(max + 1)), a));
+}
+inline uint32_t bits(Block a) { return static_cast<uint32_t>(_mm_movemask_epi8(a)); }
+#else
+constexpr uint32_t ALL = 0; // only named by the unused vector tests
+#endif
+
+// vector returns one bit per matching byte of a block, scalar tests a single byte
+template<typename Vector, typename Scalar>
+inline size_t find(std::string_view text, size_t from, Vector vector, Scalar scalar) {
+#ifdef LYNX_SCAN_SIMD
+    for (; from + WIDTH <= text.size(); from += WIDTH)
+        if (const uint32_t matches = vector(load(text.data() + from)))
+            return from + std::countr_zero(matches);
+#else
+    (void) vector;
+#endif
+
+    while (from < text.size() && !scalar(text[from]))
+        ++from;
+
+    return from;
+}
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool isWhitespace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+inline bool isIdentifier(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'; }
+// bytes unescapeSequences() writes as an escape sequence
+inline bool isEscapable(char c) { return (c >= '\a' && c <= '\r') || c == '\'' || c == '"' || c == '?' || c == '\\'; }
+
+inline size_t findBackslash(std::string_view text, size_t from) {
+    return find(text, from, [](auto block) { return bits(equal(block, '\\')); }, [](char c) { return c == '\\'; });
+}
+
+inline size_t findQuoteOrBackslash(std::string_view text, size_t from) {
+    return find(text, from, [](auto block) { return bits(either(equal(block, '"'), equal(block, '\\'))); },
+        [](char c) { return c == '"' || c == '\\'; });
+}
+
+inline size_t findEscapable(std::string_view text, size_t from) {
+    return find(text, from, [](auto block) {
+        return bits(either(either(between(block, '\a', '\r'), equal(block, '\'')),
+            either(either(equal(block, '"'), equal(block, '?')), equal(block, '\\'))));
+    }, isEscapable);
+}
+
+// first byte that isn't whitespace
+inline size_t skipWhitespace(std::string_view text, size_t from) {
+    return find(text, from, [](auto block) { return ~bits(either(equal(block, ' '), between(block, '\t', '\r'))) & ALL; },
+        [](char c) { return !isWhitespace(c); });
+}
+
+// first byte that isn't a decimal digit
+inline size_t skipDigits(std::string_view text, size_t from) {
+    return find(text, from, [](auto block) { return ~bits(between(block, '0', '9')) & ALL; }, [](char c) { return !isDigit(c); });
+}
+
+// first byte that can't be part of an identifier
+inline size_t skipIdentifier(std::string_view text, size_t from) {
+    return find(text, from, [](auto block) {
+        return ~bits(either(either(between(block, 'a', 'z'), between(block, 'A', 'Z')),
+            either(between(block, '0', '9'), equal(block, '_')))) & ALL;
+    }, [](char c) { return !isIdentifier(c); });
+}
+
+}
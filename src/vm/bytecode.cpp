@@ -0,0 +1,26 @@
+#include "bytecode.h"
+
+#include <iomanip>
+#include <sstream>
+
+static const char *OpcodeName[] = {
+#define LYNX_OPCODE_NAME(name) #name,
+    LYNX_OPCODES(LYNX_OPCODE_NAME)
+#undef LYNX_OPCODE_NAME
+};
+
+const char *getOpcodeName(Opcode op) { return OpcodeName[static_cast<uint8_t>(op)]; }
+
+std::string disassemble(const BytecodeFunction &function) {
+    std::stringstream ss;
+    ss << function.name << ": " << function.registers << " registers, " << function.memory << " bytes"
+       << (function.jittable ? ", jittable" : "") << '\n';
+
+    for (size_t i = 0; i < function.code.size(); ++i) {
+        const Instruction &in = function.code[i];
+        ss << std::setw(6) << i << "  " << std::left << std::setw(12) << getOpcodeName(in.op) << std::right
+           << in.a << ", " << in.b << ", " << in.c << '\n';
+    }
+
+    return ss.str();
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+class Function;
+
+// register machine instructions, a is the destination unless noted otherwise,
+// integers of every width are kept sign- (i32) or zero-extended (bool, u8) to 64 bits
+#define LYNX_OPCODES(X) \
+    X(MOVE)         /* a = b */ \
+    X(CONST)        /* a = constant wide */ \
+    X(ADD_I)        /* a = b + c */ \
+    X(SUB_I) \
+    X(MUL_I) \
+    X(DIV_I)        /* traps on division by zero and overflow */ \
+    X(ADD_F) \
+    X(SUB_F) \
+    X(MUL_F) \
+    X(DIV_F) \
+    X(POW_F) \
+    X(LT_I)         /* a = b < c, > and >= swap the operands */ \
+    X(LTE_I) \
+    X(EQ_I) \
+    X(NEQ_I) \
+    X(LT_F) \
+    X(LTE_F) \
+    X(EQ_F) \
+    X(NEQ_F) \
+    X(TO_BOOL)      /* a = b != 0 */ \
+    X(TO_U8)        /* a = b truncated to 8 bits */ \
+    X(TO_I32)       /* a = b truncated to 32 bits */ \
+    X(I2F) \
+    X(F2I) \
+    X(JUMP)         /* continue at instruction wide */ \
+    X(JUMP_IF_NOT)  /* continue at instruction wide if a is 0 */ \
+    X(ADDR_LOCAL)   /* a = address of the frame's memory at offset wide */ \
+    X(ADDR_GLOBAL)  /* a = address of the globals at offset wide */ \
+    X(LOAD8)        /* a = *b */ \
+    X(LOAD32) \
+    X(LOAD64) \
+    X(STORE8)       /* *a = b */ \
+    X(STORE32) \
+    X(STORE64) \
+    X(COPY)         /* copy constant c bytes from address b to address a */ \
+    X(OFFSET)       /* a += wide */ \
+    X(INDEX)        /* a += b * constant c */ \
+    X(CHECK)        /* trap unless 0 <= a < wide */ \
+    X(CALL)         /* call function wide with the arguments from a on, the result replaces a */ \
+    X(NATIVE)       /* call runtime function wide the same way */ \
+    X(RET)          /* return a */ \
+    X(RET_VOID)
+
+enum class Opcode : uint8_t {
+#define LYNX_OPCODE_ENUM(name) name,
+    LYNX_OPCODES(LYNX_OPCODE_ENUM)
+#undef LYNX_OPCODE_ENUM
+};
+
+struct Instruction {
+    Opcode op;
+    uint16_t a, b, c;
+
+    // b and c as one operand, jump targets, constants, offsets and function indices
+    [[nodiscard]] constexpr uint32_t wide() const { return b | static_cast<uint32_t>(c) << 16; }
+};
+
+// a register, a constant or an argument, what it holds is known from the instructions using it
+union Slot {
+    int64_t i;
+    double f;
+    void *p;
+};
+
+// takes the arguments from and writes the result to the registers of the call
+using NativeEntry = void (*)(Slot *args);
+
+struct BytecodeFunction {
+    std::string name;
+    const Function *source = nullptr; // null for the initializer of the globals
+    std::vector<Instruction> code;
+    std::vector<Slot> constants;
+    uint32_t registers = 1; // frame size, the parameters are the first registers
+    uint64_t memory = 0;    // bytes of the locals that live in memory, arrays, structs and those whose address is taken
+
+    // only scalar arguments and results, no globals and only calls to functions that are jittable themselves
+    bool jittable = false;
+    std::vector<uint32_t> callees;
+    uint64_t calls = 0;
+    NativeEntry native = nullptr; // set once the function is compiled by the JIT
+};
+
+struct Program {
+    using Ptr = std::shared_ptr<Program>;
+
+    std::vector<BytecodeFunction> functions;
+    std::optional<uint32_t> initializer;    // top-level variables, runs before main
+    std::optional<uint32_t> main;
+    bool exitCode = false;                  // main returns an integer, the exit status of the program
+    std::vector<uint8_t> globals;           // initial contents of the global variables and constant arrays
+    std::deque<std::string> literals;       // string literals, their addresses stay valid as more are added
+};
+
+[[nodiscard]] const char *getOpcodeName(Opcode op);
+// one instruction per line, printed with -v
+[[nodiscard]] std::string disassemble(const BytecodeFunction &function);
@@ -0,0 +1,1088 @@
+#include "compiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <map>
+#include <set>
+
+#include "vm.h"
+#include "../ast/visitor.h"
+
+namespace {
+
+using Reg = uint16_t;
+
+[[noreturn]] void unsupported(const std::string &what) {
+    throw std::invalid_argument("The interpreter doesn't support " + what + ", compile the program instead");
+}
+
+Type::Ptr stripReference(const Type::Ptr &type) {
+    if (type && type->isReference())
+        return std::static_pointer_cast<ReferenceType>(type)->getReferee();
+
+    return type;
+}
+
+bool isInteger(const Type::Ptr &type) {
+    switch (type->getKind()) {
+        case Type::BOOL:
+        case Type::U8:
+        case Type::I32:
+        case Type::I64:     return true;
+        default:            return false;
+    }
+}
+
+bool isAggregate(const Type::Ptr &type) { return type->isArray() || type->isStruct(); }
+
+// values a jitted function can take and return in a register
+bool isPassedInRegister(const Type::Ptr &type) { return isInteger(type) || type->getKind() == Type::F64; }
+
+unsigned bits(Type::Kind kind) {
+    switch (kind) {
+        case Type::BOOL:    return 1;
+        case Type::U8:      return 8;
+        case Type::I32:     return 32;
+        default:            return 64;
+    }
+}
+
+// where a variable lives, index is a register or an offset into the frame's memory or the globals
+struct Storage {
+    enum Where {
+        REGISTER,
+        LOCAL,
+        GLOBAL,
+        REFERENCE, // the register holds the address of the referee
+    } where;
+    uint64_t index;
+};
+
+// the interpreter's own layout, natural alignment unless @packed, only scalars are shared with jitted code
+struct StructLayout {
+    std::vector<uint64_t> offsets;
+    uint64_t size, align;
+};
+
+class ProgramCompiler {
+public:
+    explicit ProgramCompiler(const Root &root);
+
+    Program::Ptr compile();
+
+    // index of the function, compiled after the one referencing it
+    uint32_t getFunction(const Function &function);
+
+    [[nodiscard]] const Storage *findGlobal(const Symbol *symbol) const;
+    // offset of a new global variable, zeroed
+    uint64_t declareGlobal(const Symbol *symbol, const Type::Ptr &type);
+    // offset of a constant array in the globals
+    uint64_t addConstant(const Value &value);
+    // address of a NUL-terminated copy of the literal, shared by all its uses
+    const char *addLiteral(const std::string &literal);
+
+    uint64_t sizeOf(const Type::Ptr &type);
+    uint64_t alignOf(const Type::Ptr &type);
+    const StructLayout &getLayout(const StructType &type);
+
+private:
+    uint64_t allocateGlobal(uint64_t size, uint64_t align);
+    void writeConstant(uint64_t offset, const Value &value);
+
+    const Root &root;
+    Program::Ptr program;
+    std::map<const Function *, uint32_t> indices;
+    std::vector<const Function *> pending;
+    std::map<const Symbol *, Storage> globals;
+    std::map<const StructType *, StructLayout> layouts;
+    std::map<std::string, const char *> literals;
+};
+
+// locals passed to reference parameters or whose address is taken live in memory, the others in registers
+class AddressCollector : public Visitor<AddressCollector> {
+public:
+    explicit AddressCollector(std::set<const Symbol *> &addressed) : addressed(addressed) {}
+
+    void visitUnary(UnaryExpr &node) {
+        if (node.getOp() == ADDR)
+            add(node.getExpr());
+        visitChildren(node);
+    }
+
+    void visitCall(CallExpr &node) {
+        const Expr::Ptr &callee = node.getCallee();
+        const Symbol::Ptr symbol = callee && callee->kind() == AST::Symbol ? std::static_pointer_cast<SymbolExpr>(callee)->getSymbol() : nullptr;
+
+        if (symbol && symbol->isFunction()) {
+            const Type::Vec &params = std::static_pointer_cast<FunctionSymbol>(symbol)->getParameterTypes();
+            for (size_t i = 0; i < params.size() && i < node.getArgs().size(); ++i)
+                if (params[i]->isReference())
+                    add(node.getArgs()[i]);
+        }
+
+        visitChildren(node);
+    }
+
+    void visitVariable(VariableStmt &node) {
+        if (node.getType(nullptr) && node.getType(nullptr)->isReference())
+            add(node.getValue());
+        visitChildren(node);
+    }
+
+private:
+    // read-only symbols are copied into a temporary instead
+    void add(const Expr::Ptr &expr) {
+        if (expr && expr->kind() == AST::Symbol && !std::static_pointer_cast<SymbolExpr>(expr)->getSymbol()->isReadOnly())
+            addressed.insert(std::static_pointer_cast<SymbolExpr>(expr)->getSymbol().get());
+    }
+
+    std::set<const Symbol *> &addressed;
+};
+
+// expressions yield the register holding their value, the address for arrays and structs,
+// temporaries are allocated above the locals and released after every statement
+class FunctionCompiler : public Visitor<FunctionCompiler, Reg> {
+    // an assignable location, the register holds its address if it's in memory
+    struct Place {
+        Reg reg;
+        bool memory;
+    };
+
+public:
+    explicit FunctionCompiler(ProgramCompiler &compiler) : compiler(compiler), top(0), usesGlobals(false) {}
+
+    BytecodeFunction compile(const Function &source) {
+        function.name = source.getSymbol();
+        function.source = &source;
+
+        const FunctionType::Ptr &type = source.getFunctionType();
+        const Type::Vec &types = type->getParameterTypes();
+        const auto &parameters = source.getParameterSymbols();
+        returnType = stripReference(type->getReturnType());
+
+        if (source.getBody())
+            AddressCollector(addressed).visit(source.getBody());
+
+        top = static_cast<uint32_t>(parameters.size());
+        function.registers = std::max<uint32_t>(top, 1);
+
+        // the arguments arrive in the first registers, values that live in memory are copied there
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            const Reg reg = static_cast<Reg>(i);
+            const Symbol *symbol = parameters[i].get();
+
+            if (types[i]->isReference())
+                locals[symbol] = {Storage::REFERENCE, reg};
+            else if (isAggregate(types[i]) || addressed.contains(symbol)) {
+                const uint64_t offset = reserve(types[i]);
+                const Reg address = allocate();
+                emitWide(Opcode::ADDR_LOCAL, address, offset);
+                store(address, reg, types[i]);
+                locals[symbol] = {Storage::LOCAL, offset};
+            } else
+                locals[symbol] = {Storage::REGISTER, reg};
+        }
+
+        top = static_cast<uint32_t>(parameters.size());
+        visit(source.getBody());
+        emit(Opcode::RET_VOID);
+
+        function.jittable = !usesGlobals && (returnType->getKind() == Type::VOID || isPassedInRegister(returnType))
+            && std::ranges::all_of(types, [](const Type::Ptr &type) { return isPassedInRegister(stripReference(type)); });
+
+        return std::move(function);
+    }
+
+    // top-level statements, variables among them are globals
+    BytecodeFunction compileInitializer(const Stmt::Vec &stmts) {
+        function.name = "<globals>";
+        returnType = std::make_shared<Type>(Type::VOID);
+
+        for (const Stmt::Ptr &stmt : stmts) {
+            if (stmt->kind() == AST::Variable)
+                global(static_cast<VariableStmt &>(*stmt));
+            else
+                visit(stmt);
+            top = 0;
+        }
+
+        emit(Opcode::RET_VOID);
+        return std::move(function);
+    }
+
+    // declarations don't generate code
+    Reg visitFunctionPrototype(FunctionPrototype &) { return 0; }
+    Reg visitFunction(Function &) { return 0; }
+    Reg visitGeneric(GenericFunction &) { return 0; }
+    Reg visitStruct(StructStmt &) { return 0; }
+    Reg visitImport(ImportStmt &) { return 0; }
+
+    Reg visitVariable(VariableStmt &node) {
+        const Type::Ptr type = declaredType(node);
+        const Symbol *symbol = node.getDeclaration().get();
+        const Expr::Ptr &value = node.getValue();
+
+        if (type->isReference()) {
+            const Reg reg = allocate();
+            const std::optional<Place> referee = value ? place(value) : std::nullopt;
+            if (!referee || !referee->memory)
+                unsupported("reference " + node.str());
+
+            emit(Opcode::MOVE, reg, referee->reg);
+            locals[symbol] = {Storage::REFERENCE, reg};
+            top = reg + 1;
+            return 0;
+        }
+
+        if (isAggregate(type) || addressed.contains(symbol)) {
+            const uint64_t offset = reserve(type);
+            if (value) {
+                const Reg result = convert(visit(value), value->getType(nullptr), type);
+                const Reg address = allocate();
+                emitWide(Opcode::ADDR_LOCAL, address, offset);
+                store(address, result, type);
+            }
+
+            locals[symbol] = {Storage::LOCAL, offset};
+            return 0;
+        }
+
+        const Reg reg = allocate();
+        if (value) {
+            const Reg result = convert(visit(value), value->getType(nullptr), type);
+            if (result != reg)
+                emit(Opcode::MOVE, reg, result);
+        } else
+            emitWide(Opcode::CONST, reg, constant(0));
+
+        locals[symbol] = {Storage::REGISTER, reg};
+        top = reg + 1;
+        return 0;
+    }
+
+    Reg visitReturn(ReturnStmt &node) {
+        if (!node.getValue()) {
+            emit(Opcode::RET_VOID);
+            return 0;
+        }
+
+        emit(Opcode::RET, convert(visit(node.getValue()), node.getValue()->getType(nullptr), returnType));
+        return 0;
+    }
+
+    Reg visitBlock(BlockExpr &node) {
+        if (node.isArena())
+            unsupported("@arena blocks");
+
+        const uint32_t mark = top;
+        for (const Stmt::Ptr &stmt : node.getStmts()) {
+            const uint32_t before = top;
+            visit(stmt);
+
+            // variables keep their registers until the block ends
+            if (stmt && stmt->kind() != AST::Variable)
+                top = before;
+        }
+
+        top = mark;
+        return 0;
+    }
+
+    Reg visitWhile(WhileStmt &node) {
+        const uint32_t mark = top;
+        const size_t start = function.code.size();
+
+        const size_t exit = jump(Opcode::JUMP_IF_NOT, condition(node.getCondition()));
+        top = mark;
+
+        visit(node.getBody());
+        top = mark;
+
+        emitWide(Opcode::JUMP, 0, start);
+        patch(exit);
+        return 0;
+    }
+
+    Reg visitFor(ForStmt &node) {
+        const uint32_t mark = top;
+        visit(node.getInit());
+
+        const uint32_t loop = top;
+        const size_t start = function.code.size();
+
+        std::optional<size_t> exit;
+        if (node.getCondition())
+            exit = jump(Opcode::JUMP_IF_NOT, condition(node.getCondition()));
+        top = loop;
+
+        visit(node.getBody());
+        top = loop;
+        visit(node.getStep());
+        top = loop;
+
+        emitWide(Opcode::JUMP, 0, start);
+        if (exit)
+            patch(*exit);
+
+        top = mark;
+        return 0;
+    }
+
+    Reg visitRangeFor(RangeForStmt &node) {
+        const uint32_t mark = top;
+        const auto i64 = std::make_shared<Type>(Type::I64);
+
+        // bounds are evaluated once, like in compiled code
+        const Reg counter = allocate();
+        const Reg end = allocate();
+        emit(Opcode::MOVE, counter, convert(visit(node.getStart()), node.getStart()->getType(nullptr), i64));
+        emit(Opcode::MOVE, end, convert(visit(node.getEnd()), node.getEnd()->getType(nullptr), i64));
+        const Reg one = integer(1);
+        locals[node.getCounter().get()] = {Storage::REGISTER, counter};
+
+        const uint32_t loop = top;
+        const size_t start = function.code.size();
+
+        const Reg inRange = allocate();
+        emit(Opcode::LT_I, inRange, counter, end);
+        const size_t exit = jump(Opcode::JUMP_IF_NOT, inRange);
+        top = loop;
+
+        visit(node.getBody());
+        top = loop;
+
+        emit(Opcode::ADD_I, counter, counter, one);
+        emitWide(Opcode::JUMP, 0, start);
+        patch(exit);
+
+        top = mark;
+        return 0;
+    }
+
+    Reg visitAssignment(AssignmentExpr &node) {
+        const Type::Ptr type = stripReference(node.getAssignee()->getType(nullptr));
+
+        const std::optional<Place> target = place(node.getAssignee());
+        if (!target)
+            unsupported("assignment to " + node.getAssignee()->str());
+
+        const Reg value = convert(visit(node.getValue()), node.getValue()->getType(nullptr), type);
+
+        if (target->memory)
+            store(target->reg, value, type);
+        else if (target->reg != value)
+            emit(Opcode::MOVE, target->reg, value);
+
+        return value;
+    }
+
+    Reg visitCall(CallExpr &node) {
+        if (node.getFolded())
+            return visit(node.getFolded());
+
+        const Expr::Ptr &callee = node.getCallee();
+        const Symbol::Ptr symbol = callee->kind() == AST::Symbol ? std::static_pointer_cast<SymbolExpr>(callee)->getSymbol() : nullptr;
+        if (!symbol || !symbol->isFunction())
+            unsupported("indirect call " + node.str());
+
+        const auto target = std::static_pointer_cast<FunctionSymbol>(symbol);
+        const auto type = std::static_pointer_cast<FunctionType>(target->getType());
+        const Type::Vec &params = type->getParameterTypes();
+        const Expr::Vec &args = node.getArgs();
+
+        // the callee's registers start at the first argument
+        const Reg base = allocate(std::max<uint32_t>(args.size(), 1));
+
+        for (size_t i = 0; i < args.size(); ++i) {
+            const Reg arg = static_cast<Reg>(base + i);
+
+            if (!params[i]->isReference()) {
+                emit(Opcode::MOVE, arg, convert(visit(args[i]), args[i]->getType(nullptr), params[i]));
+                continue;
+            }
+
+            const std::optional<Place> referee = place(args[i]);
+            if (referee && referee->memory) {
+                emit(Opcode::MOVE, arg, referee->reg);
+                continue;
+            }
+
+            // a temporary for values that aren't variables
+            const Type::Ptr &referenced = stripReference(params[i]);
+            const Reg value = convert(visit(args[i]), args[i]->getType(nullptr), referenced);
+            const uint64_t offset = reserve(referenced);
+            emitWide(Opcode::ADDR_LOCAL, arg, offset);
+            store(arg, value, referenced);
+        }
+
+        if (const Function *definition = target->getDefinition()) {
+            const uint32_t index = compiler.getFunction(*definition);
+            emitWide(Opcode::CALL, base, index);
+            function.callees.push_back(index);
+        } else if (const std::optional<uint32_t> native = VM::findNative(target->getLinkName()))
+            emitWide(Opcode::NATIVE, base, *native);
+        else
+            unsupported("calls to $" + target->getName() + ", which is defined in another module");
+
+        top = base + 1;
+
+        // the result points into the callee's memory, which the next call reuses
+        const Type::Ptr result = stripReference(type->getReturnType());
+        if (!isAggregate(result))
+            return base;
+
+        const uint64_t offset = reserve(result);
+        const Reg copy = allocate();
+        emitWide(Opcode::ADDR_LOCAL, copy, offset);
+        store(copy, base, result);
+        return copy;
+    }
+
+    Reg visitBinary(BinaryExpr &node) {
+        const Type::Ptr L = stripReference(node.getLHS()->getType(nullptr));
+        const Type::Ptr R = stripReference(node.getRHS()->getType(nullptr));
+
+        if (L->isVector() || R->isVector())
+            unsupported("vector operation " + node.str());
+        if (!isPassedInRegister(L) && !L->isPointer() && L->getKind() != Type::LITERAL)
+            unsupported("operator " + std::string(BinaryOpValue[node.getOp()]) + " on " + L->str());
+
+        // operands are compared as the type of the left one
+        if (isComparison(node.getOp())) {
+            const Reg a = convert(visit(node.getLHS()), L, L);
+            const Reg b = convert(visit(node.getRHS()), R, L);
+            const bool isFloat = L->getKind() == Type::F64;
+            const Reg result = allocate();
+
+            switch (node.getOp()) {
+                case LT:    emit(isFloat ? Opcode::LT_F : Opcode::LT_I, result, a, b); break;
+                case GT:    emit(isFloat ? Opcode::LT_F : Opcode::LT_I, result, b, a); break;
+                case LTE:   emit(isFloat ? Opcode::LTE_F : Opcode::LTE_I, result, a, b); break;
+                case GTE:   emit(isFloat ? Opcode::LTE_F : Opcode::LTE_I, result, b, a); break;
+                case EQ:    emit(isFloat ? Opcode::EQ_F : Opcode::EQ_I, result, a, b); break;
+                default:    emit(isFloat ? Opcode::NEQ_F : Opcode::NEQ_I, result, a, b); break;
+            }
+
+            return result;
+        }
+
+        const Type::Ptr type = stripReference(node.getType(nullptr));
+        if (!isPassedInRegister(type))
+            unsupported("arithmetic on " + type->str());
+
+        if (node.getOp() == POW) {
+            const auto f64 = std::make_shared<Type>(Type::F64);
+            const Reg a = convert(visit(node.getLHS()), L, f64);
+            const Reg b = convert(visit(node.getRHS()), R, f64);
+            const Reg result = allocate();
+            emit(Opcode::POW_F, result, a, b);
+            return convert(result, f64, type);
+        }
+
+        const Reg a = convert(visit(node.getLHS()), L, type);
+        const Reg b = convert(visit(node.getRHS()), R, type);
+        const bool isFloat = type->getKind() == Type::F64;
+        const Reg result = allocate();
+
+        switch (node.getOp()) {
+            case ADD:   emit(isFloat ? Opcode::ADD_F : Opcode::ADD_I, result, a, b); break;
+            case SUB:   emit(isFloat ? Opcode::SUB_F : Opcode::SUB_I, result, a, b); break;
+            case MUL:   emit(isFloat ? Opcode::MUL_F : Opcode::MUL_I, result, a, b); break;
+            default:    emit(isFloat ? Opcode::DIV_F : Opcode::DIV_I, result, a, b); break;
+        }
+
+        narrow(result, type);
+        return result;
+    }
+
+    Reg visitUnary(UnaryExpr &node) {
+        const Type::Ptr type = stripReference(node.getExpr()->getType(nullptr));
+
+        if (node.getOp() == ADDR) {
+            const std::optional<Place> target = place(node.getExpr());
+            if (!target || !target->memory)
+                unsupported("the address of " + node.getExpr()->str());
+            return target->reg;
+        }
+
+        if (node.getOp() == DEREF) {
+            if (!type->isPointer())
+                unsupported("dereferencing " + type->str());
+
+            const Type::Ptr pointee = std::static_pointer_cast<PointerType>(type)->getPointee();
+            const Reg pointer = visit(node.getExpr());
+            if (isAggregate(pointee))
+                return pointer;
+
+            const Reg result = allocate();
+            load(result, pointer, pointee);
+            return result;
+        }
+
+        if (!isPassedInRegister(type))
+            unsupported("incrementing " + type->str());
+
+        const std::optional<Place> target = place(node.getExpr());
+        if (!target)
+            unsupported("incrementing " + node.getExpr()->str());
+
+        Reg old = target->reg;
+        if (target->memory) {
+            old = allocate();
+            load(old, target->reg, type);
+        } else if (node.getOp() == POST_INC || node.getOp() == POST_DEC) {
+            // the variable's register is overwritten below
+            old = allocate();
+            emit(Opcode::MOVE, old, target->reg);
+        }
+
+        const bool isFloat = type->getKind() == Type::F64;
+        const bool increment = node.getOp() == PRE_INC || node.getOp() == POST_INC;
+        const Reg one = isFloat ? real(1.0) : integer(1);
+        const Reg next = allocate();
+        if (isFloat)
+            emit(increment ? Opcode::ADD_F : Opcode::SUB_F, next, old, one);
+        else
+            emit(increment ? Opcode::ADD_I : Opcode::SUB_I, next, old, one);
+        narrow(next, type);
+
+        if (target->memory)
+            store(target->reg, next, type);
+        else
+            emit(Opcode::MOVE, target->reg, next);
+
+        return node.getOp() == PRE_INC || node.getOp() == PRE_DEC ? next : old;
+    }
+
+    Reg visitIndex(IndexExpr &node) {
+        const Reg address = elementAddress(node);
+        const Type::Ptr element = node.getType(nullptr);
+        if (isAggregate(element))
+            return address;
+
+        load(address, address, element);
+        return address;
+    }
+
+    Reg visitMember(MemberExpr &node) {
+        const Reg address = fieldAddress(node);
+        const Type::Ptr field = node.getType(nullptr);
+        if (isAggregate(field))
+            return address;
+
+        load(address, address, field);
+        return address;
+    }
+
+    Reg visitSymbol(SymbolExpr &node) {
+        const Storage &storage = lookup(node);
+        const Type::Ptr type = stripReference(node.getSymbol()->getType());
+
+        if (storage.where == Storage::REGISTER)
+            return static_cast<Reg>(storage.index);
+
+        const Reg address = addressOf(storage);
+        if (isAggregate(type))
+            return address;
+
+        // the reference's register keeps pointing to the referee
+        const Reg result = storage.where == Storage::REFERENCE ? allocate() : address;
+        load(result, address, type);
+        return result;
+    }
+
+    Reg visitValue(ValueExpr &node) {
+        const Value &value = *node.getValue();
+        const Reg result = allocate();
+
+        switch (value.getType()->getKind()) {
+            case Type::BOOL:
+            case Type::U8:
+            case Type::I32:
+            case Type::I64:
+                emitWide(Opcode::CONST, result, constant(*value.getInteger()));
+                break;
+            case Type::F64: {
+                Slot slot{};
+                slot.f = *value.getFloat();
+                emitWide(Opcode::CONST, result, constant(slot));
+                break;
+            }
+            case Type::LITERAL: {
+                Slot slot{};
+                slot.p = const_cast<char *>(compiler.addLiteral(*value.getLiteral()));
+                emitWide(Opcode::CONST, result, constant(slot));
+                break;
+            }
+            case Type::ARRAY:
+                emitWide(Opcode::ADDR_GLOBAL, result, compiler.addConstant(value));
+                break;
+            default:
+                unsupported("constant " + value.str());
+        }
+
+        return result;
+    }
+
+    Reg visitSlice(SliceExpr &node) { unsupported("slices, " + node.getArray()->str() + " is passed as one"); }
+    Reg visitBuiltin(BuiltinExpr &node) { unsupported("builtin " + node.str()); }
+
+private:
+    void emit(Opcode op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0) {
+        function.code.push_back({op, static_cast<uint16_t>(a), static_cast<uint16_t>(b), static_cast<uint16_t>(c)});
+    }
+
+    void emitWide(Opcode op, uint32_t a, uint64_t wide) {
+        if (wide > UINT32_MAX)
+            unsupported("offsets and sizes beyond 4 GiB");
+
+        emit(op, a, wide & 0xffff, wide >> 16);
+    }
+
+    // forward jump, the target is patched in once it's known
+    size_t jump(Opcode op, Reg condition) {
+        emitWide(op, condition, 0);
+        return function.code.size() - 1;
+    }
+
+    void patch(size_t at) {
+        const size_t target = function.code.size();
+        function.code[at].b = target & 0xffff;
+        function.code[at].c = static_cast<uint16_t>(target >> 16);
+    }
+
+    Reg allocate(uint32_t count = 1) {
+        const uint32_t reg = top;
+        top += count;
+
+        if (top > UINT16_MAX)
+            unsupported("functions needing more than " + std::to_string(UINT16_MAX) + " registers");
+
+        function.registers = std::max(function.registers, top);
+        return static_cast<Reg>(reg);
+    }
+
+    uint32_t constant(Slot slot) {
+        const auto [found, added] = constants.try_emplace(std::bit_cast<uint64_t>(slot), function.constants.size());
+        if (added)
+            function.constants.push_back(slot);
+
+        return found->second;
+    }
+
+    uint32_t constant(int64_t value) {
+        Slot slot{};
+        slot.i = value;
+        return constant(slot);
+    }
+
+    Reg integer(int64_t value) {
+        const Reg reg = allocate();
+        emitWide(Opcode::CONST, reg, constant(value));
+        return reg;
+    }
+
+    Reg real(double value) {
+        Slot slot{};
+        slot.f = value;
+        const Reg reg = allocate();
+        emitWide(Opcode::CONST, reg, constant(slot));
+        return reg;
+    }
+
+    // offset of a local in the frame's memory
+    uint64_t reserve(const Type::Ptr &type) {
+        const uint64_t align = compiler.alignOf(type);
+        const uint64_t offset = (function.memory + align - 1) / align * align;
+        function.memory = offset + compiler.sizeOf(type);
+        return offset;
+    }
+
+    void load(Reg dst, Reg address, const Type::Ptr &type) {
+        switch (compiler.sizeOf(type)) {
+            case 1:     emit(Opcode::LOAD8, dst, address); break;
+            case 4:     emit(Opcode::LOAD32, dst, address); break;
+            default:    emit(Opcode::LOAD64, dst, address); break;
+        }
+    }
+
+    void store(Reg address, Reg value, const Type::Ptr &type) {
+        if (isAggregate(type)) {
+            emit(Opcode::COPY, address, value, constant(static_cast<int64_t>(compiler.sizeOf(type))));
+            return;
+        }
+
+        switch (compiler.sizeOf(type)) {
+            case 1:     emit(Opcode::STORE8, address, value); break;
+            case 4:     emit(Opcode::STORE32, address, value); break;
+            default:    emit(Opcode::STORE64, address, value); break;
+        }
+    }
+
+    // truncate an integer result to the width of its type
+    void narrow(Reg reg, const Type::Ptr &type) {
+        switch (type->getKind()) {
+            case Type::BOOL:    emit(Opcode::TO_BOOL, reg, reg); break;
+            case Type::U8:      emit(Opcode::TO_U8, reg, reg); break;
+            case Type::I32:     emit(Opcode::TO_I32, reg, reg); break;
+            default:            break;
+        }
+    }
+
+    Reg convert(Reg reg, const Type::Ptr &fromType, const Type::Ptr &toType) {
+        const Type::Ptr from = stripReference(fromType);
+        const Type::Ptr to = stripReference(toType);
+
+        if (!from || !to || from->getKind() == to->getKind())
+            return reg;
+
+        const bool fromFloat = from->getKind() == Type::F64;
+        if (to->getKind() == Type::F64 && isInteger(from)) {
+            const Reg result = allocate();
+            emit(Opcode::I2F, result, reg);
+            return result;
+        }
+
+        if (!isInteger(to) || (!fromFloat && !isInteger(from)))
+            return reg;
+
+        const Reg result = allocate();
+        if (fromFloat)
+            emit(Opcode::F2I, result, reg);
+        else if (bits(to->getKind()) < bits(from->getKind()))
+            emit(Opcode::MOVE, result, reg);
+        else
+            return reg;
+
+        narrow(result, to);
+        return result;
+    }
+
+    // loops test integers against 0, floats are compared first
+    Reg condition(const Expr::Ptr &expr) {
+        const Reg value = visit(expr);
+        if (stripReference(expr->getType(nullptr))->getKind() != Type::F64)
+            return value;
+
+        const Reg zero = real(0.0);
+        const Reg result = allocate();
+        emit(Opcode::NEQ_F, result, value, zero);
+        return result;
+    }
+
+    static Type::Ptr declaredType(const VariableStmt &node) {
+        const Type::Ptr type = node.getType(nullptr);
+        if (type && type->getKind() != Type::AUTO)
+            return type;
+
+        return node.getValue()->getType(nullptr);
+    }
+
+    void global(VariableStmt &node) {
+        const Type::Ptr type = declaredType(node);
+        if (type->isReference())
+            unsupported("global reference " + node.str());
+
+        const uint64_t offset = compiler.declareGlobal(node.getDeclaration().get(), type);
+        if (!node.getValue())
+            return;
+
+        const Reg value = convert(visit(node.getValue()), node.getValue()->getType(nullptr), type);
+        const Reg address = allocate();
+        emitWide(Opcode::ADDR_GLOBAL, address, offset);
+        store(address, value, type);
+    }
+
+    const Storage &lookup(const SymbolExpr &node) {
+        const Symbol *symbol = node.getSymbol().get();
+        if (symbol && symbol->isFunction())
+            unsupported("functions as values, $" + node.getName());
+
+        if (const auto found = locals.find(symbol); found != locals.end())
+            return found->second;
+
+        if (const Storage *global = compiler.findGlobal(symbol)) {
+            usesGlobals = true;
+            return *global;
+        }
+
+        unsupported("$" + node.getName() + ", it's declared in another module");
+    }
+
+    // register with the address of a variable in memory
+    Reg addressOf(const Storage &storage) {
+        if (storage.where == Storage::REFERENCE)
+            return static_cast<Reg>(storage.index);
+
+        const Reg address = allocate();
+        emitWide(storage.where == Storage::LOCAL ? Opcode::ADDR_LOCAL : Opcode::ADDR_GLOBAL, address, storage.index);
+        return address;
+    }
+
+    std::optional<Place> place(const Expr::Ptr &expr) {
+        switch (expr->kind()) {
+            case AST::Symbol: {
+                const Storage &storage = lookup(static_cast<SymbolExpr &>(*expr));
+                if (storage.where == Storage::REGISTER)
+                    return Place{static_cast<Reg>(storage.index), false};
+                return Place{addressOf(storage), true};
+            }
+            case AST::Index:
+                return Place{elementAddress(static_cast<IndexExpr &>(*expr)), true};
+            case AST::Member:
+                return Place{fieldAddress(static_cast<MemberExpr &>(*expr)), true};
+            case AST::Unary:
+                if (static_cast<UnaryExpr &>(*expr).getOp() == DEREF)
+                    return Place{visit(static_cast<UnaryExpr &>(*expr).getExpr()), true};
+                return std::nullopt;
+            default:
+                return std::nullopt;
+        }
+    }
+
+    // array or struct a reference or pointer leads to
+    static Type::Ptr unwrap(const Type::Ptr &type) {
+        const Type::Ptr value = stripReference(type);
+        return value->isPointer() ? std::static_pointer_cast<PointerType>(value)->getPointee() : value;
+    }
+
+    Reg elementAddress(IndexExpr &node) {
+        const Type::Ptr type = unwrap(node.getArray()->getType(nullptr));
+        if (!type->isArray())
+            unsupported("indexing into " + type->str());
+        if (node.isSoa())
+            unsupported("arrays of @soa structs");
+
+        const auto array = std::static_pointer_cast<ArrayType>(type);
+
+        // arrays yield their address, pointers to them the pointer
+        const Reg address = allocate();
+        emit(Opcode::MOVE, address, visit(node.getArray()));
+
+        const Reg index = convert(visit(node.getIndex()), node.getIndex()->getType(nullptr), std::make_shared<Type>(Type::I64));
+        emitWide(Opcode::CHECK, index, array->getSize());
+        emit(Opcode::INDEX, address, index, constant(static_cast<int64_t>(compiler.sizeOf(array->getElement()))));
+        return address;
+    }
+
+    Reg fieldAddress(MemberExpr &node) {
+        const Type::Ptr type = unwrap(node.getObject()->getType(nullptr));
+        if (!type->isStruct())
+            unsupported("field access on " + type->str());
+        if (node.getObject()->kind() == AST::Index && std::static_pointer_cast<IndexExpr>(node.getObject())->isSoa())
+            unsupported("arrays of @soa structs");
+
+        const auto &structType = static_cast<const StructType &>(*type);
+        const uint64_t offset = compiler.getLayout(structType).offsets[*structType.getFieldIndex(node.getField())];
+
+        const Reg address = allocate();
+        emit(Opcode::MOVE, address, visit(node.getObject()));
+        if (offset)
+            emitWide(Opcode::OFFSET, address, offset);
+        return address;
+    }
+
+    ProgramCompiler &compiler;
+    BytecodeFunction function;
+    Type::Ptr returnType;
+    std::map<const Symbol *, Storage> locals;
+    std::set<const Symbol *> addressed;
+    std::map<uint64_t, uint32_t> constants; // index by bits
+    uint32_t top;                           // first free register
+    bool usesGlobals;
+};
+
+// PROGRAM COMPILER
+
+ProgramCompiler::ProgramCompiler(const Root &root) : root(root), program(std::make_shared<Program>()) {}
+
+Program::Ptr ProgramCompiler::compile() {
+    Stmt::Vec initializers = {};
+    const Function *main = nullptr;
+
+    for (const Stmt::Ptr &stmt : root.getProgram()) {
+        if (!stmt)
+            continue;
+
+        switch (stmt->kind()) {
+            case AST::Function:
+                if (static_cast<const Function &>(*stmt).getSymbol() == "main")
+                    main = static_cast<const Function *>(stmt.get());
+                break;
+            case AST::FunctionPrototype:
+            case AST::Generic:
+            case AST::Import:
+            case AST::Struct:
+                break;
+            default:
+                initializers.push_back(stmt);
+        }
+    }
+
+    // first, the functions see the globals it declares
+    if (!initializers.empty()) {
+        program->initializer = static_cast<uint32_t>(program->functions.size());
+        program->functions.emplace_back();
+        program->functions[*program->initializer] = FunctionCompiler(*this).compileInitializer(initializers);
+    }
+
+    if (main) {
+        program->main = getFunction(*main);
+        program->exitCode = isInteger(main->getFunctionType()->getReturnType());
+    }
+
+    // compiling a function may add the ones it calls
+    while (!pending.empty()) {
+        const Function *function = pending.back();
+        pending.pop_back();
+        program->functions[indices.at(function)] = FunctionCompiler(*this).compile(*function);
+    }
+
+    // a function is only jitted if everything it calls can be too
+    for (bool changed = true; changed;) {
+        changed = false;
+
+        for (BytecodeFunction &function : program->functions)
+            if (function.jittable && std::ranges::any_of(function.callees, [&](uint32_t callee) { return !program->functions[callee].jittable; })) {
+                function.jittable = false;
+                changed = true;
+            }
+    }
+
+    return program;
+}
+
+uint32_t ProgramCompiler::getFunction(const Function &function) {
+    const auto [found, added] = indices.try_emplace(&function, program->functions.size());
+
+    if (added) {
+        program->functions.emplace_back();
+        pending.push_back(&function);
+    }
+
+    return found->second;
+}
+
+const Storage *ProgramCompiler::findGlobal(const Symbol *symbol) const {
+    const auto found = globals.find(symbol);
+    return found == globals.end() ? nullptr : &found->second;
+}
+
+uint64_t ProgramCompiler::declareGlobal(const Symbol *symbol, const Type::Ptr &type) {
+    const uint64_t offset = allocateGlobal(sizeOf(type), alignOf(type));
+    globals[symbol] = {Storage::GLOBAL, offset};
+    return offset;
+}
+
+uint64_t ProgramCompiler::addConstant(const Value &value) {
+    const uint64_t offset = allocateGlobal(sizeOf(value.getType()), alignOf(value.getType()));
+    writeConstant(offset, value);
+    return offset;
+}
+
+const char *ProgramCompiler::addLiteral(const std::string &literal) {
+    const char *&address = literals[literal];
+
+    if (!address)
+        address = program->literals.emplace_back(literal).c_str();
+
+    return address;
+}
+
+uint64_t ProgramCompiler::allocateGlobal(uint64_t size, uint64_t align) {
+    const uint64_t offset = (program->globals.size() + align - 1) / align * align;
+    program->globals.resize(offset + size);
+    return offset;
+}
+
+void ProgramCompiler::writeConstant(uint64_t offset, const Value &value) {
+    uint8_t *at = program->globals.data() + offset;
+
+    switch (value.getType()->getKind()) {
+        case Type::BOOL:
+        case Type::U8: {
+            const auto byte = static_cast<uint8_t>(*value.getInteger());
+            std::memcpy(at, &byte, sizeof(byte));
+            break;
+        }
+        case Type::I32: {
+            const auto word = static_cast<int32_t>(*value.getInteger());
+            std::memcpy(at, &word, sizeof(word));
+            break;
+        }
+        case Type::I64: {
+            const int64_t word = *value.getInteger();
+            std::memcpy(at, &word, sizeof(word));
+            break;
+        }
+        case Type::F64: {
+            const double word = *value.getFloat();
+            std::memcpy(at, &word, sizeof(word));
+            break;
+        }
+        case Type::LITERAL: {
+            const char *word = addLiteral(*value.getLiteral());
+            std::memcpy(at, &word, sizeof(word));
+            break;
+        }
+        case Type::ARRAY: {
+            const uint64_t element = sizeOf(std::static_pointer_cast<ArrayType>(value.getType())->getElement());
+            for (size_t i = 0; i < value.getElements().size(); ++i)
+                writeConstant(offset + i * element, *value.getElements()[i]);
+            break;
+        }
+        default:
+            unsupported("constant " + value.str());
+    }
+}
+
+uint64_t ProgramCompiler::sizeOf(const Type::Ptr &type) {
+    switch (type->getKind()) {
+        case Type::BOOL:
+        case Type::U8:      return 1;
+        case Type::I32:     return 4;
+        case Type::I64:
+        case Type::F64:
+        case Type::PTR:
+        case Type::REF:
+        case Type::LITERAL: return 8;
+        case Type::ARRAY: {
+            const auto array = std::static_pointer_cast<ArrayType>(type);
+            return sizeOf(array->getElement()) * array->getSize();
+        }
+        case Type::STRUCT:  return getLayout(static_cast<const StructType &>(*type)).size;
+        default:            unsupported("values of type " + type->str());
+    }
+}
+
+uint64_t ProgramCompiler::alignOf(const Type::Ptr &type) {
+    switch (type->getKind()) {
+        case Type::ARRAY:   return alignOf(std::static_pointer_cast<ArrayType>(type)->getElement());
+        case Type::STRUCT:  return getLayout(static_cast<const StructType &>(*type)).align;
+        default:            return sizeOf(type);
+    }
+}
+
+const StructLayout &ProgramCompiler::getLayout(const StructType &type) {
+    if (const auto found = layouts.find(&type); found != layouts.end())
+        return found->second;
+
+    const StructType::Layout &annotations = type.getLayout();
+    StructLayout layout = {{}, 0, std::max<uint64_t>(annotations.align, 1)};
+
+    for (const StructType::Field &field : type.getFields()) {
+        const uint64_t align = annotations.packed ? 1 : alignOf(field.type);
+        layout.size = (layout.size + align - 1) / align * align;
+        layout.offsets.push_back(layout.size);
+        layout.size += sizeOf(field.type);
+        layout.align = std::max(layout.align, align);
+    }
+
+    layout.size = (layout.size + layout.align - 1) / layout.align * layout.align;
+    return layouts[&type] = std::move(layout);
+}
+
+}
+
+Program::Ptr compileBytecode(const Root &root) { return ProgramCompiler(root).compile(); }
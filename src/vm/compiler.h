@@ -0,0 +1,8 @@
+#pragma once
+
+#include "bytecode.h"
+#include "../ast/stmt.h"
+
+// lower an analyzed tree to bytecode, starting from main and the top-level variables, only functions that
+// are called get compiled, throws std::invalid_argument for the constructs only compiled programs support
+Program::Ptr compileBytecode(const Root &root);
@@ -0,0 +1,123 @@
+#include "jit.h"
+
+#include <iostream>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/IR/IRBuilder.h>
+
+#include "../ast/function.h"
+#include "../driver/pipeline.h"
+
+static const std::string ENTRY_PREFIX = "lynx.entry.";
+
+JIT::JIT(Root::Ptr root, Program::Ptr program, std::string name, unsigned level)
+: root(std::move(root)), program(std::move(program)), name(std::move(name)), level(level ? level : 2), loaded(false), failed(false) {}
+
+JIT::~JIT() = default;
+
+NativeEntry JIT::compile(const BytecodeFunction &function) {
+    if (!function.source || (!loaded && !load()) || failed)
+        return nullptr;
+
+    llvm::Expected<llvm::orc::ExecutorAddr> address = jit->lookup(ENTRY_PREFIX + function.source->getSymbol());
+    if (!address) {
+        llvm::consumeError(address.takeError());
+        return nullptr;
+    }
+
+    return address->toPtr<NativeEntry>();
+}
+
+bool JIT::load() {
+    loaded = true;
+
+    const auto fail = [this](const std::string &error) {
+        std::cerr << "warning: hot functions stay interpreted, " << error << '\n';
+        failed = true;
+        return false;
+    };
+
+    // the bytecode compiler accepted the program, code generation may still reject it
+    wyvern::Wrapper::Ptr context = wyvern::Wrapper::create(name);
+    try {
+        root->generate(context);
+    } catch (const std::invalid_argument &e) {
+        return fail(e.what());
+    }
+
+    llvm::Module &generated = *context->getModule();
+    for (const BytecodeFunction &function : program->functions)
+        if (function.jittable && function.source)
+            addEntry(generated, function);
+
+    Pipeline(level).optimize(generated);
+
+    llvm::Expected<std::unique_ptr<llvm::orc::LLJIT>> created = llvm::orc::LLJITBuilder().create();
+    if (!created)
+        return fail(llvm::toString(created.takeError()));
+    jit = std::move(*created);
+
+    // the runtime library is linked into the compiler, jitted code calls the same functions the interpreter does
+    auto process = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(jit->getDataLayout().getGlobalPrefix());
+    if (!process)
+        return fail(llvm::toString(process.takeError()));
+    jit->getMainJITDylib().addGenerator(std::move(*process));
+
+    // the JIT owns its module and context, moved over as bitcode from the wrapper's
+    llvm::SmallVector<char, 0> bitcode;
+    llvm::raw_svector_ostream os(bitcode);
+    llvm::WriteBitcodeToFile(generated, os);
+
+    auto ctx = std::make_unique<llvm::LLVMContext>();
+    llvm::Expected<std::unique_ptr<llvm::Module>> module = llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode.size()), name), *ctx);
+    if (!module)
+        return fail(llvm::toString(module.takeError()));
+
+    (*module)->setDataLayout(jit->getDataLayout());
+    if (llvm::Error error = jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(*module), std::move(ctx))))
+        return fail(llvm::toString(std::move(error)));
+
+    return true;
+}
+
+void JIT::addEntry(llvm::Module &module, const BytecodeFunction &function) {
+    llvm::Function *target = module.getFunction(function.source->getSymbol());
+    if (!target)
+        return;
+
+    llvm::LLVMContext &ctx = module.getContext();
+    llvm::Type *slot = llvm::Type::getInt64Ty(ctx);
+    llvm::FunctionType *type = llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), {llvm::PointerType::get(ctx, 0)}, false);
+    llvm::Function *entry = llvm::Function::Create(type, llvm::GlobalValue::ExternalLinkage, ENTRY_PREFIX + function.source->getSymbol(), module);
+
+    llvm::IRBuilder<> builder(llvm::BasicBlock::Create(ctx, "entry", entry));
+    llvm::Value *registers = entry->getArg(0);
+
+    // integers are kept in 64 bits by the interpreter, references are addresses into its memory
+    std::vector<llvm::Value *> args = {};
+    for (unsigned i = 0; i < target->arg_size(); ++i) {
+        llvm::Type *arg = target->getFunctionType()->getParamType(i);
+        llvm::Value *address = builder.CreateConstInBoundsGEP1_64(slot, registers, i);
+
+        if (arg->isIntegerTy())
+            args.push_back(builder.CreateTrunc(builder.CreateLoad(slot, address), arg));
+        else
+            args.push_back(builder.CreateLoad(arg, address));
+    }
+
+    llvm::Value *result = builder.CreateCall(target, args);
+    llvm::Type *resultType = target->getReturnType();
+
+    // bool and u8 are zero-extended, i32 sign-extended, like the interpreter keeps them
+    if (resultType->isIntegerTy()) {
+        const Type::Kind kind = function.source->getFunctionType()->getReturnType()->getKind();
+        result = kind == Type::BOOL || kind == Type::U8 ? builder.CreateZExt(result, slot) : builder.CreateSExt(result, slot);
+    }
+
+    if (!resultType->isVoidTy())
+        builder.CreateStore(result, registers);
+
+    builder.CreateRetVoid();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <memory>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/Module.h>
+
+#include "bytecode.h"
+#include "../ast/stmt.h"
+
+// second tier of the interpreter: once the first function gets hot the whole program is generated and
+// optimized with LLVM, every jittable function gets an entry taking its arguments from the registers of a call
+class JIT {
+public:
+    // level is the optimization level of the generated code, -O2 if 0
+    JIT(Root::Ptr root, Program::Ptr program, std::string name, unsigned level);
+    ~JIT();
+
+    // native entry of the function, null if the program couldn't be compiled
+    NativeEntry compile(const BytecodeFunction &function);
+
+private:
+    // generate, optimize and hand the program to LLJIT, only tried once
+    bool load();
+    // void lynx.entry.<symbol>(ptr registers), converts the registers to the arguments and the result back
+    static void addEntry(llvm::Module &module, const BytecodeFunction &function);
+
+    Root::Ptr root;
+    Program::Ptr program;
+    std::string name;
+    unsigned level;
+    std::unique_ptr<llvm::orc::LLJIT> jit;
+    bool loaded, failed;
+};
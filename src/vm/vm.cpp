@@ -0,0 +1,253 @@
+#include "vm.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "../runtime/lynxrt.h"
+
+// computed gotos jump from each handler straight to the next one instead of back through a switch,
+// every handler gets its own indirect branch for the predictor
+#if defined(__GNUC__) || defined(__clang__)
+#define LYNX_THREADED_DISPATCH 1
+#endif
+
+struct Native {
+    const char *linkName;
+    NativeEntry entry;
+};
+
+// the runtime library the core:: prelude is implemented by, linked into the compiler as well
+static const Native NATIVES[] = {
+    {"lynx_print",          [](Slot *args) { lynx_print(static_cast<const char *>(args[0].p)); }},
+    {"lynx_println",        [](Slot *args) { lynx_println(static_cast<const char *>(args[0].p)); }},
+    {"lynx_print_int",      [](Slot *args) { lynx_print_int(args[0].i); }},
+    {"lynx_print_float",    [](Slot *args) { lynx_print_float(args[0].f); }},
+    {"lynx_flush",          [](Slot *) { lynx_flush(); }},
+};
+
+// frames start at 16-byte boundaries, enough for every type
+static constexpr uint64_t alignFrame(uint64_t size) { return (size + 15) & ~uint64_t(15); }
+
+// fptosi is poison out of range, the interpreter saturates instead
+static int64_t toInteger(double value) {
+    if (std::isnan(value))
+        return 0;
+    if (value <= -0x1p63)
+        return INT64_MIN;
+    if (value >= 0x1p63)
+        return INT64_MAX;
+
+    return static_cast<int64_t>(value);
+}
+
+VM::VM(Program::Ptr program, size_t registers, size_t memory)
+: program(std::move(program)), stack(registers), memory(std::make_unique_for_overwrite<uint8_t[]>(memory)),
+  memorySize(memory), threshold(0) {}
+
+void VM::setTier(Tier tier, uint64_t threshold) {
+    this->tier = std::move(tier);
+    this->threshold = threshold;
+}
+
+int64_t VM::run() {
+    globals = program->globals;
+
+    if (program->initializer)
+        execute(*program->initializer);
+
+    if (!program->main)
+        return 0;
+
+    const Slot result = execute(*program->main);
+    return program->exitCode ? result.i : 0;
+}
+
+std::optional<uint32_t> VM::findNative(const std::string &linkName) {
+    for (uint32_t i = 0; i < std::size(NATIVES); ++i)
+        if (linkName == NATIVES[i].linkName)
+            return i;
+
+    return std::nullopt;
+}
+
+void VM::trap(const BytecodeFunction &function, const std::string &message) const {
+    throw Trap(message + " in " + function.name);
+}
+
+Slot VM::execute(uint32_t entry) {
+    struct Frame {
+        BytecodeFunction *function;
+        const Instruction *ip; // where the caller continues
+        Slot *registers;
+        uint8_t *memory;
+    };
+
+    std::vector<BytecodeFunction> &functions = program->functions;
+    std::vector<Frame> frames = {};
+    const Slot *const stackEnd = stack.data() + stack.size();
+    const uint8_t *const memoryEnd = memory.get() + memorySize;
+    uint8_t *const G = globals.data();
+
+    BytecodeFunction *function = &functions[entry];
+    if (function->registers > stack.size() || function->memory > memorySize)
+        trap(*function, "stack overflow");
+
+    Slot *R = stack.data();
+    uint8_t *M = memory.get();
+    std::memset(M, 0, function->memory);
+    const Slot *K = function->constants.data();
+    const Instruction *code = function->code.data();
+    const Instruction *ip = code;
+
+#ifdef LYNX_THREADED_DISPATCH
+    static const void *const labels[] = {
+#define LYNX_OPCODE_LABEL(name) &&op_##name,
+        LYNX_OPCODES(LYNX_OPCODE_LABEL)
+#undef LYNX_OPCODE_LABEL
+    };
+
+#define DISPATCH() goto *labels[static_cast<uint8_t>(ip->op)]
+#define CASE(name) op_##name:
+#else
+#define DISPATCH() continue
+#define CASE(name) case Opcode::name:
+#endif
+#define NEXT() { ++ip; DISPATCH(); }
+#define RETURN() { \
+        if (frames.empty()) \
+            return R[0]; \
+        const Frame frame = frames.back(); \
+        frames.pop_back(); \
+        function = frame.function; \
+        R = frame.registers; \
+        M = frame.memory; \
+        K = function->constants.data(); \
+        code = function->code.data(); \
+        ip = frame.ip; \
+        DISPATCH(); \
+    }
+
+#ifdef LYNX_THREADED_DISPATCH
+    DISPATCH();
+#else
+    for (;;) switch (ip->op) {
+#endif
+
+    CASE(MOVE) R[ip->a] = R[ip->b]; NEXT()
+    CASE(CONST) R[ip->a] = K[ip->wide()]; NEXT()
+
+    // wrap around like the generated code
+    CASE(ADD_I) R[ip->a].i = static_cast<int64_t>(static_cast<uint64_t>(R[ip->b].i) + static_cast<uint64_t>(R[ip->c].i)); NEXT()
+    CASE(SUB_I) R[ip->a].i = static_cast<int64_t>(static_cast<uint64_t>(R[ip->b].i) - static_cast<uint64_t>(R[ip->c].i)); NEXT()
+    CASE(MUL_I) R[ip->a].i = static_cast<int64_t>(static_cast<uint64_t>(R[ip->b].i) * static_cast<uint64_t>(R[ip->c].i)); NEXT()
+    CASE(DIV_I) {
+        const int64_t divisor = R[ip->c].i;
+        if (divisor == 0 || (divisor == -1 && R[ip->b].i == INT64_MIN))
+            trap(*function, "division overflow");
+        R[ip->a].i = R[ip->b].i / divisor;
+        NEXT()
+    }
+
+    CASE(ADD_F) R[ip->a].f = R[ip->b].f + R[ip->c].f; NEXT()
+    CASE(SUB_F) R[ip->a].f = R[ip->b].f - R[ip->c].f; NEXT()
+    CASE(MUL_F) R[ip->a].f = R[ip->b].f * R[ip->c].f; NEXT()
+    CASE(DIV_F) R[ip->a].f = R[ip->b].f / R[ip->c].f; NEXT()
+    CASE(POW_F) R[ip->a].f = std::pow(R[ip->b].f, R[ip->c].f); NEXT()
+
+    CASE(LT_I) R[ip->a].i = R[ip->b].i < R[ip->c].i; NEXT()
+    CASE(LTE_I) R[ip->a].i = R[ip->b].i <= R[ip->c].i; NEXT()
+    CASE(EQ_I) R[ip->a].i = R[ip->b].i == R[ip->c].i; NEXT()
+    CASE(NEQ_I) R[ip->a].i = R[ip->b].i != R[ip->c].i; NEXT()
+    CASE(LT_F) R[ip->a].i = R[ip->b].f < R[ip->c].f; NEXT()
+    CASE(LTE_F) R[ip->a].i = R[ip->b].f <= R[ip->c].f; NEXT()
+    CASE(EQ_F) R[ip->a].i = R[ip->b].f == R[ip->c].f; NEXT()
+    CASE(NEQ_F) R[ip->a].i = R[ip->b].f != R[ip->c].f; NEXT()
+
+    CASE(TO_BOOL) R[ip->a].i = R[ip->b].i != 0; NEXT()
+    CASE(TO_U8) R[ip->a].i = static_cast<uint8_t>(R[ip->b].i); NEXT()
+    CASE(TO_I32) R[ip->a].i = static_cast<int32_t>(R[ip->b].i); NEXT()
+    CASE(I2F) R[ip->a].f = static_cast<double>(R[ip->b].i); NEXT()
+    CASE(F2I) R[ip->a].i = toInteger(R[ip->b].f); NEXT()
+
+    CASE(JUMP) {
+        ip = code + ip->wide();
+        DISPATCH();
+    }
+    CASE(JUMP_IF_NOT) {
+        if (R[ip->a].i == 0) {
+            ip = code + ip->wide();
+            DISPATCH();
+        }
+        NEXT()
+    }
+
+    CASE(ADDR_LOCAL) R[ip->a].p = M + ip->wide(); NEXT()
+    CASE(ADDR_GLOBAL) R[ip->a].p = G + ip->wide(); NEXT()
+
+    CASE(LOAD8) R[ip->a].i = *static_cast<const uint8_t *>(R[ip->b].p); NEXT()
+    CASE(LOAD32) {
+        int32_t value;
+        std::memcpy(&value, R[ip->b].p, sizeof(value));
+        R[ip->a].i = value;
+        NEXT()
+    }
+    CASE(LOAD64) std::memcpy(&R[ip->a], R[ip->b].p, sizeof(Slot)); NEXT()
+    CASE(STORE8) *static_cast<uint8_t *>(R[ip->a].p) = static_cast<uint8_t>(R[ip->b].i); NEXT()
+    CASE(STORE32) {
+        const auto value = static_cast<int32_t>(R[ip->b].i);
+        std::memcpy(R[ip->a].p, &value, sizeof(value));
+        NEXT()
+    }
+    CASE(STORE64) std::memcpy(R[ip->a].p, &R[ip->b], sizeof(Slot)); NEXT()
+    CASE(COPY) std::memmove(R[ip->a].p, R[ip->b].p, K[ip->c].i); NEXT()
+
+    CASE(OFFSET) R[ip->a].p = static_cast<uint8_t *>(R[ip->a].p) + ip->wide(); NEXT()
+    CASE(INDEX) R[ip->a].p = static_cast<uint8_t *>(R[ip->a].p) + R[ip->b].i * K[ip->c].i; NEXT()
+    CASE(CHECK) {
+        if (static_cast<uint64_t>(R[ip->a].i) >= ip->wide())
+            trap(*function, "index " + std::to_string(R[ip->a].i) + " out of bounds for length " + std::to_string(ip->wide()));
+        NEXT()
+    }
+
+    CASE(CALL) {
+        BytecodeFunction &callee = functions[ip->wide()];
+        Slot *const base = R + ip->a;
+
+        if (!callee.native && callee.jittable && tier && ++callee.calls == threshold)
+            callee.native = tier(callee);
+
+        if (callee.native) {
+            callee.native(base);
+            NEXT()
+        }
+
+        uint8_t *const next = M + alignFrame(function->memory);
+        if (base + callee.registers > stackEnd || next + callee.memory > memoryEnd)
+            trap(callee, "stack overflow");
+
+        std::memset(next, 0, callee.memory);
+        frames.push_back({function, ip + 1, R, M});
+
+        function = &callee;
+        R = base;
+        M = next;
+        K = callee.constants.data();
+        code = callee.code.data();
+        ip = code;
+        DISPATCH();
+    }
+    CASE(NATIVE) NATIVES[ip->wide()].entry(R + ip->a); NEXT()
+
+    // the callee's first register is the caller's register of the call, the result replaces the first argument
+    CASE(RET) R[0] = R[ip->a]; RETURN()
+    CASE(RET_VOID) RETURN()
+
+#ifndef LYNX_THREADED_DISPATCH
+    }
+#endif
+
+#undef RETURN
+#undef NEXT
+#undef CASE
+#undef DISPATCH
+}
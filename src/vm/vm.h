@@ -0,0 +1,44 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <stdexcept>
+
+#include "bytecode.h"
+
+// runtime error of an interpreted program, e.g. an index out of bounds where compiled code would trap
+class Trap : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// interpreter for the bytecode of a program, the frames of all calls share one register stack
+// and one stack for the memory of their locals
+class VM {
+public:
+    // compiles a function that got hot to native code, returns null to keep interpreting it
+    using Tier = std::function<NativeEntry(const BytecodeFunction &function)>;
+
+    explicit VM(Program::Ptr program, size_t registers = 1 << 20, size_t memory = 64 << 20);
+
+    // jittable functions are handed to the tier on their threshold-th call, 0 never does
+    void setTier(Tier tier, uint64_t threshold);
+
+    // initialize the globals and run main, returns what main returned if it's an integer, 0 otherwise
+    int64_t run();
+
+    // index of a runtime function callable with NATIVE by its link name
+    static std::optional<uint32_t> findNative(const std::string &linkName);
+
+private:
+    Slot execute(uint32_t entry);
+    [[noreturn]] void trap(const BytecodeFunction &function, const std::string &message) const;
+
+    Program::Ptr program;
+    std::vector<Slot> stack;
+    std::unique_ptr<uint8_t[]> memory;
+    size_t memorySize;
+    std::vector<uint8_t> globals;
+    Tier tier;
+    uint64_t threshold;
+};